@@ -0,0 +1,697 @@
+/*
+ * DSP and Decode Microbenchmark Suite
+ * Times every hot path of the receive chain on synthetic input
+ *
+ * Each case is warmed up, calibrated so one repetition takes about the
+ * requested time, then repeated; the median repetition is reported (the
+ * fastest is kept alongside for noisy machines). Cycles come from the CPU
+ * cycle counter via perf_event_open, or the TSC on x86 when perf events are
+ * not permitted, and are omitted otherwise.
+ *
+ * Each DSP path then runs as a whole channel would - demodulate one SDR
+ * buffer and search it for a burst - and the throughput is reported as the
+ * number of 2.4 Msps channels one core keeps up with.
+ *
+ * Usage: tetra_bench [--reps N] [--time-ms MS] [--warmup-ms MS]
+ *                    [--filter TEXT] [--json FILE|-]
+ */
+
+#include "tetra_analyzer.h"
+#include <getopt.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef TETRA_BUILD_TYPE
+#define TETRA_BUILD_TYPE "unknown"
+#endif
+
+#define BENCH_MAX_REPS 101
+#define BENCH_IQ_PAIRS (SDR_BUFFER_SIZE / 2)   // One SDR buffer
+#define BENCH_CTRL_PDUS 64
+#define BENCH_RING_BLOCK TETRA_CODEC_SAMPLES
+
+typedef enum {
+    CYCLES_NONE,
+    CYCLES_PERF,
+    CYCLES_TSC
+} cycle_source_t;
+
+typedef struct {
+    const char *name;
+    const char *unit;                  // What items_per_op counts
+    uint64_t items_per_op;
+    void (*run)(uint64_t iterations);
+} bench_case_t;
+
+typedef struct {
+    double ns_per_op;                  // Median repetition
+    double ns_per_op_min;              // Fastest repetition
+    double cycles_per_op;              // Median, < 0 when unavailable
+    double items_per_sec;
+    uint64_t iterations;               // Per repetition
+} bench_result_t;
+
+// Shared inputs, built once
+static uint8_t *g_iq;
+static float *g_i;
+static float *g_q;
+static float *g_out;
+static cf32_t *g_cf;
+static ci16_t *g_ci;
+static int16_t *g_q15;
+static cf32_t *g_chain[2];             // Channel filter stage outputs
+static ci16_t *g_chain_q15[2];
+static tetra_demod_t *g_demod;                 // Float path
+static tetra_demod_t *g_demod_q15;
+static tetra_codec_t *g_codec;
+static audio_ring_t *g_ring;
+static uint8_t g_ctrl_bits[BENCH_CTRL_PDUS][64];
+static uint8_t g_frame[TETRA_CODEC_FRAME_BYTES];
+static int16_t g_pcm[BENCH_RING_BLOCK];
+static int8_t g_soft[LMAC_MAX_TYPE3_BITS * VITERBI_CODE_RATE];
+static uint8_t g_decoded[LMAC_MAX_TYPE3_BITS];
+static uint8_t g_bits[TETRA_BURST_LENGTH];
+static uint8_t g_matches[TETRA_BURST_LENGTH];
+
+// Results land here so the compiler cannot discard the work
+static volatile float g_sink_f;
+static volatile int g_sink_i;
+
+static int g_perf_fd = -1;
+static cycle_source_t g_cycle_source = CYCLES_NONE;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void cycles_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    g_perf_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (g_perf_fd >= 0) {
+        ioctl(g_perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+        g_cycle_source = CYCLES_PERF;
+        return;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    g_cycle_source = CYCLES_TSC;
+#endif
+}
+
+static uint64_t cycles_now(void) {
+    if (g_cycle_source == CYCLES_PERF) {
+        uint64_t count = 0;
+        if (read(g_perf_fd, &count, sizeof(count)) != sizeof(count)) return 0;
+        return count;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    if (g_cycle_source == CYCLES_TSC) return __rdtsc();
+#endif
+    return 0;
+}
+
+static const char* cycle_source_name(void) {
+    switch (g_cycle_source) {
+        case CYCLES_PERF: return "perf";
+        case CYCLES_TSC:  return "tsc";
+        default:          return "none";
+    }
+}
+
+// Benchmark bodies
+
+static void run_convert(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        convert_uint8_to_float(g_iq, g_out, BENCH_IQ_PAIRS * 2);
+    }
+    g_sink_f = g_out[7];
+}
+
+static void run_quadrature(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        quadrature_demod(g_i, g_q, g_out, BENCH_IQ_PAIRS);
+    }
+    g_sink_f = g_out[7];
+}
+
+static void run_convert_cf32(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        convert_cu8_to_cf32(g_iq, g_cf, BENCH_IQ_PAIRS);
+    }
+    g_sink_f = g_cf[7].re;
+}
+
+static void run_quadrature_cf32(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        quadrature_demod_cf32(g_cf, g_out, BENCH_IQ_PAIRS);
+    }
+    g_sink_f = g_out[7];
+}
+
+static void run_convert_ci16(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        convert_cu8_to_ci16(g_iq, g_ci, BENCH_IQ_PAIRS);
+    }
+    g_sink_i = g_ci[7].re;
+}
+
+static void run_quadrature_ci16(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        quadrature_demod_ci16(g_ci, g_q15, BENCH_IQ_PAIRS);
+    }
+    g_sink_i = g_q15[7];
+}
+
+static void run_lowpass_q15(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        low_pass_filter_q15(g_q15, BENCH_IQ_PAIRS, 16384);
+    }
+    g_sink_i = g_q15[7];
+}
+
+static void run_lowpass(uint64_t n) {
+    for (uint64_t k = 0; k < n; k++) {
+        low_pass_filter(g_out, BENCH_IQ_PAIRS, 0.5f);
+    }
+    g_sink_f = g_out[7];
+}
+
+static void run_strength(uint64_t n) {
+    float acc = 0.0f;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += detect_signal_strength(g_i, g_q, BENCH_IQ_PAIRS);
+    }
+    g_sink_f = acc;
+}
+
+static void run_strength_cu8(uint64_t n) {
+    float acc = 0.0f;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += detect_signal_strength_cu8(g_iq, BENCH_IQ_PAIRS);
+    }
+    g_sink_f = acc;
+}
+
+// One SDR buffer down to 37.5 ksps and through the matched filter
+static void run_channel_filter(uint64_t n) {
+    const dsp_fir_kernel_t *d16 = dsp_fir_kernel(DSP_FIR_DECIM16);
+    const dsp_fir_kernel_t *d4 = dsp_fir_kernel(DSP_FIR_DECIM4);
+    const dsp_fir_kernel_t *rrc = dsp_fir_kernel(DSP_FIR_RRC035);
+    uint32_t n16 = (BENCH_IQ_PAIRS - d16->ntaps) / d16->decim + 1;
+    uint32_t n4 = (n16 - d4->ntaps) / d4->decim + 1;
+    uint32_t nrrc = n4 - rrc->ntaps + 1;
+
+    for (uint64_t k = 0; k < n; k++) {
+        fir_decimate_cf32(d16->taps, d16->ntaps, d16->decim, g_cf, g_chain[0], n16);
+        fir_decimate_cf32(d4->taps, d4->ntaps, d4->decim, g_chain[0], g_chain[1], n4);
+        fir_decimate_cf32(rrc->taps, rrc->ntaps, rrc->decim, g_chain[1], g_chain[0], nrrc);
+    }
+    g_sink_f = g_chain[0][7].re;
+}
+
+static void run_channel_filter_q15(uint64_t n) {
+    const dsp_fir_kernel_t *d16 = dsp_fir_kernel(DSP_FIR_DECIM16);
+    const dsp_fir_kernel_t *d4 = dsp_fir_kernel(DSP_FIR_DECIM4);
+    const dsp_fir_kernel_t *rrc = dsp_fir_kernel(DSP_FIR_RRC035);
+    uint32_t n16 = (BENCH_IQ_PAIRS - d16->ntaps) / d16->decim + 1;
+    uint32_t n4 = (n16 - d4->ntaps) / d4->decim + 1;
+    uint32_t nrrc = n4 - rrc->ntaps + 1;
+
+    for (uint64_t k = 0; k < n; k++) {
+        fir_decimate_ci16(d16->taps_q15, d16->ntaps, d16->decim, g_ci, g_chain_q15[0], n16);
+        fir_decimate_ci16(d4->taps_q15, d4->ntaps, d4->decim, g_chain_q15[0], g_chain_q15[1], n4);
+        fir_decimate_ci16(rrc->taps_q15, rrc->ntaps, rrc->decim, g_chain_q15[1], g_chain_q15[0], nrrc);
+    }
+    g_sink_i = g_chain_q15[0][7].re;
+}
+
+static void run_correlate(uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += (int)correlate_bits(g_bits, TETRA_BURST_LENGTH, TETRA_TRAINING_SEQ,
+                                   TETRA_TRAINING_SEQ_BITS, g_matches);
+    }
+    g_sink_i = acc + g_matches[7];
+}
+
+static void run_demod(uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += tetra_demod_process(g_demod, g_iq, SDR_BUFFER_SIZE);
+    }
+    g_sink_i = acc;
+}
+
+static void run_demod_q15(uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += tetra_demod_process(g_demod_q15, g_iq, SDR_BUFFER_SIZE);
+    }
+    g_sink_i = acc;
+}
+
+// One channel's work per SDR buffer on each DSP path
+static void run_channel(tetra_demod_t *demod, uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += tetra_demod_process(demod, g_iq, SDR_BUFFER_SIZE);
+        acc += tetra_detect_burst(demod);
+    }
+    g_sink_i = acc;
+}
+
+static void run_channel_float(uint64_t n) {
+    run_channel(g_demod, n);
+}
+
+static void run_channel_q15(uint64_t n) {
+    run_channel(g_demod_q15, n);
+}
+
+static void run_detect(uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += tetra_detect_burst(g_demod);
+    }
+    g_sink_i = acc;
+}
+
+static void run_control(uint64_t n) {
+    int acc = 0;
+    ctrl_message_t msg;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += decode_control_channel_data(g_ctrl_bits[k % BENCH_CTRL_PDUS], 64, &msg);
+    }
+    g_sink_i = acc;
+}
+
+static void run_codec(uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += tetra_codec_decode_frame(g_codec, g_frame, g_pcm);
+    }
+    g_sink_i = acc;
+}
+
+static void run_ring(uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += audio_ring_write(g_ring, g_pcm, BENCH_RING_BLOCK);
+        acc += audio_ring_read(g_ring, g_pcm, BENCH_RING_BLOCK);
+    }
+    g_sink_i = acc;
+}
+
+// One recorded trace event: two cycle counter reads and a ring store
+static void run_trace(uint64_t n) {
+    trace_set_enabled(true);
+    for (uint64_t k = 0; k < n; k++) {
+        uint64_t start = TRACE_BEGIN();
+        TRACE_END(start, "bench", "event", "k", k, NULL, 0, NULL, 0);
+    }
+    trace_set_enabled(false);
+}
+
+static void run_viterbi(uint64_t n) {
+    int acc = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        acc += viterbi_decode_batch(g_soft, LMAC_MAX_TYPE3_BITS, g_decoded, 1);
+    }
+    g_sink_i = acc;
+}
+
+static const bench_case_t CASES[] = {
+    { "convert_uint8_to_float",      "samples", BENCH_IQ_PAIRS * 2, run_convert },
+    { "quadrature_demod",            "samples", BENCH_IQ_PAIRS, run_quadrature },
+    { "convert_cu8_to_cf32",         "samples", BENCH_IQ_PAIRS, run_convert_cf32 },
+    { "quadrature_demod_cf32",       "samples", BENCH_IQ_PAIRS, run_quadrature_cf32 },
+    { "convert_cu8_to_ci16",         "samples", BENCH_IQ_PAIRS, run_convert_ci16 },
+    { "quadrature_demod_ci16",       "samples", BENCH_IQ_PAIRS, run_quadrature_ci16 },
+    { "low_pass_filter",             "samples", BENCH_IQ_PAIRS, run_lowpass },
+    { "low_pass_filter_q15",         "samples", BENCH_IQ_PAIRS, run_lowpass_q15 },
+    { "detect_signal_strength",      "samples", BENCH_IQ_PAIRS, run_strength },
+    { "detect_signal_strength_cu8",  "samples", BENCH_IQ_PAIRS, run_strength_cu8 },
+    { "channel_filter_chain",        "samples", BENCH_IQ_PAIRS, run_channel_filter },
+    { "channel_filter_chain_q15",    "samples", BENCH_IQ_PAIRS, run_channel_filter_q15 },
+    { "correlate_bits",              "bits",    TETRA_BURST_LENGTH, run_correlate },
+    { "tetra_demod_process",         "samples", BENCH_IQ_PAIRS, run_demod },
+    { "tetra_demod_process_q15",     "samples", BENCH_IQ_PAIRS, run_demod_q15 },
+    { "tetra_detect_burst",          "bits",    TETRA_BURST_LENGTH, run_detect },
+    { "decode_control_channel_data", "pdus",    1, run_control },
+    { "tetra_codec_decode_frame",    "samples", TETRA_CODEC_SAMPLES, run_codec },
+    { "audio_ring_write_read",       "samples", BENCH_RING_BLOCK, run_ring },
+    { "viterbi_decode",              "bits",    LMAC_MAX_TYPE3_BITS, run_viterbi },
+    { "trace_event",                 "events",  1, run_trace },
+};
+
+#define CASE_COUNT (int)(sizeof(CASES) / sizeof(CASES[0]))
+
+// Demodulate and burst-search one buffer per op; samples/s over the sample
+// rate is how many channels one core sustains
+static const bench_case_t CHANNEL_CASES[DSP_PATH_COUNT] = {
+    { "channels_float", "samples", BENCH_IQ_PAIRS, run_channel_float },
+    { "channels_q15",   "samples", BENCH_IQ_PAIRS, run_channel_q15 },
+};
+
+// TETRA-like input: a pi/4-DQPSK style phase walk at a symbol rate, plus noise
+static int setup(void) {
+    g_iq = malloc(SDR_BUFFER_SIZE);
+    g_i = malloc(BENCH_IQ_PAIRS * sizeof(float));
+    g_q = malloc(BENCH_IQ_PAIRS * sizeof(float));
+    g_out = malloc(BENCH_IQ_PAIRS * 2 * sizeof(float));
+    g_cf = cf32_alloc(RT_POOL_DEMOD, BENCH_IQ_PAIRS);
+    g_ci = ci16_alloc(RT_POOL_DEMOD, BENCH_IQ_PAIRS);
+    g_q15 = rt_alloc(RT_POOL_DEMOD, BENCH_IQ_PAIRS * sizeof(int16_t));
+    g_chain[0] = cf32_alloc(RT_POOL_DEMOD, BENCH_IQ_PAIRS / 16 + 1);
+    g_chain[1] = cf32_alloc(RT_POOL_DEMOD, BENCH_IQ_PAIRS / 64 + 1);
+    g_chain_q15[0] = ci16_alloc(RT_POOL_DEMOD, BENCH_IQ_PAIRS / 16 + 1);
+    g_chain_q15[1] = ci16_alloc(RT_POOL_DEMOD, BENCH_IQ_PAIRS / 64 + 1);
+    if (!g_iq || !g_i || !g_q || !g_out || !g_cf || !g_ci || !g_q15 || !g_chain[0] || !g_chain[1] ||
+        !g_chain_q15[0] || !g_chain_q15[1]) {
+        return -1;
+    }
+
+    srand(1);
+    int phase = 0;
+    for (uint32_t n = 0; n < BENCH_IQ_PAIRS; n++) {
+        if (n % (TETRA_SAMPLE_RATE / TETRA_SYMBOL_RATE) == 0) {
+            phase = (phase + 1 + 2 * (rand() & 3)) & 7;
+        }
+        static const float C[8] = { 1.0f, 0.7071f, 0.0f, -0.7071f, -1.0f, -0.7071f, 0.0f, 0.7071f };
+        float i = 60.0f * C[phase] + (float)(rand() % 9 - 4);
+        float q = 60.0f * C[(phase + 6) & 7] + (float)(rand() % 9 - 4);
+        g_iq[2 * n] = (uint8_t)(127.5f + i);
+        g_iq[2 * n + 1] = (uint8_t)(127.5f + q);
+        g_i[n] = i;
+        g_q[n] = q;
+    }
+    convert_cu8_to_cf32(g_iq, g_cf, BENCH_IQ_PAIRS);
+    convert_cu8_to_ci16(g_iq, g_ci, BENCH_IQ_PAIRS);
+
+    // One demodulator per DSP path, whatever this build defaults to
+    dsp_path_t path = dsp_get_path();
+    dsp_set_path(DSP_PATH_FLOAT);
+    g_demod = tetra_demod_init(TETRA_SAMPLE_RATE, NULL, NULL, 15.0f);
+    dsp_set_path(DSP_PATH_Q15);
+    g_demod_q15 = tetra_demod_init(TETRA_SAMPLE_RATE, NULL, NULL, 15.0f);
+    dsp_set_path(path);
+    g_codec = tetra_codec_init();
+    g_ring = audio_ring_create(4096);
+    if (!g_demod || !g_demod_q15 || !g_codec || !g_ring) return -1;
+    tetra_demod_process(g_demod, g_iq, SDR_BUFFER_SIZE);
+    tetra_demod_process(g_demod_q15, g_iq, SDR_BUFFER_SIZE);
+
+    // Control PDUs the decoder accepts, so the full field extraction path runs
+    ctrl_message_t msg;
+    int found = 0;
+    for (int tries = 0; found < BENCH_CTRL_PDUS && tries < 1000000; tries++) {
+        for (int b = 0; b < 64; b++) {
+            g_ctrl_bits[found][b] = (uint8_t)(rand() & 1);
+        }
+        if (decode_control_channel_data(g_ctrl_bits[found], 64, &msg)) {
+            found++;
+        }
+    }
+    for (; found < BENCH_CTRL_PDUS; found++) {
+        memcpy(g_ctrl_bits[found], g_ctrl_bits[0], 64);
+    }
+
+    for (int b = 0; b < TETRA_CODEC_FRAME_BYTES; b++) {
+        g_frame[b] = (uint8_t)rand();
+    }
+    for (int s = 0; s < BENCH_RING_BLOCK; s++) {
+        g_pcm[s] = (int16_t)(rand() - RAND_MAX / 2);
+    }
+    for (size_t s = 0; s < sizeof(g_soft); s++) {
+        g_soft[s] = (int8_t)(rand() % 255 - 127);
+    }
+    for (int b = 0; b < TETRA_BURST_LENGTH; b++) {
+        g_bits[b] = (uint8_t)(rand() & 1);
+    }
+    return 0;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void measure(const bench_case_t *c, int reps, double time_ms, double warmup_ms,
+                    bench_result_t *r) {
+    // Warm-up, doubling the batch until the warm-up time is spent
+    uint64_t n = 1;
+    uint64_t start = now_ns();
+    uint64_t last = 0;
+    for (;;) {
+        uint64_t t0 = now_ns();
+        c->run(n);
+        last = now_ns() - t0;
+        if (now_ns() - start >= (uint64_t)(warmup_ms * 1e6) && last > 0) break;
+        if (last < (uint64_t)(time_ms * 1e6) / 2) n *= 2;
+    }
+
+    // Calibrate iterations per repetition from the last warm-up batch
+    double per_op = (double)last / (double)n;
+    uint64_t iterations = (uint64_t)(time_ms * 1e6 / (per_op > 0 ? per_op : 1));
+    if (iterations < 1) iterations = 1;
+
+    double ns[BENCH_MAX_REPS];
+    double cyc[BENCH_MAX_REPS];
+    for (int k = 0; k < reps; k++) {
+        uint64_t c0 = cycles_now();
+        uint64_t t0 = now_ns();
+        c->run(iterations);
+        uint64_t t1 = now_ns();
+        uint64_t c1 = cycles_now();
+        ns[k] = (double)(t1 - t0) / (double)iterations;
+        cyc[k] = (double)(c1 - c0) / (double)iterations;
+    }
+
+    qsort(ns, (size_t)reps, sizeof(double), compare_double);
+    qsort(cyc, (size_t)reps, sizeof(double), compare_double);
+
+    r->iterations = iterations;
+    r->ns_per_op = ns[reps / 2];
+    r->ns_per_op_min = ns[0];
+    r->cycles_per_op = g_cycle_source == CYCLES_NONE ? -1.0 : cyc[reps / 2];
+    r->items_per_sec = c->items_per_op * 1e9 / r->ns_per_op;
+}
+
+static void cpu_model(char *out, size_t size) {
+    snprintf(out, size, "unknown");
+
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        // x86 reports "model name", Raspberry Pi kernels "Model"
+        if (strncmp(line, "model name", 10) == 0 || strncmp(line, "Model", 5) == 0) {
+            char *colon = strchr(line, ':');
+            if (!colon) continue;
+            colon++;
+            while (*colon == ' ' || *colon == '\t') colon++;
+            colon[strcspn(colon, "\n")] = '\0';
+            snprintf(out, size, "%s", colon);
+            if (line[0] == 'M') break;  // Board name beats the core name
+        }
+    }
+    fclose(f);
+}
+
+static void json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [--reps N] [--time-ms MS] [--warmup-ms MS] [--filter TEXT] [--json FILE|-]\n",
+           prog);
+}
+
+int main(int argc, char **argv) {
+    int reps = 11;
+    double time_ms = 100.0;
+    double warmup_ms = 200.0;
+    const char *filter = NULL;
+    const char *json_path = NULL;
+
+    static struct option long_options[] = {
+        {"reps", required_argument, 0, 'r'},
+        {"time-ms", required_argument, 0, 't'},
+        {"warmup-ms", required_argument, 0, 'w'},
+        {"filter", required_argument, 0, 'f'},
+        {"json", required_argument, 0, 'j'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:t:w:f:j:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'r': reps = atoi(optarg); break;
+            case 't': time_ms = atof(optarg); break;
+            case 'w': warmup_ms = atof(optarg); break;
+            case 'f': filter = optarg; break;
+            case 'j': json_path = optarg; break;
+            case 'h': usage(argv[0]); return 0;
+            default:  usage(argv[0]); return 1;
+        }
+    }
+    if (reps < 1) reps = 1;
+    if (reps > BENCH_MAX_REPS) reps = BENCH_MAX_REPS;
+    if (time_ms <= 0.0) time_ms = 100.0;
+    if (warmup_ms < 0.0) warmup_ms = 0.0;
+
+    // Keep initialization chatter out of the results
+    log_set_level(LOG_LEVEL_WARN);
+
+    if (setup() < 0) {
+        fprintf(stderr, "Failed to set up benchmark inputs\n");
+        return 1;
+    }
+    cycles_open();
+
+    char cpu[128];
+    struct utsname un;
+    cpu_model(cpu, sizeof(cpu));
+    if (uname(&un) < 0) snprintf(un.machine, sizeof(un.machine), "unknown");
+
+    FILE *json = NULL;
+    if (json_path) {
+        json = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+        if (!json) {
+            fprintf(stderr, "Cannot write %s\n", json_path);
+            return 1;
+        }
+    }
+    FILE *text = json == stdout ? stderr : stdout;
+
+    fprintf(text, "CPU: %s (%s), build %s, cycles from %s\n", cpu, un.machine,
+            TETRA_BUILD_TYPE, cycle_source_name());
+    fprintf(text, "%d repetitions of ~%.0f ms after %.0f ms warm-up; median shown\n\n",
+            reps, time_ms, warmup_ms);
+    fprintf(text, "%-28s %12s %12s %12s %16s\n", "benchmark", "ns/op", "min ns/op",
+            "cycles/op", "items/s");
+
+    if (json) {
+        fprintf(json, "{\n  \"cpu\": ");
+        json_string(json, cpu);
+        fprintf(json, ",\n  \"arch\": ");
+        json_string(json, un.machine);
+        fprintf(json, ",\n  \"compiler\": ");
+        json_string(json, __VERSION__);
+        fprintf(json, ",\n  \"build_type\": ");
+        json_string(json, TETRA_BUILD_TYPE);
+        fprintf(json, ",\n  \"viterbi\": ");
+        json_string(json, viterbi_impl_name(viterbi_get_impl()));
+        fprintf(json, ",\n  \"cycle_source\": ");
+        json_string(json, cycle_source_name());
+        fprintf(json, ",\n  \"repetitions\": %d,\n  \"results\": [", reps);
+    }
+
+    bool first = true;
+    for (int i = 0; i < CASE_COUNT; i++) {
+        const bench_case_t *c = &CASES[i];
+        if (filter && !strstr(c->name, filter)) continue;
+
+        bench_result_t r;
+        measure(c, reps, time_ms, warmup_ms, &r);
+
+        char cycles[32];
+        if (r.cycles_per_op >= 0) {
+            snprintf(cycles, sizeof(cycles), "%.0f", r.cycles_per_op);
+        } else {
+            snprintf(cycles, sizeof(cycles), "-");
+        }
+        fprintf(text, "%-28s %12.1f %12.1f %12s %12.3e %-7s\n", c->name, r.ns_per_op,
+                r.ns_per_op_min, cycles, r.items_per_sec, c->unit);
+
+        if (json) {
+            fprintf(json, "%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"items_per_op\": %llu, "
+                    "\"iterations\": %llu, \"ns_per_op\": %.3f, \"ns_per_op_min\": %.3f, ",
+                    first ? "" : ",", c->name, c->unit, (unsigned long long)c->items_per_op,
+                    (unsigned long long)r.iterations, r.ns_per_op, r.ns_per_op_min);
+            if (r.cycles_per_op >= 0) {
+                fprintf(json, "\"cycles_per_op\": %.1f, ", r.cycles_per_op);
+            } else {
+                fprintf(json, "\"cycles_per_op\": null, ");
+            }
+            fprintf(json, "\"items_per_sec\": %.1f}", r.items_per_sec);
+        }
+        first = false;
+    }
+
+    if (json) {
+        fprintf(json, "\n  ],\n  \"channels_per_core\": {");
+    }
+
+    first = true;
+    for (int p = 0; p < DSP_PATH_COUNT; p++) {
+        const bench_case_t *c = &CHANNEL_CASES[p];
+        if (filter && !strstr(c->name, filter)) continue;
+
+        if (first) {
+            fprintf(text, "\nChannels per core (demodulate + burst search, %.1f Msps each)\n",
+                    TETRA_SAMPLE_RATE / 1e6);
+            fprintf(text, "%-28s %12s %12s\n", "DSP path", "us/buffer", "channels");
+        }
+
+        bench_result_t r;
+        measure(c, reps, time_ms, warmup_ms, &r);
+        double channels = r.items_per_sec / TETRA_SAMPLE_RATE;
+        fprintf(text, "%-28s %12.1f %12.1f\n", dsp_path_name((dsp_path_t)p), r.ns_per_op / 1e3, channels);
+
+        if (json) {
+            fprintf(json, "%s\n    \"%s\": %.2f", first ? "" : ",", dsp_path_name((dsp_path_t)p), channels);
+        }
+        first = false;
+    }
+
+    if (json) {
+        fprintf(json, "\n  }\n}\n");
+        if (json != stdout) fclose(json);
+    }
+
+    if (g_perf_fd >= 0) close(g_perf_fd);
+    audio_ring_destroy(g_ring);
+    tetra_codec_cleanup(g_codec);
+    tetra_demod_cleanup(g_demod);
+    tetra_demod_cleanup(g_demod_q15);
+    free(g_iq);
+    free(g_i);
+    free(g_q);
+    free(g_out);
+    dsp_free(g_cf);
+    dsp_free(g_chain[0]);
+    dsp_free(g_chain[1]);
+    dsp_free(g_chain_q15[0]);
+    dsp_free(g_chain_q15[1]);
+    dsp_free(g_ci);
+    rt_free(g_q15);
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Viterbi Decoder Microbenchmark
+ * Reports decoded bits per second for every variant available on this CPU
+ *
+ * Usage: viterbi_bench [seconds-per-variant]
+ */
+
+#include "tetra_analyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_BLOCKS 64
+#define BENCH_STEPS LMAC_MAX_TYPE3_BITS   // SCH/F trellis length
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    if (seconds <= 0.0) seconds = 1.0;
+
+    static int8_t soft[BENCH_BLOCKS * BENCH_STEPS * VITERBI_CODE_RATE];
+    static uint8_t bits[BENCH_BLOCKS * BENCH_STEPS];
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(soft); i++) {
+        soft[i] = (int8_t)(rand() % 255 - 127);
+    }
+
+    printf("Viterbi K=5 rate 1/4, %d-step blocks, batches of %d\n\n", BENCH_STEPS, BENCH_BLOCKS);
+    printf("%-8s %14s %14s\n", "variant", "Mbit/s", "blocks/s");
+
+    for (int impl = VITERBI_IMPL_SCALAR; impl < VITERBI_IMPL_COUNT; impl++) {
+        if (!viterbi_impl_available((viterbi_impl_t)impl)) continue;
+
+        // Warm-up
+        viterbi_decode_batch_impl((viterbi_impl_t)impl, soft, BENCH_STEPS, bits, BENCH_BLOCKS);
+
+        uint64_t start = get_timestamp_us();
+        uint64_t elapsed = 0;
+        uint64_t blocks = 0;
+        do {
+            viterbi_decode_batch_impl((viterbi_impl_t)impl, soft, BENCH_STEPS, bits, BENCH_BLOCKS);
+            blocks += BENCH_BLOCKS;
+            elapsed = get_timestamp_us() - start;
+        } while (elapsed < (uint64_t)(seconds * 1e6));
+
+        double secs = elapsed / 1e6;
+        printf("%-8s %14.2f %14.0f\n", viterbi_impl_name((viterbi_impl_t)impl),
+               blocks * BENCH_STEPS / secs / 1e6, blocks / secs);
+    }
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * DSP Kernel Templates
+ * FIR filters, decimators and a bit correlator specialised at compile time
+ *
+ * Tap counts, decimation ratios and the training sequence length are fixed
+ * once the sample rate is chosen, so here they are template parameters: the
+ * compiler sees constant trip counts, unrolls the tap loop completely and
+ * keeps the accumulators in registers, where a runtime-length loop has to
+ * carry a counter and a generic tail.
+ *
+ * Coefficient tables for the standard configurations are built by constexpr
+ * functions from the same window and pulse formulas a runtime design would
+ * use, so they land in .rodata with nothing computed at startup.
+ *
+ * Header-only, C++14. dsp_kernels.cpp instantiates the configurations the
+ * pipeline uses and exports them to the C sources as dsp_fir_kernel_t.
+ */
+
+#ifndef DSP_KERNELS_HPP
+#define DSP_KERNELS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C" {
+#include "tetra_analyzer.h"
+}
+
+namespace tetra {
+namespace dsp {
+
+// constexpr math (<cmath> is not constexpr); double throughout, rounded to float once
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double cx_sin(double x) {
+    while (x > PI) x -= 2.0 * PI;
+    while (x < -PI) x += 2.0 * PI;
+
+    // Taylor series; on [-pi, pi] the 20th term is below 1e-28
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 20; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cx_cos(double x) {
+    return cx_sin(x + PI / 2.0);
+}
+
+constexpr double cx_sqrt(double x) {
+    if (x <= 0.0) return 0.0;
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; i++) r = 0.5 * (r + x / r);
+    return r;
+}
+
+template <size_t N>
+struct coeff_table {
+    float taps[N];
+
+    constexpr float operator[](size_t i) const { return taps[i]; }
+    static constexpr size_t size() { return N; }
+};
+
+// Hamming-windowed sinc low-pass, cutoff as a fraction of the sample rate,
+// normalised to unity gain at DC
+template <size_t N>
+constexpr coeff_table<N> lowpass(double cutoff) {
+    static_assert(N >= 2, "a low-pass needs at least two taps");
+
+    double h[N] = {};
+    double sum = 0.0;
+    for (size_t i = 0; i < N; i++) {
+        double m = (double)i - (double)(N - 1) / 2.0;
+        double sinc = m == 0.0 ? 2.0 * cutoff : cx_sin(2.0 * PI * cutoff * m) / (PI * m);
+        double window = 0.54 - 0.46 * cx_cos(2.0 * PI * (double)i / (double)(N - 1));
+        h[i] = sinc * window;
+        sum += h[i];
+    }
+
+    coeff_table<N> t = {};
+    for (size_t i = 0; i < N; i++) t.taps[i] = (float)(h[i] / sum);
+    return t;
+}
+
+// Root raised cosine pulse with roll-off alpha at sps samples per symbol,
+// normalised to unity gain at DC
+template <size_t N>
+constexpr coeff_table<N> rrc(double alpha, double sps) {
+    double h[N] = {};
+    double sum = 0.0;
+    for (size_t i = 0; i < N; i++) {
+        double t = ((double)i - (double)(N - 1) / 2.0) / sps;      // In symbol periods
+        double d = 4.0 * alpha * t;
+        if (t == 0.0) {
+            h[i] = 1.0 - alpha + 4.0 * alpha / PI;
+        } else if (d * d > 1.0 - 1e-9 && d * d < 1.0 + 1e-9) {
+            // t = +-1/(4 alpha): the general form is 0/0 here
+            h[i] = alpha / cx_sqrt(2.0) * ((1.0 + 2.0 / PI) * cx_sin(PI / (4.0 * alpha)) +
+                                           (1.0 - 2.0 / PI) * cx_cos(PI / (4.0 * alpha)));
+        } else {
+            h[i] = (cx_sin(PI * t * (1.0 - alpha)) + d * cx_cos(PI * t * (1.0 + alpha))) /
+                   (PI * t * (1.0 - d * d));
+        }
+        sum += h[i];
+    }
+
+    coeff_table<N> t = {};
+    for (size_t i = 0; i < N; i++) t.taps[i] = (float)(h[i] / sum);
+    return t;
+}
+
+// A design rounded to Q15 for the fixed-point path; DC gain stays within a
+// few LSB of unity, and the sum of |taps| below 2 keeps 32-bit sums in range
+template <size_t N>
+struct coeff_table_q15 {
+    int16_t taps[N];
+};
+
+template <size_t N>
+constexpr coeff_table_q15<N> to_q15(const coeff_table<N> &t) {
+    coeff_table_q15<N> q = {};
+    for (size_t i = 0; i < N; i++) {
+        double v = (double)t.taps[i] * 32768.0;
+        v = v < 0.0 ? v - 0.5 : v + 0.5;
+        if (v > 32767.0) v = 32767.0;
+        if (v < -32768.0) v = -32768.0;
+        q.taps[i] = (int16_t)v;
+    }
+    return q;
+}
+
+// Floats per sample: real taps filter each component of a sample alike
+template <typename T> struct components;
+template <> struct components<float> { static constexpr size_t value = 1; };
+template <> struct components<cf32_t> { static constexpr size_t value = 2; };
+
+// out[k] = sum of taps[j] * in[k * Decim + j]: `in` holds the Taps - 1 samples
+// of history followed by the new ones, (out_count - 1) * Decim + Taps in all.
+// The designs above are symmetric, so this is also their convolution.
+//
+// Each output is a float dot product of Taps * components length against the
+// taps repeated per component, accumulated in Lanes independent sums: with the
+// length known the whole product is straight-line vector multiply-adds with
+// no loop-carried dependency longer than Lanes / vector width
+template <size_t Taps, size_t Decim, typename T>
+inline void fir_decimate(const float *taps, const T *in, T *out, size_t out_count) {
+    static_assert(Taps > 0 && Decim > 0, "empty filter");
+    constexpr size_t C = components<T>::value;
+    constexpr size_t Len = Taps * C;
+    constexpr size_t Lanes = 8;                  // Two SSE/NEON registers, one AVX
+    constexpr size_t Body = Len / Lanes * Lanes;
+
+    alignas(DSP_ALIGN) float t[Len];
+    for (size_t j = 0; j < Len; j++) t[j] = taps[j / C];
+
+    for (size_t k = 0; k < out_count; k++) {
+        const float *x = reinterpret_cast<const float *>(in + k * Decim);
+        float acc[Lanes] = {};
+        for (size_t j = 0; j < Body; j += Lanes) {
+            for (size_t l = 0; l < Lanes; l++) acc[l] += t[j + l] * x[j + l];
+        }
+        // Lanes is a multiple of C, so lane l always holds component l % C
+        for (size_t j = Body; j < Len; j++) acc[j - Body] += t[j] * x[j];
+
+        float *o = reinterpret_cast<float *>(out + k);
+        for (size_t c = 0; c < C; c++) {
+            float sum = 0.0f;
+            for (size_t l = c; l < Lanes; l += C) sum += acc[l];
+            o[c] = sum;
+        }
+    }
+}
+
+// The same on Q15 samples with Q15 taps, rounded back to Q15 with saturation.
+// Each component is its own 32-bit dot product over the interleaved samples,
+// against the taps with zeros at the other component's positions: that is
+// the shape that maps onto pmaddwd (SSE2) and vmlal (NEON), where separate
+// lane sums would need 16-to-32-bit widening the baseline SIMD lacks
+template <size_t Taps, size_t Decim>
+inline void fir_decimate_q15(const int16_t *taps, const ci16_t *in, ci16_t *out, size_t out_count) {
+    static_assert(Taps > 0 && Decim > 0, "empty filter");
+    constexpr size_t Len = Taps * 2;
+
+    alignas(DSP_ALIGN) int16_t t_re[Len];
+    alignas(DSP_ALIGN) int16_t t_im[Len];
+    for (size_t j = 0; j < Len; j++) {
+        t_re[j] = j % 2 ? 0 : taps[j / 2];
+        t_im[j] = j % 2 ? taps[j / 2] : 0;
+    }
+
+    for (size_t k = 0; k < out_count; k++) {
+        const int16_t *x = reinterpret_cast<const int16_t *>(in + k * Decim);
+        int32_t re = 0;
+        int32_t im = 0;
+        for (size_t j = 0; j < Len; j++) {
+            re += (int32_t)t_re[j] * x[j];
+            im += (int32_t)t_im[j] * x[j];
+        }
+
+        re = (re + 0x4000) >> 15;
+        im = (im + 0x4000) >> 15;
+        out[k].re = (int16_t)(re > 32767 ? 32767 : re < -32768 ? -32768 : re);
+        out[k].im = (int16_t)(im > 32767 ? 32767 : im < -32768 ? -32768 : im);
+    }
+}
+
+template <size_t Taps, typename T>
+inline void fir(const float *taps, const T *in, T *out, size_t out_count) {
+    fir_decimate<Taps, 1>(taps, in, out, out_count);
+}
+
+// First bit in the most significant position, as the correlator shifts them in
+inline uint64_t pack_bits(const uint8_t *bits, unsigned n) {
+    uint64_t packed = 0;
+    for (unsigned i = 0; i < n; i++) packed = packed << 1 | (bits[i] & 1);
+    return packed;
+}
+
+// matches[o] = how many of bits[o .. o + N - 1] equal the N-bit pattern, for
+// every offset o = 0 .. count - N. A shift register and one XOR/popcount per
+// offset instead of N compares
+template <unsigned N>
+inline void correlate_bits(const uint8_t *bits, size_t count, uint64_t pattern, uint8_t *matches) {
+    static_assert(N > 0 && N <= 64, "pattern must fit a 64-bit register");
+    constexpr uint64_t mask = N == 64 ? ~0ULL : (1ULL << N) - 1;
+
+    if (count < N) return;
+
+    uint64_t window = 0;
+    for (size_t i = 0; i < N - 1; i++) window = window << 1 | (bits[i] & 1);
+    for (size_t i = N - 1; i < count; i++) {
+        window = (window << 1 | (bits[i] & 1)) & mask;
+        matches[i - (N - 1)] = (uint8_t)(N - (unsigned)__builtin_popcountll(window ^ pattern));
+    }
+}
+
+} // namespace dsp
+} // namespace tetra
+
+#endif // DSP_KERNELS_HPP
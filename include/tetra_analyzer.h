@@ -4,7 +4,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <pthread.h>
+#ifndef __cplusplus
+#include <stdatomic.h>
+#endif
+
+// Fields shared between C threads; the C++ GUI never touches them
+#ifdef __cplusplus
+#define TETRA_ATOMIC(T) T
+#else
+#define TETRA_ATOMIC(T) _Atomic(T)
+#endif
 
 // Version information
 #define TETRA_ANALYZER_VERSION "1.0.0-educational"
@@ -15,6 +26,7 @@
 #define TETRA_SAMPLE_RATE 2400000      // 2.4 MHz (optimized for low resources)
 #define TETRA_SYMBOL_RATE 18000        // 18 kHz
 #define TETRA_BURST_LENGTH 510         // symbols per burst
+#define TETRA_TRAINING_SEQ_BITS 22     // bits in the burst training sequence
 
 // TEA1 constants
 #define TEA1_KEY_SIZE 10               // 80 bits = 10 bytes
@@ -25,10 +37,12 @@
 #define SDR_BUFFER_SIZE (16 * 16384)   // 256KB
 #define AUDIO_BUFFER_SIZE 8192
 #define AUDIO_RING_BUFFER_SIZE (8192 * 4)  // Ring buffer for smooth playback
+#define AUDIO_TARGET_LATENCY_MS 40     // ALSA device buffer (two periods)
 #define MAX_CHANNELS 4
 
 // TETRA audio codec constants
 #define TETRA_CODEC_FRAME_SIZE 137     // bits per codec frame
+#define TETRA_CODEC_FRAME_BYTES 18     // packed bytes per codec frame
 #define TETRA_CODEC_SAMPLES 160        // samples per frame (20ms @ 8kHz)
 #define TETRA_AUDIO_SAMPLE_RATE 8000   // 8 kHz audio
 
@@ -38,9 +52,22 @@
 #define CHANNEL_HISTORY_SIZE 100       // Channel assignment history depth
 #define CONTROL_CHANNEL_TIMEOUT 5000   // ms without control channel before error
 
+// Channel coding constants
+#define VITERBI_CODE_RATE 4            // Mother code outputs per input bit (rate 1/4)
+#define VITERBI_MAX_BITS 512           // Max trellis length per block
+#define LMAC_MAX_TYPE5_BITS 432        // Largest coded block (SCH/F)
+#define LMAC_MAX_TYPE3_BITS 288        // Largest type-3 block (SCH/F)
+#define LMAC_MAX_TYPE1_BITS 268        // Largest payload (SCH/F)
+
 // Forward declarations
 typedef struct tetra_demod_t tetra_demod_t;
 
+// Call recording file format
+typedef enum {
+    RECORD_FORMAT_WAV,                 // 16-bit PCM WAV, segmented below 4 GB
+    RECORD_FORMAT_ARCHIVE              // Lossless compressed archive with seek table
+} record_format_t;
+
 // Talk group information
 typedef struct {
     uint32_t id;                       // Talk group ID
@@ -61,7 +88,8 @@ typedef struct {
     uint64_t grant_time;               // When channel was granted
     uint64_t last_update;              // Last activity on this channel
     float signal_strength;             // Current signal strength
-    tetra_demod_t *demod;              // Dedicated demodulator for this channel
+    bool emergency;                    // Granted for an emergency call
+    TETRA_ATOMIC(tetra_demod_t *) demod;  // Dedicated demodulator, published by the monitor thread
 } voice_channel_t;
 
 // Control channel message types
@@ -89,6 +117,13 @@ typedef struct {
     uint64_t timestamp;
 } ctrl_message_t;
 
+// Control PDU decoder counters
+typedef struct {
+    uint64_t decoded[CTRL_MSG_UNKNOWN]; // Successfully decoded PDUs, by message type
+    uint64_t unknown;                  // PDUs with an unrecognised type
+    uint64_t rejected;                 // Inputs too short to hold a PDU
+} ctrl_decode_stats_t;
+
 // Channel assignment history entry
 typedef struct {
     uint64_t timestamp;
@@ -107,8 +142,95 @@ typedef struct {
     int priority_threshold;            // Minimum priority to follow (0-10)
     uint32_t hold_time_ms;             // How long to hold on channel after end
     bool emergency_override;           // Always follow emergency calls
+    bool raw_control;                  // Decode PDUs from raw bits (no channel coding)
+    uint16_t mcc;                      // Mobile country code (scrambling)
+    uint16_t mnc;                      // Mobile network code (scrambling)
+    uint8_t colour_code;               // Cell colour code (scrambling)
 } trunking_config_t;
 
+// Lower MAC logical channels with signalling channel coding
+typedef enum {
+    LMAC_CHAN_BSCH,                    // Broadcast sync: 60 payload bits, 120 coded
+    LMAC_CHAN_SCH_HD,                  // Half-slot signalling: 124 payload, 216 coded
+    LMAC_CHAN_SCH_F                    // Full-slot signalling: 268 payload, 432 coded
+} lmac_channel_t;
+
+// Viterbi decoder implementations
+typedef enum {
+    VITERBI_IMPL_AUTO,                 // Best available on this CPU
+    VITERBI_IMPL_SCALAR,               // Portable reference
+    VITERBI_IMPL_SSE41,                // x86 SSE4.1, one block at a time
+    VITERBI_IMPL_AVX2,                 // x86 AVX2, two blocks per pass in batches
+    VITERBI_IMPL_NEON,                 // ARM NEON
+    VITERBI_IMPL_COUNT
+} viterbi_impl_t;
+
+// Lower MAC decoder state
+typedef struct {
+    uint32_t scramb_init;              // Scrambling LFSR seed from MCC/MNC/colour code
+    uint64_t blocks_ok;                // Blocks that passed the CRC
+    uint64_t crc_errors;               // Blocks rejected by the CRC
+} lower_mac_t;
+
+// Pipeline thread roles (thread_policy.c)
+#define THREAD_MAX_CPUS 64
+
+typedef enum {
+    THREAD_ROLE_CAPTURE,               // SDR reader and DSP
+    THREAD_ROLE_CONTROL,               // Trunking channel monitor
+    THREAD_ROLE_AUDIO,                 // ALSA playback
+    THREAD_ROLE_GUI,                   // ImGui rendering
+    THREAD_ROLE_LOG,                   // Log formatter
+    THREAD_ROLE_RECORDER,              // Call recording and burst capture writers
+    THREAD_ROLE_BATCH,                 // Offline workers
+    THREAD_ROLE_COUNT
+} thread_role_t;
+
+typedef struct {
+    uint64_t cpus[THREAD_ROLE_COUNT];  // Allowed CPUs per role, 0 = any
+    int priority[THREAD_ROLE_COUNT];   // SCHED_FIFO priority per role, 0 = normal scheduling
+} thread_policy_t;
+
+// Pipeline memory and page fault accounting (rt_memory.c)
+typedef enum {
+    RT_STAGE_CAPTURE,                  // SDR read into the capture buffer
+    RT_STAGE_DEMOD,
+    RT_STAGE_DETECT,
+    RT_STAGE_CODEC,
+    RT_STAGE_PLAYBACK,                 // ALSA period fill
+    RT_STAGE_COUNT
+} rt_stage_t;
+
+typedef struct {
+    long minor;
+    long major;
+    bool valid;                        // False when fault accounting is off
+} rt_fault_mark_t;
+
+// Subsystems charged for pipeline memory
+typedef enum {
+    RT_POOL_CAPTURE,                   // SDR read buffers
+    RT_POOL_DEMOD,                     // Demodulators (control, voice, standalone)
+    RT_POOL_CODEC,
+    RT_POOL_AUDIO,                     // Rings, jitter buffers, mixer
+    RT_POOL_TRUNKING,                  // Channel manager, talk groups, history
+    RT_POOL_RECORDER,
+    RT_POOL_BATCH,
+    RT_POOL_TRACE,
+    RT_POOL_COUNT
+} rt_pool_t;
+
+typedef struct {
+    size_t mapped_bytes;               // Arena chunks, all resident
+    size_t huge_bytes;                 // Of which backed by reserved huge pages
+    size_t used_bytes;                 // Handed out and not freed
+    size_t peak_bytes;
+    unsigned chunks;
+    bool locked;                       // mlockall in effect
+    size_t pool_bytes[RT_POOL_COUNT];  // In use per subsystem, arena or accounted
+    size_t pool_peak[RT_POOL_COUNT];
+} rt_memory_stats_t;
+
 // Configuration structure
 typedef struct {
     uint32_t frequency;
@@ -119,9 +241,23 @@ typedef struct {
     bool verbose;
     bool use_known_vulnerability;
     bool enable_realtime_audio;
+    bool stereo_audio;                 // Pan simultaneous voice channels across stereo output
     bool enable_gui;
     bool enable_trunking;              // Enable trunked radio mode
     char *output_file;
+    char *record_dir;                  // Per-call recordings (trunking), or NULL
+    record_format_t record_format;     // File format for per-call recordings
+    char *capture_prefix;              // Raw burst capture PREFIX.tbc/.tbi, or NULL
+    char *batch_dir;                   // Offline mode: process the captures in this directory
+    int batch_jobs;                    // Batch worker threads (0 = one per online CPU)
+    bool latency_probe;                // Report per-stage latency at shutdown
+    bool latency_loopback;             // Simulated voice bursts drive the pipeline (implies probe)
+    char *trace_file;                  // Stage timeline (.json Chrome trace, else Perfetto), or NULL
+    thread_policy_t threads;           // Affinity and real-time priority per thread role
+    bool lock_memory;                  // mlockall so pipeline memory is never paged out
+    bool huge_pages;                   // Back pipeline buffers with huge pages
+    bool fault_stats;                  // Report page faults per stage at shutdown
+    bool memory_report;                // Report memory per subsystem at shutdown
     int device_index;
     trunking_config_t trunking;        // Trunking configuration
 } tetra_config_t;
@@ -132,7 +268,8 @@ typedef struct {
     uint32_t frequency;
     uint32_t sample_rate;
     int gain;
-    bool running;
+    bool running;                      // Set at init, cleared once by rtl_sdr_stop()
+    bool loopback;                     // Simulation emits voice bursts in real time
     pthread_t thread;
 } rtl_sdr_t;
 
@@ -161,15 +298,89 @@ typedef struct {
 } detection_status_t;
 
 // TETRA demodulator state
+// Complex baseband samples, interleaved re/im as the SDR delivers them
+#define DSP_ALIGN 64                   // Cache line, and the widest SIMD load
+#ifdef __cplusplus
+#define DSP_ALIGNED alignas(DSP_ALIGN)
+#else
+#define DSP_ALIGNED _Alignas(DSP_ALIGN)
+#endif
+
+typedef struct {
+    float re;
+    float im;
+} cf32_t;
+
+typedef struct {
+    int16_t re;                        // Q15: 8-bit full scale maps to +-32640
+    int16_t im;
+} ci16_t;
+
+// FIR kernels specialised at compile time for fixed designs (dsp_kernels.cpp).
+// The channel chain takes 2.4 Msps down by 16 and then by 4 to 37.5 ksps,
+// just over two samples per symbol, where the RRC matched filter runs
+#define DSP_CHANNEL_DECIM 64
+#define DSP_CHANNEL_RATE (TETRA_SAMPLE_RATE / DSP_CHANNEL_DECIM)
+
+typedef enum {
+    DSP_FIR_DECIM16,                   // 2.4 Msps -> 150 ksps low-pass, 64 taps
+    DSP_FIR_DECIM4,                    // 150 ksps -> 37.5 ksps low-pass, 48 taps
+    DSP_FIR_RRC035,                    // Root raised cosine, alpha 0.35, 17 taps
+    DSP_FIR_COUNT
+} dsp_fir_id_t;
+
+typedef struct {
+    const char *name;
+    const float *taps;                 // constexpr-generated design
+    uint32_t ntaps;
+    uint32_t decim;
+    // Kernels for this tap count and ratio; any taps of that length may be passed
+    void (*cf32)(const float *taps, const cf32_t *in, cf32_t *out, uint32_t out_count);
+    void (*f32)(const float *taps, const float *in, float *out, uint32_t out_count);
+    const int16_t *taps_q15;           // The design rounded to Q15
+    void (*ci16)(const int16_t *taps, const ci16_t *in, ci16_t *out, uint32_t out_count);
+} dsp_fir_kernel_t;
+
+// Demodulator arithmetic. Q15 fixed point suits cores with far more int16
+// SIMD than float throughput (Cortex-A53 and smaller): the 8-bit input fits
+// 16 bits exactly, and a CORDIC replaces atan2f in the discriminator. The
+// default is float unless built with TETRA_FIXED_POINT; --dsp overrides it
+typedef enum {
+    DSP_PATH_FLOAT,
+    DSP_PATH_Q15,
+    DSP_PATH_COUNT
+} dsp_path_t;
+
+// Q15 discriminator output: phase steps with 32768 = pi radians
+#define DSP_Q15_PI 32768
+
+// Samples are demodulated a block at a time: the slicer keeps one per symbol,
+// so a demodulator holds bits at the symbol rate and one block of scratch
+// rather than the whole SDR buffer at the input rate. A block of samples and
+// its discriminator output (12 KB) stay in L1 from conversion to slicing
+#define TETRA_DEMOD_BLOCK 1024
+
 struct tetra_demod_t {
     uint32_t frequency;
-    float *i_samples;
-    float *q_samples;
-    int sample_count;
+    dsp_path_t path;                 // Arithmetic, fixed when the demodulator is created
+    // Block scratch for that arithmetic; index 0 carries the previous block's last sample
+    union {
+        struct {
+            DSP_ALIGNED cf32_t samples[TETRA_DEMOD_BLOCK + 1];
+            DSP_ALIGNED float output[TETRA_DEMOD_BLOCK + 1];
+        } f32;
+        struct {
+            DSP_ALIGNED ci16_t samples[TETRA_DEMOD_BLOCK + 1];
+            DSP_ALIGNED int16_t output[TETRA_DEMOD_BLOCK + 1];
+        } q15;
+    } scratch;
     float symbol_timing;
     float squelch_threshold;
-    uint8_t *demod_bits;
+    uint8_t demod_bits[TETRA_BURST_LENGTH];
     int bit_count;
+    int sync_offset;                 // Training sequence offset of last burst (-1 if none)
+    float sync_correlation;          // Training sequence correlation of last burst
+    float signal_power;              // RMS power of the last processed block
     detection_params_t *params;      // Pointer to shared detection parameters
     detection_status_t *status;      // Pointer to shared status information
 };
@@ -190,17 +401,119 @@ typedef struct {
     FILE *output_file;
 } audio_output_t;
 
+// Lock-free single-producer/single-consumer sample ring (audio_ring.c)
+typedef struct audio_ring audio_ring_t;
+
+typedef struct {
+    uint32_t capacity;                 // Ring size in samples
+    uint32_t available;                // Samples queued for the consumer
+    uint64_t overflows;                // Samples dropped on a full ring
+    uint64_t underruns;                // Times the consumer ran dry mid-stream
+} audio_ring_stats_t;
+
+// Adaptive playout buffer over the sample ring (jitter_buffer.c)
+#define JITTER_FRAME_SAMPLES TETRA_CODEC_SAMPLES   // Playout granularity (20 ms)
+
+typedef struct jitter_buffer jitter_buffer_t;
+
+typedef struct {
+    float jitter_ms;                   // Smoothed arrival jitter
+    float target_ms;                   // Current target playout delay
+    float latency_ms;                  // Buffered audio at the last pull
+    uint64_t frames_played;            // Frames played from received audio
+    uint64_t frames_concealed;         // Frames synthesised during underruns
+    uint64_t concealment_events;       // Underrun episodes
+    uint64_t frames_stretched;         // Frames slowed down to build up delay
+    uint64_t frames_compressed;        // Frames sped up to shed delay
+} jitter_stats_t;
+
+// Multi-stream mixer, one stream per voice channel slot (audio_mixer.c)
+#define AUDIO_MIXER_MAX_STREAMS MAX_ACTIVE_CHANNELS
+#define AUDIO_MIXER_MAX_CHANNELS 2     // Mono or interleaved stereo output
+#define AUDIO_MIXER_BLOCK JITTER_FRAME_SAMPLES  // Frames per mixed block
+
+typedef struct audio_mixer audio_mixer_t;
+
+// Per-call recorder with a dedicated writer thread (call_recorder.c)
+typedef struct call_recorder call_recorder_t;
+
+// Compressed audio archive: LPC + Rice blocks and a seek table (audio_archive.c)
+#define ARCHIVE_BLOCK_SAMPLES 4096     // Samples per independently decodable block
+
+typedef struct audio_archive audio_archive_t;
+typedef struct audio_archive_reader audio_archive_reader_t;
+
+// Raw burst capture: append-only bit records plus an mmap-able index (burst_capture.c)
+#define BURST_FLAG_SOFT 0x0001         // Record carries one soft bit per hard bit
+
+// Fixed-size index entry, written in capture order (so sorted by time)
+typedef struct {
+    uint64_t timestamp_us;             // Stream time of the training sequence (wall clock)
+    uint64_t data_offset;              // Record position in the data file
+    uint32_t frequency;                // Channel frequency (Hz)
+    uint32_t talk_group;               // Talk group of the followed call, 0 if none
+    float correlation;                 // Training sequence correlation
+    float power;                       // Signal power at detection
+    int32_t sync_offset;               // Training sequence position within the bits
+    uint16_t bit_count;                // Demodulated bits stored
+    uint16_t flags;                    // BURST_FLAG_*
+} burst_index_entry_t;
+
+// Burst index query; zero fields match anything
+typedef struct {
+    uint64_t start_us;                 // Inclusive
+    uint64_t end_us;                   // Exclusive, 0 = open ended
+    uint32_t frequency;
+    uint32_t talk_group;
+} burst_query_t;
+
+typedef struct burst_capture burst_capture_t;
+typedef struct burst_index burst_index_t;
+
+// End-to-end latency probe (latency.c)
+typedef enum {
+    LATENCY_STAGE_DEMOD,               // Buffer arrival to demodulated bits
+    LATENCY_STAGE_DETECT,              // Demodulated to burst detected
+    LATENCY_STAGE_CODEC,               // Detected to speech decoded (TEA1 + codec)
+    LATENCY_STAGE_QUEUE,               // Decoded to pulled from the playout ring
+    LATENCY_STAGE_DEVICE,              // Pulled to played by the sound card
+    LATENCY_STAGE_TOTAL,               // Buffer arrival to played (to decoded without a device)
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+// Carried with one capture buffer through the pipeline
+typedef struct {
+    uint64_t arrival_us;               // Buffer handed over by the SDR
+    uint64_t last_us;                  // Last stage stamp
+} latency_tag_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t max_us;
+} latency_summary_t;
+
+typedef struct latency_probe latency_probe_t;
+
+// Mark queues: one per ring the marked samples travel through
+#define LATENCY_QUEUE_PLAYOUT 0                      // Playout ring (single stream)
+#define LATENCY_QUEUE_MIXER(stream) (1 + (stream))   // A mixer stream's ring
+#define LATENCY_QUEUES (1 + AUDIO_MIXER_MAX_STREAMS)
+
 // Real-time audio playback (ALSA)
 typedef struct {
     void *pcm_handle;
-    int16_t *ring_buffer;
-    int ring_write_pos;
-    int ring_read_pos;
-    int ring_size;
+    audio_ring_t *ring;
+    jitter_buffer_t *jitter;
+    audio_mixer_t *mixer;              // Optional: play mixed streams instead of the ring
+    int channels;                      // Device channels (mixer output layout)
+    int wake_fd;                       // eventfd: producer wakes an idle playback thread
+    bool mmap_access;                  // Writing straight into the device buffer
+    latency_probe_t *latency;          // Optional: retires latency marks as audio plays
     int sample_rate;
     bool running;
     pthread_t playback_thread;
-    pthread_mutex_t buffer_mutex;
 } audio_playback_t;
 
 // TETRA codec state
@@ -208,6 +521,8 @@ typedef struct {
     float prev_samples[TETRA_CODEC_SAMPLES];
     float excitation[TETRA_CODEC_SAMPLES];
     float lpc_coeffs[10];
+    float synth_mem[12];               // LPC synthesis memory: last 12 outputs (10 taps + SIMD padding)
+    float deemph_mem;                  // Last pre-de-emphasis sample of previous frame
     float pitch_gain;
     float pitch_period;
     int frame_count;
@@ -220,6 +535,8 @@ typedef struct {
 
     // Control channel
     tetra_demod_t *control_demod;
+    detection_params_t *params;        // Shared by the control and voice demodulators
+    detection_status_t *status;
     uint64_t last_control_msg_time;
     uint32_t control_msg_count;
 
@@ -244,6 +561,9 @@ typedef struct {
     int history_count;
     pthread_mutex_t history_lock;
 
+    // Control channel coding
+    lower_mac_t lower_mac;
+
     // Statistics
     uint32_t total_calls;
     uint32_t emergency_calls;
@@ -266,6 +586,8 @@ void rtl_sdr_cleanup(rtl_sdr_t *sdr);
 tetra_demod_t* tetra_demod_init(uint32_t sample_rate, detection_params_t *params, detection_status_t *status, float squelch_threshold);
 int tetra_demod_process(tetra_demod_t *demod, uint8_t *iq_data, uint32_t len);
 bool tetra_detect_burst(tetra_demod_t *demod);
+int tetra_demod_sync_sample(const tetra_demod_t *demod);
+extern const uint8_t TETRA_TRAINING_SEQ[TETRA_TRAINING_SEQ_BITS];
 void tetra_demod_cleanup(tetra_demod_t *demod);
 
 // Detection parameters management
@@ -292,32 +614,284 @@ void tea1_brute_force_32bit(const uint8_t *ciphertext, const uint8_t *known_plai
 
 // Signal processing (signal_processing.c)
 void convert_uint8_to_float(const uint8_t *input, float *output, uint32_t len);
+void convert_float_to_int16(const float *input, int16_t *output, uint32_t len, float scale);
+void mix_int16_q15(int16_t *acc, const int16_t *input, int16_t gain_q15, uint32_t len);
 void quadrature_demod(const float *i, const float *q, float *output, uint32_t len);
 void low_pass_filter(float *data, uint32_t len, float cutoff);
 float detect_signal_strength(const float *i, const float *q, uint32_t len);
 
+// Interleaved complex kernels; buffers from cf32_alloc()/ci16_alloc() are DSP_ALIGN aligned
+cf32_t* cf32_alloc(rt_pool_t pool, uint32_t count);       // Zeroed; release with dsp_free()
+ci16_t* ci16_alloc(rt_pool_t pool, uint32_t count);
+void dsp_free(void *buffer);
+void convert_cu8_to_cf32(const uint8_t *iq, cf32_t *output, uint32_t count);  // Centred on 127.5
+void convert_cu8_to_ci16(const uint8_t *iq, ci16_t *output, uint32_t count);  // (x - 127.5) * 256
+void quadrature_demod_cf32(const cf32_t *input, float *output, uint32_t len);
+float detect_signal_strength_cf32(const cf32_t *input, uint32_t len);
+float detect_signal_strength_cu8(const uint8_t *iq, uint32_t count);
+// FIR over (out_count - 1) * decim + ntaps input samples, history first; uses
+// the compile-time kernel when one exists for ntaps and decim
+void fir_decimate_cf32(const float *taps, uint32_t ntaps, uint32_t decim, const cf32_t *in,
+                       cf32_t *out, uint32_t out_count);
+void fir_decimate_f32(const float *taps, uint32_t ntaps, uint32_t decim, const float *in,
+                      float *out, uint32_t out_count);
+// Q15 path: same stages as the float kernels above, on ci16_t samples
+void quadrature_demod_ci16(const ci16_t *input, int16_t *output, uint32_t len);  // CORDIC
+void low_pass_filter_q15(int16_t *data, uint32_t len, int32_t alpha_q15);       // alpha 0..32768
+void fir_decimate_ci16(const int16_t *taps, uint32_t ntaps, uint32_t decim, const ci16_t *in,
+                       ci16_t *out, uint32_t out_count);
+dsp_path_t dsp_get_path(void);
+int dsp_set_path(dsp_path_t path);   // For demodulators created afterwards
+const char* dsp_path_name(dsp_path_t path);
+// Matching bits against an n-bit pattern at every offset; returns count - n + 1 offsets
+uint32_t correlate_bits(const uint8_t *bits, uint32_t count, const uint8_t *pattern, uint32_t n,
+                        uint8_t *matches);
+
+// Compile-time specialised kernels (dsp_kernels.cpp)
+const dsp_fir_kernel_t* dsp_fir_kernel(dsp_fir_id_t id);
+const dsp_fir_kernel_t* dsp_fir_find(uint32_t ntaps, uint32_t decim);   // NULL if not specialised
+void dsp_correlate_training(const uint8_t *bits, uint32_t count, uint8_t *matches);
+
 // Audio output (audio_output.c)
 audio_output_t* audio_output_init(const char *filename, int sample_rate);
 int audio_output_write(audio_output_t *audio, const int16_t *samples, int count);
 void audio_output_cleanup(audio_output_t *audio);
 
+// Per-call recording (call_recorder.c)
+call_recorder_t* call_recorder_init(const char *directory, int sample_rate, uint32_t sync_bytes,
+                                    record_format_t format);
+int call_recorder_start_call(call_recorder_t *rec, int slot, const voice_channel_t *ch);
+int call_recorder_write(call_recorder_t *rec, int slot, const int16_t *samples, int count);
+void call_recorder_end_call(call_recorder_t *rec, int slot);
+void call_recorder_cleanup(call_recorder_t *rec);
+
+// Compressed audio archive (audio_archive.c)
+audio_archive_t* audio_archive_create(int fd, int sample_rate, uint64_t start_time_us);
+int audio_archive_write(audio_archive_t *ar, const int16_t *samples, int count);
+uint64_t audio_archive_bytes(const audio_archive_t *ar);
+int audio_archive_close(audio_archive_t *ar);
+audio_archive_reader_t* audio_archive_open(const char *path);
+int audio_archive_sample_rate(const audio_archive_reader_t *rd);
+uint64_t audio_archive_total_samples(const audio_archive_reader_t *rd);
+uint64_t audio_archive_start_time(const audio_archive_reader_t *rd);
+int audio_archive_seek(audio_archive_reader_t *rd, uint64_t sample);
+int audio_archive_seek_time(audio_archive_reader_t *rd, uint64_t time_us);
+int audio_archive_read(audio_archive_reader_t *rd, int16_t *samples, int count);
+void audio_archive_reader_close(audio_archive_reader_t *rd);
+
+// Raw burst capture (burst_capture.c)
+burst_capture_t* burst_capture_open(const char *prefix);
+burst_capture_t* burst_capture_create(const char *prefix);      // Truncates an existing capture
+int burst_capture_write(burst_capture_t *cap, const burst_index_entry_t *meta,
+                        const uint8_t *bits, const int8_t *soft);
+uint64_t burst_capture_count(const burst_capture_t *cap);
+void burst_capture_close(burst_capture_t *cap);
+burst_index_t* burst_index_open(const char *prefix);
+uint64_t burst_index_count(const burst_index_t *idx);
+const burst_index_entry_t* burst_index_entry(const burst_index_t *idx, uint64_t i);
+uint64_t burst_index_find_time(const burst_index_t *idx, uint64_t time_us);
+int64_t burst_index_next(const burst_index_t *idx, const burst_query_t *query, uint64_t from);
+int burst_index_bits(const burst_index_t *idx, uint64_t i, uint8_t *bits);
+int burst_index_soft(const burst_index_t *idx, uint64_t i, int8_t *soft);
+void burst_index_close(burst_index_t *idx);
+
+// Offline batch processing (batch.c)
+int batch_run(const tetra_config_t *config);
+
 // Real-time audio playback (audio_playback.c)
-audio_playback_t* audio_playback_init(int sample_rate);
+audio_playback_t* audio_playback_init(int sample_rate, audio_mixer_t *mixer);
 int audio_playback_write(audio_playback_t *playback, const int16_t *samples, int count);
+int audio_playback_write_tagged(audio_playback_t *playback, const int16_t *samples, int count,
+                                const latency_tag_t *tag);
+void audio_playback_set_latency_probe(audio_playback_t *playback, latency_probe_t *probe);
+void audio_playback_notify(audio_playback_t *playback);
 void audio_playback_start(audio_playback_t *playback);
 void audio_playback_stop(audio_playback_t *playback);
+void audio_playback_get_stats(audio_playback_t *playback, audio_ring_stats_t *stats);
+void audio_playback_get_jitter_stats(audio_playback_t *playback, jitter_stats_t *stats);
 void audio_playback_cleanup(audio_playback_t *playback);
 
+// Audio sample ring (audio_ring.c)
+audio_ring_t* audio_ring_create(uint32_t size);
+void audio_ring_destroy(audio_ring_t *ring);
+uint32_t audio_ring_capacity(const audio_ring_t *ring);
+uint32_t audio_ring_available(audio_ring_t *ring);
+int audio_ring_write(audio_ring_t *ring, const int16_t *samples, int count);
+int audio_ring_read(audio_ring_t *ring, int16_t *samples, int count);
+uint32_t audio_ring_write_position(audio_ring_t *ring);  // Samples ever written (wraps)
+uint32_t audio_ring_read_position(audio_ring_t *ring);   // Samples ever read (wraps)
+void audio_ring_get_stats(audio_ring_t *ring, audio_ring_stats_t *stats);
+
+// Jitter buffer (jitter_buffer.c)
+jitter_buffer_t* jitter_buffer_create(audio_ring_t *ring, int sample_rate);
+void jitter_buffer_destroy(jitter_buffer_t *jb);
+int jitter_buffer_push(jitter_buffer_t *jb, const int16_t *samples, int count);
+int jitter_buffer_push_at(jitter_buffer_t *jb, const int16_t *samples, int count,
+                          uint64_t arrival_us);          // Explicit arrival time (replay, tests)
+void jitter_buffer_reset(jitter_buffer_t *jb);           // Producer side: forget timing at stream open
+int jitter_buffer_pull(jitter_buffer_t *jb, int16_t *frame);
+void jitter_buffer_get_stats(jitter_buffer_t *jb, jitter_stats_t *stats);
+
+// Audio mixer (audio_mixer.c)
+audio_mixer_t* audio_mixer_init(int sample_rate, int channels);
+int audio_mixer_channels(const audio_mixer_t *mixer);
+int audio_mixer_stream_open(audio_mixer_t *mixer, int stream, int priority, bool emergency);
+void audio_mixer_stream_set_gain(audio_mixer_t *mixer, int stream, float gain);
+void audio_mixer_stream_set_pan(audio_mixer_t *mixer, int stream, float pan);
+int audio_mixer_write(audio_mixer_t *mixer, int stream, const int16_t *samples, int count);
+int audio_mixer_decode_frame(audio_mixer_t *mixer, int stream, const uint8_t *encoded_bits,
+                             int16_t *audio_samples);
+int audio_mixer_pull(audio_mixer_t *mixer, int16_t *output);
+uint32_t audio_mixer_write_position(audio_mixer_t *mixer, int stream);  // Stream ring positions
+uint32_t audio_mixer_read_position(audio_mixer_t *mixer, int stream);
+void audio_mixer_print_statistics(audio_mixer_t *mixer);
+void audio_mixer_cleanup(audio_mixer_t *mixer);
+
 // TETRA audio codec (tetra_codec.c)
 tetra_codec_t* tetra_codec_init(void);
 int tetra_codec_decode_frame(tetra_codec_t *codec, const uint8_t *encoded_bits,
                               int16_t *audio_samples);
+int tetra_codec_decode_frames(tetra_codec_t *const *codecs, const uint8_t *frames,
+                              int16_t *audio_samples, int count);
+void tetra_codec_reset(tetra_codec_t *codec);
 void tetra_codec_cleanup(tetra_codec_t *codec);
 
 // Utilities (utils.c)
 void hex_dump(const uint8_t *data, size_t len, const char *label);
-uint64_t get_timestamp_us(void);
-void log_message(bool verbose, const char *format, ...);
+
+// Clocks (clock.c)
+// Stream time: a sample's position in the capture, mapped onto the wall clock
+typedef struct {
+    uint32_t sample_rate;
+    uint64_t origin_us;                // Wall clock time of sample 0
+    uint64_t samples;                  // Samples delivered before the current buffer
+} stream_clock_t;
+
+uint64_t get_timestamp_us(void);         // Wall clock us, never steps backwards
+uint64_t get_timestamp_coarse_us(void);  // Same base, tick resolution, cheaper
+void stream_clock_init(stream_clock_t *clock, uint32_t sample_rate, uint64_t origin_us);
+void stream_clock_advance(stream_clock_t *clock, uint64_t samples);
+uint64_t stream_clock_time_us(const stream_clock_t *clock, uint64_t sample);
+
+// Latency probe (latency.c)
+latency_probe_t* latency_probe_create(void);
+void latency_probe_destroy(latency_probe_t *probe);
+void latency_tag_start(latency_tag_t *tag);
+void latency_probe_stage(latency_probe_t *probe, latency_tag_t *tag, latency_stage_t stage);
+void latency_probe_record(latency_probe_t *probe, latency_stage_t stage, uint64_t us);
+void latency_probe_queue(latency_probe_t *probe, int queue, const latency_tag_t *tag,
+                         uint32_t position);
+void latency_probe_played(latency_probe_t *probe, int queue, uint32_t read_position, uint64_t out_us,
+                          int sample_rate);
+void latency_probe_summary(latency_probe_t *probe, latency_stage_t stage, latency_summary_t *summary);
+void latency_probe_print(latency_probe_t *probe);
+
+// Thread policy (thread_policy.c)
+void thread_policy_init(thread_policy_t *policy);
+int thread_policy_parse_cpus(thread_policy_t *policy, const char *spec);      // ROLE=CPULIST
+int thread_policy_parse_priority(thread_policy_t *policy, const char *spec);  // ROLE=PRIO
+void thread_policy_set_realtime(thread_policy_t *policy);  // Default FIFO for capture and audio
+void thread_policy_set(const thread_policy_t *policy);      // Before any thread starts
+void thread_policy_apply(thread_role_t role, int index);    // Calling thread; index -1 if unique
+void thread_policy_leave(void);                             // Before the thread returns
+void thread_policy_report(void);
+
+// Pipeline memory (rt_memory.c)
+int rt_memory_init(bool lock_memory, bool huge_pages);     // Before pipeline buffers are allocated
+// Not from the capture or audio threads once running: takes a mutex, may map memory
+void* rt_alloc(rt_pool_t pool, size_t size);  // Zeroed, resident, 64-byte aligned; NULL on failure
+void rt_free(void *ptr);
+void rt_memory_account(rt_pool_t pool, long delta);        // Memory allocated outside the arena
+void rt_memory_get_stats(rt_memory_stats_t *stats);
+void rt_faults_enable(bool enabled);
+void rt_faults_begin(rt_fault_mark_t *mark);               // Calling thread's counts
+void rt_faults_end(rt_fault_mark_t *mark, rt_stage_t stage);
+void rt_memory_report(void);
+
+// Pipeline tracing (trace.c)
+#define TRACE_MAX_ARGS 3
+
+// Static description of one trace point; unused argument names are NULL
+typedef struct {
+    const char *name;
+    const char *category;
+    const char *args[TRACE_MAX_ARGS];
+} trace_site_t;
+
+typedef enum {
+    TRACE_FORMAT_CHROME_JSON,          // chrome://tracing, ui.perfetto.dev
+    TRACE_FORMAT_PERFETTO              // Perfetto protobuf (.pftrace)
+} trace_format_t;
+
+void trace_set_enabled(bool enabled);
+bool trace_is_enabled(void);
+int trace_write(const char *path, trace_format_t format);  // Dump every thread's ring
+trace_format_t trace_format_for_path(const char *path);
+
+// uint64_t t = TRACE_BEGIN(); ...; TRACE_END(t, "cat", "name", "arg", v, ...);
+// Three name/value pairs, NULL/0 for unused ones. Compiled out without HAVE_TRACE.
+#ifdef HAVE_TRACE
+uint64_t trace_begin(void);
+void trace_end(const trace_site_t *site, uint64_t start, double a0, double a1, double a2);
+
+#define TRACE_BEGIN() trace_begin()
+#define TRACE_END(start, cat, nm, n0, v0, n1, v1, n2, v2) do { \
+    static const trace_site_t trace_site_ = { (nm), (cat), { (n0), (n1), (n2) } }; \
+    if (start) trace_end(&trace_site_, (start), (double)(v0), (double)(v1), (double)(v2)); \
+} while (0)
+#else
+#define TRACE_BEGIN() ((uint64_t)0)
+#define TRACE_END(start, cat, nm, n0, v0, n1, v1, n2, v2) do { \
+    (void)(start); (void)(v0); (void)(v1); (void)(v2); \
+} while (0)
+#endif
+
+// Asynchronous logging (log.c)
+typedef enum {
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,                    // Default threshold
+    LOG_LEVEL_DEBUG                    // Per-burst detail, enabled by -v
+} log_level_t;
+
+typedef struct {
+    uint64_t written;
+    uint64_t dropped;                  // Lost to a full per-thread ring
+    uint64_t suppressed;               // Held back by per-site rate limits
+} log_stats_t;
+
+int log_start(void);
+void log_stop(void);
+void log_flush(void);
+void log_set_level(log_level_t level);
+void log_get_stats(log_stats_t *stats);
+
+// Parenthesised so the C macro below does not apply; C++ callers use this
+void (log_message)(bool verbose, const char *format, ...);
+
+#ifndef __cplusplus
+// One per call site: level, rate limit and suppression state
+typedef struct {
+    log_level_t level;
+    uint32_t max_per_sec;              // 0 = unlimited
+    _Atomic uint64_t window;           // Current second << 32 | records in it
+    _Atomic uint32_t suppressed;       // Records rate limited since the last one queued
+} log_site_t;
+
+void log_write(log_site_t *site, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+void log_vwrite(log_site_t *site, const char *format, va_list args);
+
+// Log at level `lvl`, at most `rate` times per second from this call site
+#define LOG_AT(lvl, rate, ...) do { \
+        static log_site_t log_site_ = { .level = (lvl), .max_per_sec = (rate) }; \
+        log_write(&log_site_, __VA_ARGS__); \
+    } while (0)
+
+#define log_message(verbose, ...) do { \
+        if (verbose) LOG_AT(LOG_LEVEL_INFO, 0, __VA_ARGS__); \
+    } while (0)
+#endif
 
 // GUI interface (gui.c)
 typedef struct tetra_gui_t tetra_gui_t;
@@ -346,6 +920,8 @@ void channel_manager_list_talk_groups(channel_manager_t *mgr);
 void channel_manager_process_control_message(channel_manager_t *mgr, ctrl_message_t *msg);
 voice_channel_t* channel_manager_get_active_channel(channel_manager_t *mgr, uint32_t talk_group_id);
 void channel_manager_tune_to_channel(channel_manager_t *mgr, uint32_t frequency);
+bool channel_manager_decode_control_burst(channel_manager_t *mgr, tetra_demod_t *demod,
+                                          ctrl_message_t *msg);
 
 // Statistics and monitoring
 void channel_manager_print_statistics(channel_manager_t *mgr);
@@ -354,6 +930,37 @@ channel_history_entry_t* channel_manager_get_history(channel_manager_t *mgr, int
 
 // Control channel decoding (control_channel.c)
 bool decode_control_channel_data(uint8_t *bits, int bit_count, ctrl_message_t *msg);
+bool decode_control_pdu_packed(const uint8_t *packed, int bit_count, ctrl_message_t *msg);
+bool decode_control_burst(lower_mac_t *mac, bool raw_control, const uint8_t *bits,
+                          int bit_count, int sync_offset, ctrl_message_t *msg);
+void control_channel_get_stats(ctrl_decode_stats_t *stats);
+void control_channel_reset_stats(void);
 const char* ctrl_msg_type_to_string(ctrl_msg_type_t type);
 
+// Lower MAC channel coding (lower_mac.c)
+void lower_mac_init(lower_mac_t *mac, uint16_t mcc, uint16_t mnc, uint8_t colour_code);
+int lower_mac_type1_bits(lmac_channel_t chan);
+int lower_mac_type5_bits(lmac_channel_t chan);
+int lower_mac_decode(lower_mac_t *mac, lmac_channel_t chan, const int8_t *soft,
+                     uint8_t *type1_bits);
+int lower_mac_decode_hard(lower_mac_t *mac, lmac_channel_t chan, const uint8_t *bits,
+                          uint8_t *type1_bits);
+int lower_mac_encode(const lower_mac_t *mac, lmac_channel_t chan, const uint8_t *type1_bits,
+                     uint8_t *type5_bits);
+uint16_t tetra_crc16(const uint8_t *bits, int len);
+
+// Viterbi decoder (viterbi.c)
+// Soft bits: int8, positive = '1', negative = '0', 0 = erasure
+// Batches are contiguous: block b uses soft[b * n_steps * 4] and bits[b * n_steps]
+void viterbi_encode(const uint8_t *bits, int n_bits, uint8_t *coded);
+int viterbi_decode(const int8_t *soft, int n_steps, uint8_t *bits);
+int viterbi_decode_impl(viterbi_impl_t impl, const int8_t *soft, int n_steps, uint8_t *bits);
+int viterbi_decode_batch(const int8_t *soft, int n_steps, uint8_t *bits, int count);
+int viterbi_decode_batch_impl(viterbi_impl_t impl, const int8_t *soft, int n_steps,
+                              uint8_t *bits, int count);
+bool viterbi_impl_available(viterbi_impl_t impl);
+const char* viterbi_impl_name(viterbi_impl_t impl);
+viterbi_impl_t viterbi_get_impl(void);
+int viterbi_set_impl(viterbi_impl_t impl);
+
 #endif // TETRA_ANALYZER_H
@@ -0,0 +1,598 @@
+/*
+ * Compressed Audio Archive
+ * Lossless LPC + Rice coded 16-bit mono audio with a seek table
+ *
+ * File layout (little-endian):
+ *   header   "TCA1", sample rate, block size, start time, total samples,
+ *            seek table offset (0 until the file is closed)
+ *   blocks   sync word, sample count, predictor order, Rice parameter,
+ *            payload size, Q11 predictor coefficients, warm-up samples,
+ *            then Rice coded prediction residuals
+ *   seek     "TCAS", entry count, {first sample, file offset} per block
+ *
+ * Each block picks the predictor order (0-8) that codes smallest, so
+ * silence and speech both compress well. All prediction is integer with
+ * 32-bit headroom, so decoding reproduces the input exactly. Blocks start
+ * with a sync word, so a file cut short by a crash can still be rescanned.
+ */
+
+#include "tetra_analyzer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ARCHIVE_MAGIC "TCA1"
+#define ARCHIVE_SEEK_MAGIC "TCAS"
+#define ARCHIVE_HEADER_BYTES 40
+#define ARCHIVE_BLOCK_SYNC 0xC5A7
+#define ARCHIVE_BLOCK_HEADER_BYTES 8
+#define ARCHIVE_MAX_ORDER 8
+#define ARCHIVE_COEFF_SHIFT 11         // Q11 coefficients
+#define ARCHIVE_COEFF_LIMIT 8191       // |q| * 32768 * 8 stays below 2^31
+#define ARCHIVE_RICE_ESCAPE 24         // Unary run that introduces a raw 32-bit value
+#define ARCHIVE_MAX_RICE_K 20
+#define ARCHIVE_MAX_BLOCK_BYTES (ARCHIVE_BLOCK_HEADER_BYTES + 4 * ARCHIVE_MAX_ORDER + \
+                                 ARCHIVE_BLOCK_SAMPLES * 8)
+
+typedef struct {
+    uint64_t sample;
+    uint64_t offset;
+} seek_entry_t;
+
+struct audio_archive {
+    int fd;
+    int sample_rate;
+    uint64_t start_time_us;
+    uint64_t offset;                   // Next write position
+    uint64_t total_samples;
+
+    int16_t pending[ARCHIVE_BLOCK_SAMPLES];
+    int pending_count;
+
+    seek_entry_t *seek;
+    uint32_t seek_count;
+    uint32_t seek_capacity;
+
+    uint8_t block[ARCHIVE_MAX_BLOCK_BYTES];
+    int32_t residual[ARCHIVE_BLOCK_SAMPLES];
+};
+
+struct audio_archive_reader {
+    int fd;
+    int sample_rate;
+    uint32_t block_samples;
+    uint64_t start_time_us;
+    uint64_t total_samples;
+
+    seek_entry_t *seek;
+    uint32_t seek_count;
+
+    uint32_t block_index;              // Block held in `decoded`
+    int decoded_count;
+    int decoded_pos;
+    int16_t decoded[ARCHIVE_BLOCK_SAMPLES];
+    uint8_t block[ARCHIVE_MAX_BLOCK_BYTES];
+};
+
+// Little-endian field access
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static void put_u64(uint8_t *p, uint64_t v) { put_u32(p, (uint32_t)v); put_u32(p + 4, (uint32_t)(v >> 32)); }
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get_u32(const uint8_t *p) { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+static uint64_t get_u64(const uint8_t *p) { return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32); }
+
+// MSB-first bit writer / reader for Rice codes
+
+typedef struct {
+    uint8_t *out;
+    size_t pos;
+    uint64_t acc;
+    int bits;
+} bit_writer_t;
+
+static inline void bw_put(bit_writer_t *bw, uint32_t value, int nbits) {
+    bw->acc = (bw->acc << nbits) | value;
+    bw->bits += nbits;
+    while (bw->bits >= 8) {
+        bw->bits -= 8;
+        bw->out[bw->pos++] = (uint8_t)(bw->acc >> bw->bits);
+    }
+}
+
+static inline void bw_flush(bit_writer_t *bw) {
+    if (bw->bits > 0) {
+        bw->out[bw->pos++] = (uint8_t)(bw->acc << (8 - bw->bits));
+        bw->bits = 0;
+    }
+}
+
+typedef struct {
+    const uint8_t *in;
+    size_t len;
+    size_t pos;
+    uint64_t acc;
+    int bits;
+} bit_reader_t;
+
+static inline uint32_t br_get(bit_reader_t *br, int nbits) {
+    while (br->bits < nbits) {
+        br->acc = (br->acc << 8) | (br->pos < br->len ? br->in[br->pos] : 0);
+        br->pos++;
+        br->bits += 8;
+    }
+    br->bits -= nbits;
+    return (uint32_t)(br->acc >> br->bits) & (uint32_t)((1ull << nbits) - 1);
+}
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+// Prediction, laid out so each pass over the block is a straight loop the
+// compiler vectorises: residual[n] = x[n] - (sum_j q[j] * x[n-1-j]) >> shift
+static void lpc_residual(const int16_t *x, int n, const int16_t *q, int order, int32_t *residual) {
+    int32_t acc[ARCHIVE_BLOCK_SAMPLES];
+
+    for (int i = order; i < n; i++) acc[i] = 0;
+    for (int j = 0; j < order; j++) {
+        const int32_t c = q[j];
+        const int16_t *src = x - 1 - j;
+        for (int i = order; i < n; i++) {
+            acc[i] += c * src[i];
+        }
+    }
+    for (int i = order; i < n; i++) {
+        residual[i] = x[i] - (acc[i] >> ARCHIVE_COEFF_SHIFT);
+    }
+}
+
+// Rice parameter from the mean mapped residual, and the resulting bit cost
+static int rice_parameter(const int32_t *residual, int start, int n, uint64_t *cost) {
+    uint64_t sum = 0;
+    for (int i = start; i < n; i++) {
+        sum += zigzag(residual[i]);
+    }
+
+    int count = n - start;
+    int k = 0;
+    if (count > 0) {
+        uint64_t mean = sum / (uint64_t)count;
+        while (k < ARCHIVE_MAX_RICE_K && (1ull << (k + 1)) <= mean + 1) k++;
+    }
+
+    // Estimated size: unary quotients plus k low bits and a stop bit each
+    *cost = (sum >> k) + (uint64_t)count * (uint64_t)(k + 1);
+    return k;
+}
+
+// Autocorrelation and Levinson-Durbin; lpc[p][j] is the order-p predictor
+static void lpc_analysis(const int16_t *x, int n, float lpc[ARCHIVE_MAX_ORDER + 1][ARCHIVE_MAX_ORDER]) {
+    float xf[ARCHIVE_BLOCK_SAMPLES];
+    float r[ARCHIVE_MAX_ORDER + 1];
+
+    for (int i = 0; i < n; i++) xf[i] = (float)x[i];
+    for (int lag = 0; lag <= ARCHIVE_MAX_ORDER; lag++) {
+        float sum = 0.0f;
+        for (int i = lag; i < n; i++) {
+            sum += xf[i] * xf[i - lag];
+        }
+        r[lag] = sum;
+    }
+
+    memset(lpc, 0, sizeof(float) * (ARCHIVE_MAX_ORDER + 1) * ARCHIVE_MAX_ORDER);
+    if (r[0] <= 0.0f) return;
+
+    r[0] *= 1.0f + 1e-6f;              // Slight white-noise correction for stability
+    float err = r[0];
+    float a[ARCHIVE_MAX_ORDER] = {0};
+
+    for (int p = 1; p <= ARCHIVE_MAX_ORDER; p++) {
+        float k = r[p];
+        for (int j = 0; j < p - 1; j++) k -= a[j] * r[p - 1 - j];
+        k /= err;
+
+        float prev[ARCHIVE_MAX_ORDER];
+        memcpy(prev, a, sizeof(prev));
+        a[p - 1] = k;
+        for (int j = 0; j < p - 1; j++) a[j] = prev[j] - k * prev[p - 2 - j];
+
+        err *= 1.0f - k * k;
+        memcpy(lpc[p], a, sizeof(a));
+        if (err <= 0.0f) break;
+    }
+}
+
+static void quantize_coeffs(const float *a, int order, int16_t *q) {
+    for (int j = 0; j < order; j++) {
+        long v = lrintf(a[j] * (float)(1 << ARCHIVE_COEFF_SHIFT));
+        if (v > ARCHIVE_COEFF_LIMIT) v = ARCHIVE_COEFF_LIMIT;
+        if (v < -ARCHIVE_COEFF_LIMIT) v = -ARCHIVE_COEFF_LIMIT;
+        q[j] = (int16_t)v;
+    }
+}
+
+// Encode one block; returns its size in bytes
+static size_t encode_block(audio_archive_t *ar, const int16_t *x, int n) {
+    static const int candidate_orders[] = { 0, 1, 2, 4, 8 };
+    float lpc[ARCHIVE_MAX_ORDER + 1][ARCHIVE_MAX_ORDER];
+    lpc_analysis(x, n, lpc);
+
+    int best_order = 0;
+    int best_k = 0;
+    uint64_t best_bits = UINT64_MAX;
+    int16_t best_q[ARCHIVE_MAX_ORDER] = {0};
+
+    for (size_t c = 0; c < sizeof(candidate_orders) / sizeof(candidate_orders[0]); c++) {
+        int order = candidate_orders[c];
+        if (order >= n) break;
+
+        int16_t q[ARCHIVE_MAX_ORDER] = {0};
+        quantize_coeffs(lpc[order], order, q);
+        lpc_residual(x, n, q, order, ar->residual);
+
+        uint64_t bits;
+        int k = rice_parameter(ar->residual, order, n, &bits);
+        bits += (uint64_t)order * 32;  // Coefficients and warm-up samples
+        if (bits < best_bits) {
+            best_bits = bits;
+            best_order = order;
+            best_k = k;
+            memcpy(best_q, q, sizeof(q));
+        }
+    }
+
+    lpc_residual(x, n, best_q, best_order, ar->residual);
+
+    uint8_t *out = ar->block;
+    size_t pos = ARCHIVE_BLOCK_HEADER_BYTES;
+    for (int j = 0; j < best_order; j++, pos += 2) put_u16(out + pos, (uint16_t)best_q[j]);
+    for (int j = 0; j < best_order; j++, pos += 2) put_u16(out + pos, (uint16_t)x[j]);
+
+    bit_writer_t bw = { .out = out + pos };
+    for (int i = best_order; i < n; i++) {
+        uint32_t u = zigzag(ar->residual[i]);
+        uint32_t quotient = u >> best_k;
+        if (quotient >= ARCHIVE_RICE_ESCAPE) {
+            bw_put(&bw, (1u << ARCHIVE_RICE_ESCAPE) - 1, ARCHIVE_RICE_ESCAPE);
+            bw_put(&bw, u >> 16, 16);
+            bw_put(&bw, u & 0xFFFF, 16);
+            continue;
+        }
+        // quotient ones, a zero, then k low bits
+        bw_put(&bw, ((1u << quotient) - 1) << 1, (int)quotient + 1);
+        if (best_k) bw_put(&bw, u & ((1u << best_k) - 1), best_k);
+    }
+    bw_flush(&bw);
+    pos += bw.pos;
+
+    put_u16(out, ARCHIVE_BLOCK_SYNC);
+    put_u16(out + 2, (uint16_t)n);
+    out[4] = (uint8_t)best_order;
+    out[5] = (uint8_t)best_k;
+    put_u16(out + 6, (uint16_t)(pos - ARCHIVE_BLOCK_HEADER_BYTES));
+    return pos;
+}
+
+// Decode one block from `in`; returns samples or -1 if malformed
+static int decode_block(const uint8_t *in, size_t len, int16_t *x) {
+    if (len < ARCHIVE_BLOCK_HEADER_BYTES || get_u16(in) != ARCHIVE_BLOCK_SYNC) return -1;
+
+    int n = get_u16(in + 2);
+    int order = in[4];
+    int k = in[5];
+    size_t payload = get_u16(in + 6);
+    if (n > ARCHIVE_BLOCK_SAMPLES || order > ARCHIVE_MAX_ORDER || order > n ||
+        k > ARCHIVE_MAX_RICE_K || ARCHIVE_BLOCK_HEADER_BYTES + payload > len) {
+        return -1;
+    }
+
+    const uint8_t *p = in + ARCHIVE_BLOCK_HEADER_BYTES;
+    int16_t q[ARCHIVE_MAX_ORDER];
+    for (int j = 0; j < order; j++, p += 2) q[j] = (int16_t)get_u16(p);
+    for (int j = 0; j < order; j++, p += 2) x[j] = (int16_t)get_u16(p);
+
+    bit_reader_t br = { .in = p, .len = payload - (size_t)(p - in - ARCHIVE_BLOCK_HEADER_BYTES) };
+    for (int i = order; i < n; i++) {
+        uint32_t quotient = 0;
+        while (quotient < ARCHIVE_RICE_ESCAPE && br_get(&br, 1)) quotient++;
+
+        uint32_t u;
+        if (quotient == ARCHIVE_RICE_ESCAPE) {
+            u = br_get(&br, 16) << 16;
+            u |= br_get(&br, 16);
+        } else {
+            u = (quotient << k) | (k ? br_get(&br, k) : 0);
+        }
+
+        int32_t acc = 0;
+        for (int j = 0; j < order; j++) acc += q[j] * x[i - 1 - j];
+        x[i] = (int16_t)(unzigzag(u) + (acc >> ARCHIVE_COEFF_SHIFT));
+    }
+
+    return n;
+}
+
+static void write_header(audio_archive_t *ar, uint64_t seek_offset) {
+    uint8_t h[ARCHIVE_HEADER_BYTES];
+    memcpy(h, ARCHIVE_MAGIC, 4);
+    put_u32(h + 4, (uint32_t)ar->sample_rate);
+    put_u32(h + 8, ARCHIVE_BLOCK_SAMPLES);
+    put_u32(h + 12, 0);
+    put_u64(h + 16, ar->start_time_us);
+    put_u64(h + 24, ar->total_samples);
+    put_u64(h + 32, seek_offset);
+    if (pwrite(ar->fd, h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+        fprintf(stderr, "Audio archive header write failed: %s\n", strerror(errno));
+    }
+}
+
+static int flush_block(audio_archive_t *ar) {
+    if (ar->pending_count == 0) return 0;
+
+    if (ar->seek_count == ar->seek_capacity) {
+        uint32_t capacity = ar->seek_capacity ? ar->seek_capacity * 2 : 256;
+        seek_entry_t *seek = realloc(ar->seek, capacity * sizeof(seek_entry_t));
+        if (!seek) return -1;
+        ar->seek = seek;
+        ar->seek_capacity = capacity;
+    }
+    ar->seek[ar->seek_count].sample = ar->total_samples;
+    ar->seek[ar->seek_count].offset = ar->offset;
+    ar->seek_count++;
+
+    size_t len = encode_block(ar, ar->pending, ar->pending_count);
+    ssize_t n = pwrite(ar->fd, ar->block, len, (off_t)ar->offset);
+    if (n != (ssize_t)len) {
+        return -1;
+    }
+
+    ar->offset += len;
+    ar->total_samples += (uint64_t)ar->pending_count;
+    ar->pending_count = 0;
+    return (int)len;
+}
+
+// Writer
+
+audio_archive_t* audio_archive_create(int fd, int sample_rate, uint64_t start_time_us) {
+    if (fd < 0) return NULL;
+
+    audio_archive_t *ar = calloc(1, sizeof(audio_archive_t));
+    if (!ar) {
+        fprintf(stderr, "Failed to allocate audio archive\n");
+        return NULL;
+    }
+
+    ar->fd = fd;
+    ar->sample_rate = sample_rate;
+    ar->start_time_us = start_time_us;
+    ar->offset = ARCHIVE_HEADER_BYTES;
+    write_header(ar, 0);
+
+    return ar;
+}
+
+int audio_archive_write(audio_archive_t *ar, const int16_t *samples, int count) {
+    if (!ar || !samples || count < 0) return -1;
+
+    int done = 0;
+    while (done < count) {
+        int n = ARCHIVE_BLOCK_SAMPLES - ar->pending_count;
+        if (n > count - done) n = count - done;
+        memcpy(ar->pending + ar->pending_count, samples + done, (size_t)n * sizeof(int16_t));
+        ar->pending_count += n;
+        done += n;
+
+        if (ar->pending_count == ARCHIVE_BLOCK_SAMPLES && flush_block(ar) < 0) {
+            return -1;
+        }
+    }
+
+    return count;
+}
+
+uint64_t audio_archive_bytes(const audio_archive_t *ar) {
+    return ar ? ar->offset : 0;
+}
+
+int audio_archive_close(audio_archive_t *ar) {
+    if (!ar) return -1;
+
+    int result = flush_block(ar) < 0 ? -1 : 0;
+
+    // Seek table after the last block, then the final header
+    size_t table_len = 8 + (size_t)ar->seek_count * 16;
+    uint8_t *table = malloc(table_len);
+    if (table) {
+        memcpy(table, ARCHIVE_SEEK_MAGIC, 4);
+        put_u32(table + 4, ar->seek_count);
+        for (uint32_t i = 0; i < ar->seek_count; i++) {
+            put_u64(table + 8 + i * 16, ar->seek[i].sample);
+            put_u64(table + 16 + i * 16, ar->seek[i].offset);
+        }
+        if (pwrite(ar->fd, table, table_len, (off_t)ar->offset) == (ssize_t)table_len) {
+            write_header(ar, ar->offset);
+            ar->offset += table_len;
+        } else {
+            result = -1;
+        }
+        free(table);
+    } else {
+        result = -1;
+    }
+
+    free(ar->seek);
+    free(ar);
+    return result;
+}
+
+// Reader
+
+// Rebuild the seek table by walking block headers (file not closed cleanly)
+static int rescan_blocks(audio_archive_reader_t *rd) {
+    uint64_t offset = ARCHIVE_HEADER_BYTES;
+    uint64_t sample = 0;
+    uint32_t capacity = 0;
+    uint8_t h[ARCHIVE_BLOCK_HEADER_BYTES];
+
+    struct stat st;
+    if (fstat(rd->fd, &st) < 0) return -1;
+
+    // Stop at the first block that is not complete on disk
+    while (pread(rd->fd, h, sizeof(h), (off_t)offset) == (ssize_t)sizeof(h) &&
+           get_u16(h) == ARCHIVE_BLOCK_SYNC &&
+           offset + ARCHIVE_BLOCK_HEADER_BYTES + get_u16(h + 6) <= (uint64_t)st.st_size) {
+        if (rd->seek_count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            seek_entry_t *seek = realloc(rd->seek, capacity * sizeof(seek_entry_t));
+            if (!seek) return -1;
+            rd->seek = seek;
+        }
+        rd->seek[rd->seek_count].sample = sample;
+        rd->seek[rd->seek_count].offset = offset;
+        rd->seek_count++;
+
+        sample += get_u16(h + 2);
+        offset += ARCHIVE_BLOCK_HEADER_BYTES + get_u16(h + 6);
+    }
+
+    rd->total_samples = sample;
+    return 0;
+}
+
+audio_archive_reader_t* audio_archive_open(const char *path) {
+    audio_archive_reader_t *rd = calloc(1, sizeof(audio_archive_reader_t));
+    if (!rd) return NULL;
+
+    rd->fd = open(path, O_RDONLY | O_CLOEXEC);
+    uint8_t h[ARCHIVE_HEADER_BYTES];
+    if (rd->fd < 0 || pread(rd->fd, h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        memcmp(h, ARCHIVE_MAGIC, 4) != 0) {
+        fprintf(stderr, "Not an audio archive: %s\n", path);
+        if (rd->fd >= 0) close(rd->fd);
+        free(rd);
+        return NULL;
+    }
+
+    rd->sample_rate = (int)get_u32(h + 4);
+    rd->block_samples = get_u32(h + 8);
+    rd->start_time_us = get_u64(h + 16);
+    rd->total_samples = get_u64(h + 24);
+    uint64_t seek_offset = get_u64(h + 32);
+
+    bool have_table = false;
+    uint8_t th[8];
+    if (seek_offset && pread(rd->fd, th, sizeof(th), (off_t)seek_offset) == (ssize_t)sizeof(th) &&
+        memcmp(th, ARCHIVE_SEEK_MAGIC, 4) == 0) {
+        uint32_t count = get_u32(th + 4);
+        size_t len = (size_t)count * 16;
+        uint8_t *raw = malloc(len ? len : 1);
+        rd->seek = malloc((count ? count : 1) * sizeof(seek_entry_t));
+        if (raw && rd->seek && pread(rd->fd, raw, len, (off_t)(seek_offset + 8)) == (ssize_t)len) {
+            for (uint32_t i = 0; i < count; i++) {
+                rd->seek[i].sample = get_u64(raw + i * 16);
+                rd->seek[i].offset = get_u64(raw + i * 16 + 8);
+            }
+            rd->seek_count = count;
+            have_table = true;
+        }
+        free(raw);
+    }
+
+    if (!have_table) {
+        free(rd->seek);
+        rd->seek = NULL;
+        rd->seek_count = 0;
+        if (rescan_blocks(rd) < 0) {
+            audio_archive_reader_close(rd);
+            return NULL;
+        }
+    }
+
+    rd->block_index = UINT32_MAX;
+    return rd;
+}
+
+int audio_archive_sample_rate(const audio_archive_reader_t *rd) {
+    return rd ? rd->sample_rate : 0;
+}
+
+uint64_t audio_archive_total_samples(const audio_archive_reader_t *rd) {
+    return rd ? rd->total_samples : 0;
+}
+
+uint64_t audio_archive_start_time(const audio_archive_reader_t *rd) {
+    return rd ? rd->start_time_us : 0;
+}
+
+static int load_block(audio_archive_reader_t *rd, uint32_t index) {
+    uint64_t offset = rd->seek[index].offset;
+    ssize_t n = pread(rd->fd, rd->block, sizeof(rd->block), (off_t)offset);
+    if (n < ARCHIVE_BLOCK_HEADER_BYTES) return -1;
+
+    int count = decode_block(rd->block, (size_t)n, rd->decoded);
+    if (count < 0) return -1;
+
+    rd->block_index = index;
+    rd->decoded_count = count;
+    rd->decoded_pos = 0;
+    return count;
+}
+
+int audio_archive_seek(audio_archive_reader_t *rd, uint64_t sample) {
+    if (!rd || rd->seek_count == 0 || sample >= rd->total_samples) return -1;
+
+    // Last block starting at or before the target
+    uint32_t lo = 0, hi = rd->seek_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (rd->seek[mid].sample <= sample) lo = mid; else hi = mid;
+    }
+
+    if (rd->block_index != lo && load_block(rd, lo) < 0) return -1;
+    rd->decoded_pos = (int)(sample - rd->seek[lo].sample);
+    return 0;
+}
+
+int audio_archive_seek_time(audio_archive_reader_t *rd, uint64_t time_us) {
+    if (!rd || time_us < rd->start_time_us) return -1;
+
+    return audio_archive_seek(rd, (time_us - rd->start_time_us) * (uint64_t)rd->sample_rate / 1000000);
+}
+
+int audio_archive_read(audio_archive_reader_t *rd, int16_t *samples, int count) {
+    if (!rd || !samples || count < 0) return -1;
+
+    if (rd->block_index == UINT32_MAX && rd->seek_count > 0 && load_block(rd, 0) < 0) return -1;
+
+    int done = 0;
+    while (done < count && rd->block_index < rd->seek_count) {
+        if (rd->decoded_pos == rd->decoded_count) {
+            if (rd->block_index + 1 >= rd->seek_count || load_block(rd, rd->block_index + 1) < 0) {
+                break;
+            }
+        }
+
+        int n = rd->decoded_count - rd->decoded_pos;
+        if (n > count - done) n = count - done;
+        memcpy(samples + done, rd->decoded + rd->decoded_pos, (size_t)n * sizeof(int16_t));
+        rd->decoded_pos += n;
+        done += n;
+    }
+
+    return done;
+}
+
+void audio_archive_reader_close(audio_archive_reader_t *rd) {
+    if (!rd) return;
+
+    if (rd->fd >= 0) close(rd->fd);
+    free(rd->seek);
+    free(rd);
+}
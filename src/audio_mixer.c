@@ -0,0 +1,281 @@
+/*
+ * Multi-stream Audio Mixer
+ * One input stream per voice channel slot, mixed into a single playback device
+ *
+ * Each stream owns its codec, a lock-free sample ring and a jitter buffer,
+ * all allocated with the mixer so the SDR thread never allocates when a call
+ * starts (about 11 KB a stream). The SDR thread decodes into a stream; the
+ * playback thread pulls one 20 ms block from every stream and mixes them
+ * with saturating Q15 arithmetic. Streams below the highest priority
+ * currently audible are ducked, and in stereo mode each stream is placed
+ * with a constant-power pan.
+ */
+
+#include "tetra_analyzer.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIXER_STREAM_RING_SIZE 4096    // Per-stream queue (512 ms at 8 kHz)
+#define MIXER_DUCK_GAIN_Q15 8192       // -12 dB for lower-priority streams
+#define MIXER_EMERGENCY_PRIORITY 1000  // Above any talk group priority
+
+typedef struct {
+    // Created with the mixer; the consumer skips the stream until `opened`
+    audio_ring_t *ring;
+    jitter_buffer_t *jitter;
+    tetra_codec_t *codec;
+    _Atomic bool opened;
+
+    // Parameters, written by the producer
+    float gain;
+    float pan;
+    _Atomic uint32_t gains_q15;        // Left gain << 16 | right gain
+    _Atomic int32_t priority;
+
+    // Consumer statistics
+    _Atomic uint64_t frames_mixed;
+    _Atomic uint64_t frames_ducked;
+} mixer_stream_t;
+
+struct audio_mixer {
+    int sample_rate;
+    int channels;
+    mixer_stream_t streams[AUDIO_MIXER_MAX_STREAMS];
+
+    // Consumer scratch
+    int16_t input[AUDIO_MIXER_MAX_STREAMS][AUDIO_MIXER_BLOCK];
+    int16_t mix[AUDIO_MIXER_MAX_CHANNELS][AUDIO_MIXER_BLOCK];
+};
+
+static int16_t gain_to_q15(float gain) {
+    if (gain <= 0.0f) return 0;
+    if (gain >= 1.0f) return 32767;
+    return (int16_t)lrintf(gain * 32768.0f);
+}
+
+// Publish left/right gains for the stream's gain and pan as one word
+static void publish_gains(audio_mixer_t *mixer, mixer_stream_t *st) {
+    float left = st->gain;
+    float right = st->gain;
+
+    if (mixer->channels == 2) {
+        // Constant-power pan law: -1 = hard left, 0 = centre, +1 = hard right
+        float angle = (st->pan + 1.0f) * (float)M_PI / 4.0f;
+        left *= cosf(angle);
+        right *= sinf(angle);
+    }
+
+    uint32_t packed = ((uint32_t)(uint16_t)gain_to_q15(left) << 16) | (uint16_t)gain_to_q15(right);
+    atomic_store_explicit(&st->gains_q15, packed, memory_order_relaxed);
+}
+
+static mixer_stream_t* get_stream(audio_mixer_t *mixer, int stream) {
+    if (!mixer || stream < 0 || stream >= AUDIO_MIXER_MAX_STREAMS) {
+        return NULL;
+    }
+    return &mixer->streams[stream];
+}
+
+audio_mixer_t* audio_mixer_init(int sample_rate, int channels) {
+    if (channels < 1 || channels > AUDIO_MIXER_MAX_CHANNELS) {
+        fprintf(stderr, "Audio mixer supports 1 or 2 output channels (got %d)\n", channels);
+        return NULL;
+    }
+
+    audio_mixer_t *mixer = rt_alloc(RT_POOL_AUDIO, sizeof(audio_mixer_t));
+    if (!mixer) {
+        fprintf(stderr, "Failed to allocate audio mixer\n");
+        return NULL;
+    }
+
+    mixer->sample_rate = sample_rate;
+    mixer->channels = channels;
+
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        mixer_stream_t *st = &mixer->streams[i];
+        atomic_init(&st->opened, false);
+        atomic_init(&st->priority, 0);
+        st->gain = 1.0f;
+        st->pan = 0.0f;
+        publish_gains(mixer, st);
+
+        st->ring = audio_ring_create(MIXER_STREAM_RING_SIZE);
+        st->jitter = st->ring ? jitter_buffer_create(st->ring, sample_rate) : NULL;
+        st->codec = st->jitter ? tetra_codec_init() : NULL;
+        if (!st->codec) {
+            fprintf(stderr, "Failed to allocate audio mixer stream %d\n", i);
+            audio_mixer_cleanup(mixer);
+            return NULL;
+        }
+    }
+
+    log_message(true, "Audio mixer initialized (%d streams with ACELP decoders, %s)\n",
+                AUDIO_MIXER_MAX_STREAMS, channels == 2 ? "stereo" : "mono");
+
+    return mixer;
+}
+
+int audio_mixer_channels(const audio_mixer_t *mixer) {
+    return mixer ? mixer->channels : 0;
+}
+
+int audio_mixer_stream_open(audio_mixer_t *mixer, int stream, int priority, bool emergency) {
+    mixer_stream_t *st = get_stream(mixer, stream);
+    if (!st) {
+        return -1;
+    }
+
+    // Resources outlive calls, so the playback thread never sees them freed.
+    // A new call's speech decoder starts from silence, and arrival timing
+    // from the last call must not set this one's delay
+    if (atomic_load_explicit(&st->opened, memory_order_relaxed)) {
+        tetra_codec_reset(st->codec);
+        jitter_buffer_reset(st->jitter);
+    }
+
+    atomic_store_explicit(&st->priority, emergency ? MIXER_EMERGENCY_PRIORITY : priority,
+                          memory_order_relaxed);
+    atomic_store_explicit(&st->opened, true, memory_order_release);
+    return 0;
+}
+
+void audio_mixer_stream_set_gain(audio_mixer_t *mixer, int stream, float gain) {
+    mixer_stream_t *st = get_stream(mixer, stream);
+    if (!st) return;
+
+    st->gain = gain;
+    publish_gains(mixer, st);
+}
+
+void audio_mixer_stream_set_pan(audio_mixer_t *mixer, int stream, float pan) {
+    mixer_stream_t *st = get_stream(mixer, stream);
+    if (!st) return;
+
+    st->pan = pan < -1.0f ? -1.0f : (pan > 1.0f ? 1.0f : pan);
+    publish_gains(mixer, st);
+}
+
+int audio_mixer_write(audio_mixer_t *mixer, int stream, const int16_t *samples, int count) {
+    mixer_stream_t *st = get_stream(mixer, stream);
+    if (!st || !atomic_load_explicit(&st->opened, memory_order_relaxed)) {
+        return -1;
+    }
+
+    return jitter_buffer_push(st->jitter, samples, count);
+}
+
+int audio_mixer_decode_frame(audio_mixer_t *mixer, int stream, const uint8_t *encoded_bits,
+                             int16_t *audio_samples) {
+    mixer_stream_t *st = get_stream(mixer, stream);
+    if (!st || !atomic_load_explicit(&st->opened, memory_order_relaxed)) {
+        return -1;
+    }
+
+    int decoded = tetra_codec_decode_frame(st->codec, encoded_bits, audio_samples);
+    if (decoded > 0) {
+        jitter_buffer_push(st->jitter, audio_samples, decoded);
+    }
+    return decoded;
+}
+
+int audio_mixer_pull(audio_mixer_t *mixer, int16_t *output) {
+    if (!mixer || !output) {
+        return -1;
+    }
+
+    // Pull one block from every stream and find the top audible priority
+    bool live[AUDIO_MIXER_MAX_STREAMS];
+    int live_count = 0;
+    int32_t top_priority = INT32_MIN;
+
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        mixer_stream_t *st = &mixer->streams[i];
+        live[i] = atomic_load_explicit(&st->opened, memory_order_acquire) &&
+                  jitter_buffer_pull(st->jitter, mixer->input[i]) > 0;
+        if (live[i]) {
+            int32_t prio = atomic_load_explicit(&st->priority, memory_order_relaxed);
+            if (prio > top_priority) top_priority = prio;
+            live_count++;
+        }
+    }
+
+    if (live_count == 0) {
+        return 0;
+    }
+
+    memset(mixer->mix, 0, sizeof(mixer->mix));
+
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        if (!live[i]) continue;
+
+        mixer_stream_t *st = &mixer->streams[i];
+        uint32_t gains = atomic_load_explicit(&st->gains_q15, memory_order_relaxed);
+        int32_t gain_l = (int32_t)(gains >> 16);
+        int32_t gain_r = (int32_t)(gains & 0xFFFF);
+
+        if (atomic_load_explicit(&st->priority, memory_order_relaxed) < top_priority) {
+            gain_l = (gain_l * MIXER_DUCK_GAIN_Q15) >> 15;
+            gain_r = (gain_r * MIXER_DUCK_GAIN_Q15) >> 15;
+            atomic_fetch_add_explicit(&st->frames_ducked, 1, memory_order_relaxed);
+        }
+
+        mix_int16_q15(mixer->mix[0], mixer->input[i], (int16_t)gain_l, AUDIO_MIXER_BLOCK);
+        if (mixer->channels == 2) {
+            mix_int16_q15(mixer->mix[1], mixer->input[i], (int16_t)gain_r, AUDIO_MIXER_BLOCK);
+        }
+        atomic_fetch_add_explicit(&st->frames_mixed, 1, memory_order_relaxed);
+    }
+
+    if (mixer->channels == 2) {
+        for (int n = 0; n < AUDIO_MIXER_BLOCK; n++) {
+            output[2 * n] = mixer->mix[0][n];
+            output[2 * n + 1] = mixer->mix[1][n];
+        }
+    } else {
+        memcpy(output, mixer->mix[0], sizeof(mixer->mix[0]));
+    }
+
+    return AUDIO_MIXER_BLOCK;
+}
+
+uint32_t audio_mixer_write_position(audio_mixer_t *mixer, int stream) {
+    mixer_stream_t *st = get_stream(mixer, stream);
+    return st ? audio_ring_write_position(st->ring) : 0;
+}
+
+uint32_t audio_mixer_read_position(audio_mixer_t *mixer, int stream) {
+    mixer_stream_t *st = get_stream(mixer, stream);
+    return st ? audio_ring_read_position(st->ring) : 0;
+}
+
+void audio_mixer_print_statistics(audio_mixer_t *mixer) {
+    if (!mixer) return;
+
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        mixer_stream_t *st = &mixer->streams[i];
+        if (!atomic_load_explicit(&st->opened, memory_order_acquire)) continue;
+
+        jitter_stats_t js;
+        jitter_buffer_get_stats(st->jitter, &js);
+        log_message(true, "  Stream %2d: %llu frames mixed (%llu ducked), %llu concealed\n", i,
+                    (unsigned long long)atomic_load_explicit(&st->frames_mixed, memory_order_relaxed),
+                    (unsigned long long)atomic_load_explicit(&st->frames_ducked, memory_order_relaxed),
+                    (unsigned long long)js.frames_concealed);
+    }
+}
+
+void audio_mixer_cleanup(audio_mixer_t *mixer) {
+    if (!mixer) return;
+
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        mixer_stream_t *st = &mixer->streams[i];
+        if (st->codec) tetra_codec_cleanup(st->codec);
+        jitter_buffer_destroy(st->jitter);
+        audio_ring_destroy(st->ring);
+    }
+
+    rt_free(mixer);
+}
@@ -96,12 +96,15 @@ void audio_output_cleanup(audio_output_t *audio) {
             long file_size = ftell(audio->output_file);
 
             if (file_size > 44) {
+                // Sizes past 4 GB do not fit; 0xFFFFFFFF marks an open-ended stream
+                bool oversized = file_size - 8 > (long)UINT32_MAX;
+
                 fseek(audio->output_file, 4, SEEK_SET);
-                uint32_t chunk_size = (uint32_t)(file_size - 8);
+                uint32_t chunk_size = oversized ? UINT32_MAX : (uint32_t)(file_size - 8);
                 fwrite(&chunk_size, 4, 1, audio->output_file);
 
                 fseek(audio->output_file, 40, SEEK_SET);
-                uint32_t data_size = (uint32_t)(file_size - 44);
+                uint32_t data_size = oversized ? UINT32_MAX : (uint32_t)(file_size - 44);
                 fwrite(&data_size, 4, 1, audio->output_file);
             }
 
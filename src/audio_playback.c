@@ -1,6 +1,6 @@
 /*
  * Real-time Audio Playback Module
- * ALSA-based real-time audio output with ring buffer
+ * ALSA-based real-time audio output fed by a lock-free sample ring
  *
  * Allows hearing decrypted TETRA audio in real-time during laboratory testing
  */
@@ -13,51 +13,175 @@
 
 #ifdef HAVE_ALSA
 #include <alsa/asoundlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#define PLAYBACK_MAX_PCM_FDS 8
+#define PLAYBACK_IDLE_TIMEOUT_MS 100   // Bounds shutdown latency while idle
+
+// Copy samples straight into the hardware ring (mmap) or through writei
+static int pcm_write(audio_playback_t *playback, const int16_t *samples, int count) {
+    snd_pcm_t *pcm = (snd_pcm_t *)playback->pcm_handle;
+
+    if (!playback->mmap_access) {
+        return (int)snd_pcm_writei(pcm, samples, count);
+    }
+
+    int channels = playback->channels;
+
+    int done = 0;
+    while (done < count) {
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = (snd_pcm_uframes_t)(count - done);
+
+        int err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+        if (err < 0) {
+            return err;
+        }
+
+        // Interleaved S16: every channel's area shares one buffer
+        uint8_t *dst = (uint8_t *)areas[0].addr + areas[0].first / 8 + offset * areas[0].step / 8;
+        memcpy(dst, samples + done * channels, frames * channels * sizeof(int16_t));
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+        if (committed < 0) {
+            return (int)committed;
+        }
+        if ((snd_pcm_uframes_t)committed != frames) {
+            return -EPIPE;
+        }
+        done += (int)frames;
+    }
+
+    return done;
+}
+
+// Top the device buffer up with whole frames from the jitter buffer (or the
+// mixer). Returns false once there is nothing to play.
+static bool fill_pcm(audio_playback_t *playback) {
+    snd_pcm_t *pcm = (snd_pcm_t *)playback->pcm_handle;
+    int16_t frame[JITTER_FRAME_SAMPLES * AUDIO_MIXER_MAX_CHANNELS];
+
+    snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+    if (avail < 0) {
+        // Underrun while idle or a suspended device: recover and refill
+        if (snd_pcm_recover(pcm, (int)avail, 1) < 0) {
+            log_message(true, "ALSA recover failed: %s\n", snd_strerror((int)avail));
+            return false;
+        }
+        avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) {
+            return false;
+        }
+    }
+
+    while (avail >= JITTER_FRAME_SAMPLES) {
+        int count = playback->mixer ? audio_mixer_pull(playback->mixer, frame)
+                                    : jitter_buffer_pull(playback->jitter, frame);
+        if (count <= 0) {
+            return false;
+        }
+
+        int frames = pcm_write(playback, frame, count);
+        if (frames < 0) {
+            frames = snd_pcm_recover(pcm, frames, 0);
+        }
+        if (frames < 0) {
+            log_message(true, "ALSA write error: %s\n", snd_strerror(frames));
+            return false;
+        }
+        avail -= count;
+
+        // The last frame written plays once everything queued before it has
+        if (playback->latency) {
+            snd_pcm_sframes_t delay = 0;
+            if (snd_pcm_delay(pcm, &delay) == 0 && delay >= 0) {
+                uint64_t out_us = get_timestamp_us() +
+                                  (uint64_t)delay * 1000000 / (uint64_t)playback->sample_rate;
+                if (playback->mixer) {
+                    // Every stream advanced by the block just mixed
+                    for (int s = 0; s < AUDIO_MIXER_MAX_STREAMS; s++) {
+                        latency_probe_played(playback->latency, LATENCY_QUEUE_MIXER(s),
+                                             audio_mixer_read_position(playback->mixer, s),
+                                             out_us, playback->sample_rate);
+                    }
+                } else {
+                    latency_probe_played(playback->latency, LATENCY_QUEUE_PLAYOUT,
+                                         audio_ring_read_position(playback->ring), out_us,
+                                         playback->sample_rate);
+                }
+            }
+        }
+    }
+
+    return true;
+}
 #endif
 
 // Playback thread function
+// Playing: sleeps in poll() on the PCM descriptors and wakes once per period
+// to refill. Idle: sleeps on the producer's eventfd until audio arrives.
 static void* playback_thread_func(void *arg) {
 #ifdef HAVE_ALSA
     audio_playback_t *playback = (audio_playback_t *)arg;
     snd_pcm_t *pcm = (snd_pcm_t *)playback->pcm_handle;
-    int16_t temp_buffer[512];  // Small chunks for low latency
+    struct pollfd fds[1 + PLAYBACK_MAX_PCM_FDS];
+
+    thread_policy_apply(THREAD_ROLE_AUDIO, -1);
+
+    int pcm_nfds = snd_pcm_poll_descriptors_count(pcm);
+    if (pcm_nfds <= 0 || pcm_nfds > PLAYBACK_MAX_PCM_FDS) {
+        log_message(true, "ALSA reports %d poll descriptors - playback disabled\n", pcm_nfds);
+        thread_policy_leave();
+        return NULL;
+    }
+
+    fds[0].fd = playback->wake_fd;
+    fds[0].events = POLLIN;
+    snd_pcm_poll_descriptors(pcm, &fds[1], (unsigned int)pcm_nfds);
 
     log_message(true, "Real-time audio playback thread started\n");
 
+    bool playing = false;
     while (playback->running) {
-        pthread_mutex_lock(&playback->buffer_mutex);
-
-        // Calculate available samples in ring buffer
-        int available = 0;
-        if (playback->ring_write_pos >= playback->ring_read_pos) {
-            available = playback->ring_write_pos - playback->ring_read_pos;
+        int ret;
+        if (playing) {
+            ret = poll(&fds[1], (nfds_t)pcm_nfds, -1);
         } else {
-            available = playback->ring_size - playback->ring_read_pos + playback->ring_write_pos;
+            ret = poll(&fds[0], 1, PLAYBACK_IDLE_TIMEOUT_MS);
+        }
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            log_message(true, "Playback poll error: %s\n", strerror(errno));
+            break;
         }
 
-        // Read a chunk if enough data available
-        if (available >= 512) {
-            for (int i = 0; i < 512; i++) {
-                temp_buffer[i] = playback->ring_buffer[playback->ring_read_pos];
-                playback->ring_read_pos = (playback->ring_read_pos + 1) % playback->ring_size;
+        if (playing) {
+            unsigned short revents = 0;
+            snd_pcm_poll_descriptors_revents(pcm, &fds[1], (unsigned int)pcm_nfds, &revents);
+            if (!(revents & (POLLOUT | POLLERR))) {
+                continue;
             }
-            pthread_mutex_unlock(&playback->buffer_mutex);
-
-            // Play the audio
-            int frames = snd_pcm_writei(pcm, temp_buffer, 512);
-            if (frames < 0) {
-                frames = snd_pcm_recover(pcm, frames, 0);
+        } else {
+            if (!(fds[0].revents & POLLIN)) {
+                continue;
             }
-            if (frames < 0) {
-                log_message(true, "ALSA write error: %s\n", snd_strerror(frames));
+            uint64_t wakeups;
+            if (read(playback->wake_fd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
+                log_message(true, "Playback eventfd read error: %s\n", strerror(errno));
             }
-        } else {
-            pthread_mutex_unlock(&playback->buffer_mutex);
-            usleep(10000); // 10ms - wait for more data
         }
+
+        rt_fault_mark_t faults;
+        rt_faults_begin(&faults);
+        playing = fill_pcm(playback);
+        rt_faults_end(&faults, RT_STAGE_PLAYBACK);
     }
 
     log_message(true, "Real-time audio playback thread stopped\n");
+    thread_policy_leave();
 #else
     (void)arg; // Suppress unused parameter warning when ALSA not available
 #endif
@@ -65,7 +189,75 @@ static void* playback_thread_func(void *arg) {
     return NULL;
 }
 
-audio_playback_t* audio_playback_init(int sample_rate) {
+// Release everything audio_playback_init() may have acquired
+static void playback_free(audio_playback_t *playback) {
+#ifdef HAVE_ALSA
+    if (playback->pcm_handle) {
+        snd_pcm_close((snd_pcm_t *)playback->pcm_handle);
+    }
+    if (playback->wake_fd >= 0) {
+        close(playback->wake_fd);
+    }
+#endif
+    jitter_buffer_destroy(playback->jitter);
+    audio_ring_destroy(playback->ring);
+    free(playback);
+}
+
+#ifdef HAVE_ALSA
+// Negotiate interleaved S16 at the requested rate with two periods covering
+// about AUDIO_TARGET_LATENCY_MS, preferring direct mmap access to the device
+// buffer
+static int configure_pcm(audio_playback_t *playback, unsigned int *rate,
+                         snd_pcm_uframes_t *period_size, snd_pcm_uframes_t *buffer_size) {
+    snd_pcm_t *pcm = (snd_pcm_t *)playback->pcm_handle;
+    snd_pcm_hw_params_t *params;
+    snd_pcm_hw_params_alloca(&params);
+    snd_pcm_hw_params_any(pcm, params);
+
+    playback->mmap_access =
+        snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!playback->mmap_access) {
+        int err = snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_RW_INTERLEAVED);
+        if (err < 0) return err;
+    }
+
+    int err = snd_pcm_hw_params_set_format(pcm, params, SND_PCM_FORMAT_S16_LE);
+    if (err < 0) return err;
+    err = snd_pcm_hw_params_set_channels(pcm, params, (unsigned int)playback->channels);
+    if (err < 0) return err;
+    err = snd_pcm_hw_params_set_rate_near(pcm, params, rate, 0);
+    if (err < 0) return err;
+
+    // Low latency buffer settings, in whole jitter buffer frames so each
+    // wakeup has room for the frames fill_pcm() writes
+    snd_pcm_uframes_t frames_per_buffer = (snd_pcm_uframes_t)*rate * AUDIO_TARGET_LATENCY_MS / 1000;
+    snd_pcm_uframes_t period = frames_per_buffer / 2 / JITTER_FRAME_SAMPLES * JITTER_FRAME_SAMPLES;
+    if (period < JITTER_FRAME_SAMPLES) period = JITTER_FRAME_SAMPLES;
+    snd_pcm_uframes_t buffer = 2 * period;
+    snd_pcm_hw_params_set_period_size_near(pcm, params, &period, 0);
+    snd_pcm_hw_params_set_buffer_size_near(pcm, params, &buffer);
+
+    err = snd_pcm_hw_params(pcm, params);
+    if (err < 0) return err;
+
+    snd_pcm_hw_params_get_period_size(params, period_size, 0);
+    snd_pcm_hw_params_get_buffer_size(params, buffer_size);
+
+    // Wake once per period, but never before a whole frame fits: fill_pcm()
+    // writes nothing below that, and poll() would keep returning POLLOUT.
+    // Start as soon as one period is queued
+    snd_pcm_uframes_t avail_min = *period_size > JITTER_FRAME_SAMPLES ? *period_size : JITTER_FRAME_SAMPLES;
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_sw_params_current(pcm, sw);
+    snd_pcm_sw_params_set_avail_min(pcm, sw, avail_min);
+    snd_pcm_sw_params_set_start_threshold(pcm, sw, *period_size);
+    return snd_pcm_sw_params(pcm, sw);
+}
+#endif
+
+audio_playback_t* audio_playback_init(int sample_rate, audio_mixer_t *mixer) {
 #ifdef HAVE_ALSA
     audio_playback_t *playback = calloc(1, sizeof(audio_playback_t));
     if (!playback) {
@@ -74,76 +266,88 @@ audio_playback_t* audio_playback_init(int sample_rate) {
     }
 
     playback->sample_rate = sample_rate;
-    playback->ring_size = AUDIO_RING_BUFFER_SIZE;
-    playback->ring_write_pos = 0;
-    playback->ring_read_pos = 0;
     playback->running = false;
+    playback->wake_fd = -1;
+    playback->mixer = mixer;
+    playback->channels = mixer ? audio_mixer_channels(mixer) : 1;
+
+    // Allocate ring buffer (power of two, shared lock-free with the SDR thread)
+    playback->ring = audio_ring_create(AUDIO_RING_BUFFER_SIZE);
+    if (!playback->ring) {
+        playback_free(playback);
+        return NULL;
+    }
 
-    // Allocate ring buffer
-    playback->ring_buffer = calloc(playback->ring_size, sizeof(int16_t));
-    if (!playback->ring_buffer) {
-        fprintf(stderr, "Failed to allocate audio ring buffer\n");
-        free(playback);
+    playback->jitter = jitter_buffer_create(playback->ring, sample_rate);
+    if (!playback->jitter) {
+        playback_free(playback);
         return NULL;
     }
 
-    // Initialize mutex
-    pthread_mutex_init(&playback->buffer_mutex, NULL);
+    // Producer -> playback thread wakeup while the output is idle
+    playback->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (playback->wake_fd < 0) {
+        fprintf(stderr, "Failed to create playback eventfd: %s\n", strerror(errno));
+        playback_free(playback);
+        return NULL;
+    }
 
     // Open ALSA device
     snd_pcm_t *pcm;
     int err = snd_pcm_open(&pcm, "default", SND_PCM_STREAM_PLAYBACK, 0);
     if (err < 0) {
         fprintf(stderr, "Failed to open ALSA device: %s\n", snd_strerror(err));
-        free(playback->ring_buffer);
-        free(playback);
+        playback_free(playback);
         return NULL;
     }
 
     playback->pcm_handle = pcm;
 
     // Configure ALSA
-    snd_pcm_hw_params_t *params;
-    snd_pcm_hw_params_alloca(&params);
-    snd_pcm_hw_params_any(pcm, params);
-
-    snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(pcm, params, SND_PCM_FORMAT_S16_LE);
-    snd_pcm_hw_params_set_channels(pcm, params, 1);  // Mono
-
     unsigned int rate = sample_rate;
-    snd_pcm_hw_params_set_rate_near(pcm, params, &rate, 0);
-
-    // Low latency buffer settings
-    snd_pcm_uframes_t buffer_size = 4096;
-    snd_pcm_uframes_t period_size = 512;
-    snd_pcm_hw_params_set_buffer_size_near(pcm, params, &buffer_size);
-    snd_pcm_hw_params_set_period_size_near(pcm, params, &period_size, 0);
-
-    err = snd_pcm_hw_params(pcm, params);
+    snd_pcm_uframes_t period_size = 0;
+    snd_pcm_uframes_t buffer_size = 0;
+    err = configure_pcm(playback, &rate, &period_size, &buffer_size);
     if (err < 0) {
         fprintf(stderr, "Failed to set ALSA parameters: %s\n", snd_strerror(err));
-        snd_pcm_close(pcm);
-        free(playback->ring_buffer);
-        free(playback);
+        playback_free(playback);
         return NULL;
     }
 
     snd_pcm_prepare(pcm);
 
-    log_message(true, "✓ Real-time audio playback initialized (%d Hz, ALSA)\n", sample_rate);
+    log_message(true, "✓ Real-time audio playback initialized (%d Hz, %s, ALSA)\n", sample_rate,
+                playback->channels == 2 ? "stereo" : "mono");
+    log_message(true, "  Device buffer: %lu frames in %lu-frame periods (%.1f ms, %s)\n",
+                (unsigned long)buffer_size, (unsigned long)period_size,
+                1000.0f * (float)buffer_size / (float)rate,
+                playback->mmap_access ? "mmap" : "read/write");
     log_message(true, "  Ring buffer: %d samples (%.1f sec)\n",
-                playback->ring_size, (float)playback->ring_size / sample_rate);
+                audio_ring_capacity(playback->ring),
+                (float)audio_ring_capacity(playback->ring) / sample_rate);
 
     return playback;
 #else
     log_message(true, "⚠️  ALSA not available - real-time audio disabled\n");
     log_message(true, "   To enable: sudo apt-get install libasound2-dev && rebuild\n");
     (void)sample_rate;  // Suppress unused warning
+    (void)mixer;
     return NULL;
 #endif
 }
 
+// Wake the playback thread if it is idle
+static void playback_wake(audio_playback_t *playback) {
+#ifdef HAVE_ALSA
+    uint64_t one = 1;
+    if (write(playback->wake_fd, &one, sizeof(one)) < 0) {
+        // EAGAIN: counter saturated, the thread is already due to wake
+    }
+#else
+    (void)playback;
+#endif
+}
+
 void audio_playback_start(audio_playback_t *playback) {
     if (!playback) return;
 
@@ -157,34 +361,57 @@ void audio_playback_stop(audio_playback_t *playback) {
     if (!playback) return;
 
     playback->running = false;
+    playback_wake(playback);
     if (playback->playback_thread) {
         pthread_join(playback->playback_thread, NULL);
     }
 }
 
 int audio_playback_write(audio_playback_t *playback, const int16_t *samples, int count) {
+    return audio_playback_write_tagged(playback, samples, count, NULL);
+}
+
+// As audio_playback_write(), leaving a latency mark for the first sample
+int audio_playback_write_tagged(audio_playback_t *playback, const int16_t *samples, int count,
+                                const latency_tag_t *tag) {
     if (!playback || !samples || count <= 0) {
         return -1;
     }
 
-    pthread_mutex_lock(&playback->buffer_mutex);
-
-    int written = 0;
-    for (int i = 0; i < count; i++) {
-        playback->ring_buffer[playback->ring_write_pos] = samples[i];
-        playback->ring_write_pos = (playback->ring_write_pos + 1) % playback->ring_size;
-        written++;
+    uint32_t position = audio_ring_write_position(playback->ring);
 
-        // Check for buffer overflow
-        if (playback->ring_write_pos == playback->ring_read_pos) {
-            // Buffer full - drop oldest sample
-            playback->ring_read_pos = (playback->ring_read_pos + 1) % playback->ring_size;
-        }
+    // Never blocks: samples that do not fit are dropped and counted as overflow
+    int written = jitter_buffer_push(playback->jitter, samples, count);
+    if (written > 0 && tag && playback->latency) {
+        latency_probe_queue(playback->latency, LATENCY_QUEUE_PLAYOUT, tag, position);
     }
+    playback_wake(playback);
+    return written;
+}
+
+void audio_playback_set_latency_probe(audio_playback_t *playback, latency_probe_t *probe) {
+    if (!playback) return;
 
-    pthread_mutex_unlock(&playback->buffer_mutex);
+    playback->latency = probe;
+}
 
-    return written;
+// Producers feeding the mixer directly call this after queueing audio
+void audio_playback_notify(audio_playback_t *playback) {
+    if (!playback) return;
+
+    playback_wake(playback);
+}
+
+void audio_playback_get_stats(audio_playback_t *playback, audio_ring_stats_t *stats) {
+    if (!playback || !stats) return;
+
+    audio_ring_get_stats(playback->ring, stats);
+}
+
+void audio_playback_get_jitter_stats(audio_playback_t *playback, jitter_stats_t *stats) {
+    if (!playback || !stats) return;
+
+    jitter_buffer_get_stats(playback->jitter, stats);
 }
 
 void audio_playback_cleanup(audio_playback_t *playback) {
@@ -194,14 +421,24 @@ void audio_playback_cleanup(audio_playback_t *playback) {
 #ifdef HAVE_ALSA
         if (playback->pcm_handle) {
             snd_pcm_drain((snd_pcm_t *)playback->pcm_handle);
-            snd_pcm_close((snd_pcm_t *)playback->pcm_handle);
         }
 #endif
 
-        pthread_mutex_destroy(&playback->buffer_mutex);
-        free(playback->ring_buffer);
-        free(playback);
-
-        log_message(true, "Real-time audio playback closed\n");
+        audio_ring_stats_t stats;
+        audio_ring_get_stats(playback->ring, &stats);
+        log_message(true, "Real-time audio playback closed (%llu samples dropped)\n",
+                    (unsigned long long)stats.overflows);
+
+        jitter_stats_t jstats;
+        jitter_buffer_get_stats(playback->jitter, &jstats);
+        log_message(true, "  Playout: %.1f ms jitter, %.1f ms target, %llu concealment events "
+                    "(%llu frames), %llu stretched, %llu compressed\n",
+                    jstats.jitter_ms, jstats.target_ms,
+                    (unsigned long long)jstats.concealment_events,
+                    (unsigned long long)jstats.frames_concealed,
+                    (unsigned long long)jstats.frames_stretched,
+                    (unsigned long long)jstats.frames_compressed);
+
+        playback_free(playback);
     }
 }
@@ -0,0 +1,163 @@
+/*
+ * Lock-free Audio Ring Buffer
+ * Single-producer / single-consumer int16 sample FIFO
+ *
+ * The SDR thread writes decoded speech and the playback thread drains it.
+ * Neither side ever blocks: each index is written by exactly one thread and
+ * published with release/acquire ordering, and every transfer is at most
+ * two memcpy() calls around the wrap point.
+ */
+
+#include "tetra_analyzer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AUDIO_RING_CACHE_LINE 64
+
+struct audio_ring {
+    // Producer-owned cache line; each group starts on its own line
+    _Alignas(AUDIO_RING_CACHE_LINE)
+    _Atomic uint32_t head;             // Total samples written (free-running)
+    _Atomic uint64_t overflows;        // Samples dropped because the ring was full
+
+    // Consumer-owned cache line
+    _Alignas(AUDIO_RING_CACHE_LINE)
+    _Atomic uint32_t tail;             // Total samples read (free-running)
+    _Atomic uint64_t underruns;        // Reads that found the ring drained mid-stream
+    bool streaming;                    // Last read was satisfied (consumer only)
+
+    // Read-only after creation
+    _Alignas(AUDIO_RING_CACHE_LINE)
+    uint32_t size;                     // Capacity in samples, power of two
+    uint32_t mask;
+    int16_t *buffer;
+};
+
+audio_ring_t* audio_ring_create(uint32_t size) {
+    if (size < 2 || (size & (size - 1)) != 0) {
+        fprintf(stderr, "Audio ring size must be a power of two (got %u)\n", size);
+        return NULL;
+    }
+
+    // Pipeline memory is cache-line aligned, as the indices below require
+    audio_ring_t *ring = rt_alloc(RT_POOL_AUDIO, sizeof(audio_ring_t));
+    if (!ring) {
+        fprintf(stderr, "Failed to allocate audio ring\n");
+        return NULL;
+    }
+
+    ring->buffer = rt_alloc(RT_POOL_AUDIO, size * sizeof(int16_t));
+    if (!ring->buffer) {
+        fprintf(stderr, "Failed to allocate audio ring buffer\n");
+        rt_free(ring);
+        return NULL;
+    }
+
+    ring->size = size;
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->overflows, 0);
+    atomic_init(&ring->underruns, 0);
+
+    return ring;
+}
+
+void audio_ring_destroy(audio_ring_t *ring) {
+    if (ring) {
+        rt_free(ring->buffer);
+        rt_free(ring);
+    }
+}
+
+uint32_t audio_ring_capacity(const audio_ring_t *ring) {
+    return ring ? ring->size : 0;
+}
+
+uint32_t audio_ring_available(audio_ring_t *ring) {
+    if (!ring) return 0;
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+int audio_ring_write(audio_ring_t *ring, const int16_t *samples, int count) {
+    if (!ring || !samples || count <= 0) {
+        return -1;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t space = ring->size - (head - tail);
+
+    // The producer cannot move the read index, so a full ring drops the newest
+    // samples rather than the oldest
+    uint32_t n = (uint32_t)count;
+    if (n > space) {
+        atomic_fetch_add_explicit(&ring->overflows, n - space, memory_order_relaxed);
+        n = space;
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    uint32_t pos = head & ring->mask;
+    uint32_t first = ring->size - pos;
+    if (first > n) first = n;
+
+    memcpy(ring->buffer + pos, samples, first * sizeof(int16_t));
+    memcpy(ring->buffer, samples + first, (n - first) * sizeof(int16_t));
+
+    atomic_store_explicit(&ring->head, head + n, memory_order_release);
+    return (int)n;
+}
+
+int audio_ring_read(audio_ring_t *ring, int16_t *samples, int count) {
+    if (!ring || !samples || count <= 0) {
+        return -1;
+    }
+
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t n = (uint32_t)count;
+
+    // Whole chunks only; running dry after a satisfied read is one underrun
+    if (head - tail < n) {
+        if (ring->streaming) {
+            atomic_fetch_add_explicit(&ring->underruns, 1, memory_order_relaxed);
+            ring->streaming = false;
+        }
+        return 0;
+    }
+
+    uint32_t pos = tail & ring->mask;
+    uint32_t first = ring->size - pos;
+    if (first > n) first = n;
+
+    memcpy(samples, ring->buffer + pos, first * sizeof(int16_t));
+    memcpy(samples + first, ring->buffer, (n - first) * sizeof(int16_t));
+
+    atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+    ring->streaming = true;
+    return (int)n;
+}
+
+uint32_t audio_ring_write_position(audio_ring_t *ring) {
+    return ring ? atomic_load_explicit(&ring->head, memory_order_acquire) : 0;
+}
+
+uint32_t audio_ring_read_position(audio_ring_t *ring) {
+    return ring ? atomic_load_explicit(&ring->tail, memory_order_acquire) : 0;
+}
+
+void audio_ring_get_stats(audio_ring_t *ring, audio_ring_stats_t *stats) {
+    if (!ring || !stats) return;
+
+    stats->capacity = ring->size;
+    stats->available = audio_ring_available(ring);
+    stats->overflows = atomic_load_explicit(&ring->overflows, memory_order_relaxed);
+    stats->underruns = atomic_load_explicit(&ring->underruns, memory_order_relaxed);
+}
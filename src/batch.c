@@ -0,0 +1,720 @@
+/*
+ * Offline Batch Processing
+ * Reprocesses a directory of recordings on every core, without a dongle
+ *
+ * Inputs are raw 8-bit IQ recordings (.cu8, .iq, .raw, as written by
+ * rtl_sdr) and burst captures (PREFIX.tbi/.tbc). Each file is cut into
+ * jobs - fixed byte ranges of IQ, or entry ranges of a capture index - and
+ * the jobs are dealt out to per-worker deques. A worker runs its own deque
+ * front to back and, once empty, steals from the back of the others, so
+ * one long recording cannot leave the remaining cores idle.
+ *
+ * Every worker owns its demodulator, detection parameters, codec, TEA1
+ * context and lower MAC, so the hot path shares nothing. Results stay in
+ * per-job arrays until all workers finish, then each kind is sorted by
+ * time and written out: bursts to --capture, control messages to stdout,
+ * decoded audio to -o.
+ */
+
+#include "tetra_analyzer.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BATCH_MAX_PATH 512
+#define BATCH_MAX_WORKERS 64
+#define BATCH_IQ_CHUNK (64 * SDR_BUFFER_SIZE)  // 16 MB, ~3.5 s of IQ at 2.4 Msps
+#define BATCH_BURST_CHUNK 16384                 // Capture entries per job
+#define BATCH_PACKED_BITS ((TETRA_BURST_LENGTH + 7) / 8)
+
+typedef enum {
+    BATCH_SOURCE_IQ,
+    BATCH_SOURCE_BURSTS
+} batch_source_t;
+
+typedef struct {
+    char path[BATCH_MAX_PATH];         // IQ file, or capture prefix
+    batch_source_t source;
+    uint64_t size;                     // Bytes (IQ) or index entries (bursts)
+    uint64_t start_us;                 // IQ: wall clock time of the first sample
+    burst_index_t *index;              // Bursts: read-only mapping shared by all workers
+} batch_file_t;
+
+typedef struct {
+    burst_index_entry_t meta;
+    uint8_t packed[BATCH_PACKED_BITS];
+} batch_burst_t;
+
+typedef struct {
+    uint64_t time_us;
+    ctrl_message_t msg;
+} batch_ctrl_t;
+
+typedef struct {
+    uint64_t time_us;
+    int16_t samples[TETRA_CODEC_SAMPLES];
+} batch_audio_t;
+
+typedef struct {
+    int file;
+    uint64_t begin;                    // Byte offset (IQ) or first entry (bursts)
+    uint64_t end;
+
+    // Results, in time order within the job
+    batch_burst_t *bursts;
+    size_t burst_count, burst_capacity;
+    batch_ctrl_t *ctrl;
+    size_t ctrl_count, ctrl_capacity;
+    batch_audio_t *audio;
+    size_t audio_count, audio_capacity;
+} batch_job_t;
+
+// Job queue of one worker: the owner takes from the head, thieves from the tail
+typedef struct {
+    pthread_mutex_t lock;
+    int *jobs;
+    int head;
+    int tail;
+} batch_deque_t;
+
+typedef struct batch batch_t;
+
+typedef struct {
+    batch_t *batch;
+    int id;
+    pthread_t thread;
+
+    tetra_demod_t *demod;
+    detection_params_t *params;
+    tetra_codec_t *codec;
+    tea1_context_t tea1;
+    lower_mac_t mac;
+    uint8_t *iq;
+
+    uint64_t jobs_run;
+    uint64_t jobs_stolen;
+    bool failed;                       // Ran out of memory storing results
+} batch_worker_t;
+
+struct batch {
+    const tetra_config_t *config;
+    bool want_bursts;
+    bool want_ctrl;
+    bool want_audio;
+
+    batch_file_t *files;
+    int file_count;
+    batch_job_t *jobs;
+    int job_count;
+
+    batch_worker_t workers[BATCH_MAX_WORKERS];
+    batch_deque_t deques[BATCH_MAX_WORKERS];
+    int worker_count;
+};
+
+// Sort key for merging one result kind across jobs
+typedef struct {
+    uint64_t time_us;
+    uint32_t job;
+    uint32_t item;
+} batch_ref_t;
+
+static bool grow(void **items, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    void *p = realloc(*items, new_capacity * size);
+    if (!p) return false;
+
+    *items = p;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool has_suffix(const char *name, const char *suffix) {
+    size_t n = strlen(name);
+    size_t s = strlen(suffix);
+    return n > s && strcmp(name + n - s, suffix) == 0;
+}
+
+static int compare_files(const void *a, const void *b) {
+    return strcmp(((const batch_file_t *)a)->path, ((const batch_file_t *)b)->path);
+}
+
+// Collect IQ recordings and burst captures, in name order
+static int scan_directory(batch_t *batch, const char *dir_path) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        fprintf(stderr, "Failed to open batch directory %s: %s\n", dir_path, strerror(errno));
+        return -1;
+    }
+
+    int capacity = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        batch_source_t source;
+        size_t keep = strlen(de->d_name);
+        if (has_suffix(de->d_name, ".cu8") || has_suffix(de->d_name, ".iq") ||
+            has_suffix(de->d_name, ".raw")) {
+            source = BATCH_SOURCE_IQ;
+        } else if (has_suffix(de->d_name, ".tbi")) {
+            source = BATCH_SOURCE_BURSTS;
+            keep -= 4;
+        } else {
+            continue;
+        }
+
+        if (batch->file_count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            batch_file_t *files = realloc(batch->files, (size_t)capacity * sizeof(batch_file_t));
+            if (!files) {
+                closedir(dir);
+                fprintf(stderr, "Failed to allocate batch file list\n");
+                return -1;
+            }
+            batch->files = files;
+        }
+
+        batch_file_t *f = &batch->files[batch->file_count];
+        memset(f, 0, sizeof(*f));
+        f->source = source;
+        if (snprintf(f->path, sizeof(f->path), "%s/%.*s", dir_path, (int)keep,
+                     de->d_name) >= (int)sizeof(f->path)) {
+            fprintf(stderr, "Skipping %s: path too long\n", de->d_name);
+            continue;
+        }
+        batch->file_count++;
+    }
+    closedir(dir);
+
+    qsort(batch->files, (size_t)batch->file_count, sizeof(batch_file_t), compare_files);
+    return 0;
+}
+
+// Size each input and cut it into jobs
+static int plan_jobs(batch_t *batch) {
+    const tetra_config_t *config = batch->config;
+    int capacity = 0;
+
+    for (int i = 0; i < batch->file_count; i++) {
+        batch_file_t *f = &batch->files[i];
+        uint64_t chunk;
+
+        if (f->source == BATCH_SOURCE_IQ) {
+            struct stat st;
+            if (stat(f->path, &st) < 0) {
+                fprintf(stderr, "Skipping %s: %s\n", f->path, strerror(errno));
+                continue;
+            }
+            f->size = (uint64_t)st.st_size & ~(uint64_t)1;
+
+            // Recordings carry no timestamps: take the file as ending at its mtime
+            uint64_t duration_us = f->size / 2 * 1000000ULL / config->sample_rate;
+            uint64_t mtime_us = (uint64_t)st.st_mtim.tv_sec * 1000000ULL +
+                                (uint64_t)st.st_mtim.tv_nsec / 1000;
+            f->start_us = mtime_us > duration_us ? mtime_us - duration_us : 0;
+            chunk = BATCH_IQ_CHUNK;
+        } else {
+            f->index = burst_index_open(f->path);
+            if (!f->index) {
+                continue;
+            }
+            f->size = burst_index_count(f->index);
+            chunk = BATCH_BURST_CHUNK;
+        }
+
+        for (uint64_t begin = 0; begin < f->size; begin += chunk) {
+            if (batch->job_count == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                batch_job_t *jobs = realloc(batch->jobs, (size_t)capacity * sizeof(batch_job_t));
+                if (!jobs) {
+                    fprintf(stderr, "Failed to allocate batch jobs\n");
+                    return -1;
+                }
+                batch->jobs = jobs;
+            }
+
+            batch_job_t *job = &batch->jobs[batch->job_count++];
+            memset(job, 0, sizeof(*job));
+            job->file = i;
+            job->begin = begin;
+            job->end = begin + chunk < f->size ? begin + chunk : f->size;
+        }
+    }
+
+    return 0;
+}
+
+static bool store_burst(batch_job_t *job, const burst_index_entry_t *meta, const uint8_t *bits) {
+    if (!grow((void **)&job->bursts, &job->burst_capacity, job->burst_count,
+              sizeof(batch_burst_t))) {
+        return false;
+    }
+
+    batch_burst_t *b = &job->bursts[job->burst_count++];
+    b->meta = *meta;
+    memset(b->packed, 0, sizeof(b->packed));
+    for (int i = 0; i < meta->bit_count; i++) {
+        b->packed[i >> 3] |= (uint8_t)((bits[i] & 1) << (7 - (i & 7)));
+    }
+    return true;
+}
+
+// Run the decoders the live pipeline runs on a detected burst
+static bool process_burst(batch_worker_t *w, batch_job_t *job, const burst_index_entry_t *meta,
+                          const uint8_t *bits) {
+    batch_t *batch = w->batch;
+    const tetra_config_t *config = batch->config;
+
+    if (batch->want_bursts && !store_burst(job, meta, bits)) {
+        return false;
+    }
+
+    // Control PDUs: bursts from the control channel, or every burst when none is given
+    uint32_t control_freq = config->trunking.control_channel_freq;
+    if (batch->want_ctrl && (control_freq == 0 || meta->frequency == control_freq)) {
+        ctrl_message_t msg;
+        if (decode_control_burst(&w->mac, config->trunking.raw_control, bits, meta->bit_count,
+                                 meta->sync_offset, &msg)) {
+            if (!grow((void **)&job->ctrl, &job->ctrl_capacity, job->ctrl_count,
+                      sizeof(batch_ctrl_t))) {
+                return false;
+            }
+            msg.timestamp = meta->timestamp_us;
+            job->ctrl[job->ctrl_count].time_us = meta->timestamp_us;
+            job->ctrl[job->ctrl_count].msg = msg;
+            job->ctrl_count++;
+            return true;
+        }
+    }
+
+    if (batch->want_audio && meta->bit_count >= TETRA_CODEC_FRAME_SIZE) {
+        uint8_t encrypted[TETRA_CODEC_FRAME_BYTES];
+        uint8_t decrypted[TETRA_CODEC_FRAME_BYTES];
+
+        memset(encrypted, 0, sizeof(encrypted));
+        for (int i = 0; i < TETRA_CODEC_FRAME_SIZE; i++) {
+            encrypted[i >> 3] |= (uint8_t)((bits[i] & 1) << (7 - (i & 7)));
+        }
+        tea1_decrypt_stream(&w->tea1, encrypted, decrypted, sizeof(encrypted));
+
+        if (!grow((void **)&job->audio, &job->audio_capacity, job->audio_count,
+                  sizeof(batch_audio_t))) {
+            return false;
+        }
+        batch_audio_t *a = &job->audio[job->audio_count];
+        uint64_t trace_start = TRACE_BEGIN();
+        int decoded = tetra_codec_decode_frame(w->codec, decrypted, a->samples);
+        TRACE_END(trace_start, "codec", "decode frame", "seq", job->audio_count,
+                  "samples", decoded, NULL, 0);
+        if (decoded == TETRA_CODEC_SAMPLES) {
+            a->time_us = meta->timestamp_us;
+            job->audio_count++;
+        }
+    }
+
+    return true;
+}
+
+static bool run_iq_job(batch_worker_t *w, batch_job_t *job) {
+    const batch_file_t *f = &w->batch->files[job->file];
+    const tetra_config_t *config = w->batch->config;
+
+    int fd = open(f->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        log_message(true, "Batch: cannot open %s: %s\n", f->path, strerror(errno));
+        return true;
+    }
+    posix_fadvise(fd, (off_t)job->begin, (off_t)(job->end - job->begin), POSIX_FADV_SEQUENTIAL);
+
+    // Same stream time the live pipeline would have stamped, from the file's first sample
+    stream_clock_t clock;
+    stream_clock_init(&clock, config->sample_rate, f->start_us);
+
+    bool ok = true;
+    for (uint64_t offset = job->begin; ok && offset < job->end; offset += SDR_BUFFER_SIZE) {
+        size_t want = job->end - offset < SDR_BUFFER_SIZE ? (size_t)(job->end - offset)
+                                                          : SDR_BUFFER_SIZE;
+        ssize_t got = pread(fd, w->iq, want, (off_t)offset);
+        if (got < 2) break;
+
+        uint64_t seq = offset / SDR_BUFFER_SIZE;
+        uint64_t trace_start = TRACE_BEGIN();
+        int demodulated = tetra_demod_process(w->demod, w->iq, (uint32_t)got);
+        TRACE_END(trace_start, "dsp", "demodulate", "seq", seq, "samples", got / 2,
+                  "bits", demodulated);
+        if (demodulated <= 0) continue;
+
+        trace_start = TRACE_BEGIN();
+        bool detected = tetra_detect_burst(w->demod);
+        TRACE_END(trace_start, "dsp", "burst detect", "seq", seq, "bursts", detected,
+                  "power", w->demod->signal_power);
+        if (!detected) continue;
+
+        burst_index_entry_t meta;
+        memset(&meta, 0, sizeof(meta));
+        meta.timestamp_us = stream_clock_time_us(&clock, offset / 2 +
+                                                 (uint64_t)tetra_demod_sync_sample(w->demod));
+        meta.frequency = config->frequency;
+        meta.correlation = w->demod->sync_correlation;
+        meta.power = w->demod->signal_power;
+        meta.sync_offset = w->demod->sync_offset;
+        meta.bit_count = (uint16_t)w->demod->bit_count;
+
+        ok = process_burst(w, job, &meta, w->demod->demod_bits);
+    }
+
+    close(fd);
+    return ok;
+}
+
+static bool run_burst_job(batch_worker_t *w, batch_job_t *job) {
+    const batch_file_t *f = &w->batch->files[job->file];
+    uint8_t bits[TETRA_BURST_LENGTH];
+
+    for (uint64_t i = job->begin; i < job->end; i++) {
+        const burst_index_entry_t *e = burst_index_entry(f->index, i);
+        if (!e) continue;
+
+        // A corrupt entry must not reach the fixed-size burst buffers
+        if (e->bit_count > TETRA_BURST_LENGTH) {
+            LOG_AT(LOG_LEVEL_WARN, 1, "Batch: %s burst %llu has %u bits, skipped\n", f->path,
+                   (unsigned long long)i, e->bit_count);
+            continue;
+        }
+        if (burst_index_bits(f->index, i, bits) < 0) continue;
+
+        if (!process_burst(w, job, e, bits)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Own deque first (head), then steal from the tail of the others
+static int next_job(batch_worker_t *w) {
+    batch_t *batch = w->batch;
+
+    for (int k = 0; k < batch->worker_count; k++) {
+        batch_deque_t *dq = &batch->deques[(w->id + k) % batch->worker_count];
+        int job = -1;
+
+        pthread_mutex_lock(&dq->lock);
+        if (dq->head < dq->tail) {
+            job = k == 0 ? dq->jobs[dq->head++] : dq->jobs[--dq->tail];
+        }
+        pthread_mutex_unlock(&dq->lock);
+
+        if (job >= 0) {
+            if (k != 0) w->jobs_stolen++;
+            return job;
+        }
+    }
+
+    // Jobs are only ever removed, so empty deques everywhere means done
+    return -1;
+}
+
+static void* batch_worker_func(void *arg) {
+    batch_worker_t *w = (batch_worker_t *)arg;
+    int job;
+
+    thread_policy_apply(THREAD_ROLE_BATCH, w->id);
+
+    while ((job = next_job(w)) >= 0) {
+        batch_job_t *j = &w->batch->jobs[job];
+
+        // Jobs start from a clean decoder: they may come from any file
+        tetra_codec_reset(w->codec);
+
+        bool ok = w->batch->files[j->file].source == BATCH_SOURCE_IQ ? run_iq_job(w, j)
+                                                                    : run_burst_job(w, j);
+        if (!ok) {
+            w->failed = true;
+            break;
+        }
+        w->jobs_run++;
+    }
+
+    thread_policy_leave();
+    return NULL;
+}
+
+static int init_worker(batch_t *batch, int id) {
+    const tetra_config_t *config = batch->config;
+    batch_worker_t *w = &batch->workers[id];
+
+    w->batch = batch;
+    w->id = id;
+
+    // Private copy of the detection parameters: no lock shared between workers
+    w->params = detection_params_init();
+    if (!w->params) return -1;
+    w->params->min_signal_power = config->squelch_threshold;
+
+    w->demod = tetra_demod_init(config->sample_rate, w->params, NULL, config->squelch_threshold);
+    w->codec = tetra_codec_init();
+    w->iq = rt_alloc(RT_POOL_BATCH, SDR_BUFFER_SIZE);
+    if (!w->demod || !w->codec || !w->iq) {
+        return -1;
+    }
+
+    uint8_t key[TEA1_KEY_SIZE] = {0};
+    tea1_init(&w->tea1, key, config->use_known_vulnerability);
+    lower_mac_init(&w->mac, config->trunking.mcc, config->trunking.mnc,
+                   config->trunking.colour_code);
+
+    batch_deque_t *dq = &batch->deques[id];
+    pthread_mutex_init(&dq->lock, NULL);
+
+    // Contiguous share of the jobs keeps each worker reading sequentially
+    int first = (int)((int64_t)batch->job_count * id / batch->worker_count);
+    int last = (int)((int64_t)batch->job_count * (id + 1) / batch->worker_count);
+    dq->jobs = malloc((size_t)(last - first + 1) * sizeof(int));
+    if (!dq->jobs) return -1;
+    for (int j = first; j < last; j++) {
+        dq->jobs[dq->tail++] = j;
+    }
+
+    return 0;
+}
+
+static int compare_refs(const void *a, const void *b) {
+    const batch_ref_t *x = a;
+    const batch_ref_t *y = b;
+    if (x->time_us != y->time_us) return x->time_us < y->time_us ? -1 : 1;
+    if (x->job != y->job) return x->job < y->job ? -1 : 1;
+    return x->item < y->item ? -1 : (x->item > y->item);
+}
+
+// Time-ordered references to one kind of result across all jobs
+static batch_ref_t* merge_results(const batch_t *batch, size_t offset_count, size_t offset_items,
+                                  size_t item_size, size_t *total) {
+    *total = 0;
+    for (int j = 0; j < batch->job_count; j++) {
+        *total += *(const size_t *)((const uint8_t *)&batch->jobs[j] + offset_count);
+    }
+
+    batch_ref_t *refs = malloc((*total ? *total : 1) * sizeof(batch_ref_t));
+    if (!refs) return NULL;
+
+    size_t n = 0;
+    for (int j = 0; j < batch->job_count; j++) {
+        const uint8_t *job = (const uint8_t *)&batch->jobs[j];
+        size_t count = *(const size_t *)(job + offset_count);
+        const uint8_t *items = *(uint8_t *const *)(job + offset_items);
+        for (size_t i = 0; i < count; i++) {
+            // Every result kind begins with its timestamp
+            memcpy(&refs[n].time_us, items + i * item_size, sizeof(uint64_t));
+            refs[n].job = (uint32_t)j;
+            refs[n].item = (uint32_t)i;
+            n++;
+        }
+    }
+
+    qsort(refs, n, sizeof(batch_ref_t), compare_refs);
+    return refs;
+}
+
+static int write_outputs(batch_t *batch) {
+    const tetra_config_t *config = batch->config;
+    int ret = 0;
+    size_t n;
+
+    if (batch->want_bursts) {
+        batch_ref_t *refs = merge_results(batch, offsetof(batch_job_t, burst_count),
+                                          offsetof(batch_job_t, bursts), sizeof(batch_burst_t), &n);
+        burst_capture_t *cap = refs ? burst_capture_create(config->capture_prefix) : NULL;
+        if (cap) {
+            uint8_t bits[TETRA_BURST_LENGTH];
+            for (size_t i = 0; i < n; i++) {
+                const batch_burst_t *b = &batch->jobs[refs[i].job].bursts[refs[i].item];
+                for (int k = 0; k < b->meta.bit_count; k++) {
+                    bits[k] = (b->packed[k >> 3] >> (7 - (k & 7))) & 1;
+                }
+                burst_capture_write(cap, &b->meta, bits, NULL);
+            }
+            burst_capture_close(cap);
+        } else {
+            ret = -1;
+        }
+        free(refs);
+    }
+
+    if (batch->want_ctrl) {
+        batch_ref_t *refs = merge_results(batch, offsetof(batch_job_t, ctrl_count),
+                                          offsetof(batch_job_t, ctrl), sizeof(batch_ctrl_t), &n);
+        if (refs) {
+            // Results, not diagnostics: print directly so none are dropped or rate limited
+            log_flush();
+            for (size_t i = 0; i < n; i++) {
+                const batch_ctrl_t *c = &batch->jobs[refs[i].job].ctrl[refs[i].item];
+                printf("[%llu.%06llu] %s TG=%u SRC=%u DST=%u FREQ=%u%s%s\n",
+                       (unsigned long long)(c->time_us / 1000000),
+                       (unsigned long long)(c->time_us % 1000000),
+                       ctrl_msg_type_to_string(c->msg.type), c->msg.talk_group_id,
+                       c->msg.source_id, c->msg.dest_id, c->msg.channel_freq,
+                       c->msg.encrypted ? " encrypted" : "",
+                       c->msg.emergency ? " EMERGENCY" : "");
+            }
+        } else {
+            ret = -1;
+        }
+        free(refs);
+    }
+
+    if (batch->want_audio) {
+        batch_ref_t *refs = merge_results(batch, offsetof(batch_job_t, audio_count),
+                                          offsetof(batch_job_t, audio), sizeof(batch_audio_t), &n);
+        audio_output_t *out = refs ? audio_output_init(config->output_file,
+                                                       TETRA_AUDIO_SAMPLE_RATE) : NULL;
+        if (out) {
+            for (size_t i = 0; i < n; i++) {
+                const batch_audio_t *a = &batch->jobs[refs[i].job].audio[refs[i].item];
+                audio_output_write(out, a->samples, TETRA_CODEC_SAMPLES);
+            }
+            audio_output_cleanup(out);
+            log_message(true, "Batch audio: %.1f s written to %s\n",
+                        (double)n * TETRA_CODEC_SAMPLES / TETRA_AUDIO_SAMPLE_RATE,
+                        config->output_file);
+        } else {
+            ret = -1;
+        }
+        free(refs);
+    }
+
+    return ret;
+}
+
+static void batch_free(batch_t *batch) {
+    for (int i = 0; i < batch->worker_count; i++) {
+        batch_worker_t *w = &batch->workers[i];
+        if (w->demod) tetra_demod_cleanup(w->demod);
+        if (w->params) detection_params_cleanup(w->params);
+        if (w->codec) tetra_codec_cleanup(w->codec);
+        rt_free(w->iq);
+        if (batch->deques[i].jobs) {
+            pthread_mutex_destroy(&batch->deques[i].lock);
+            free(batch->deques[i].jobs);
+        }
+    }
+    for (int j = 0; j < batch->job_count; j++) {
+        free(batch->jobs[j].bursts);
+        free(batch->jobs[j].ctrl);
+        free(batch->jobs[j].audio);
+    }
+    for (int i = 0; i < batch->file_count; i++) {
+        burst_index_close(batch->files[i].index);
+    }
+    free(batch->jobs);
+    free(batch->files);
+    free(batch);
+}
+
+int batch_run(const tetra_config_t *config) {
+    batch_t *batch = calloc(1, sizeof(batch_t));
+    if (!batch) {
+        fprintf(stderr, "Failed to allocate batch state\n");
+        return -1;
+    }
+
+    batch->config = config;
+    batch->want_bursts = config->capture_prefix != NULL;
+    batch->want_ctrl = true;
+    batch->want_audio = config->output_file != NULL && config->use_known_vulnerability;
+
+    if (config->output_file && !config->use_known_vulnerability) {
+        log_message(true, "Batch: -o needs -k to decrypt voice; no audio will be written\n");
+    }
+
+    // Scan before any output is created, so our own outputs are never inputs
+    if (scan_directory(batch, config->batch_dir) < 0 || plan_jobs(batch) < 0) {
+        batch_free(batch);
+        return -1;
+    }
+
+    if (batch->job_count == 0) {
+        log_message(true, "Batch: no IQ recordings (.cu8/.iq/.raw) or burst captures (.tbi) in %s\n",
+                    config->batch_dir);
+        batch_free(batch);
+        return 0;
+    }
+
+    int workers = config->batch_jobs > 0 ? config->batch_jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+    if (workers > BATCH_MAX_WORKERS) workers = BATCH_MAX_WORKERS;
+    if (workers > batch->job_count) workers = batch->job_count;
+    batch->worker_count = workers;
+
+    for (int i = 0; i < workers; i++) {
+        if (init_worker(batch, i) < 0) {
+            fprintf(stderr, "Failed to initialize batch worker %d\n", i);
+            batch_free(batch);
+            return -1;
+        }
+    }
+
+    log_message(true, "Batch: %d files, %d jobs, %d workers\n", batch->file_count,
+                batch->job_count, workers);
+
+    uint64_t start = get_timestamp_us();
+
+    int started = 0;
+    for (; started < workers; started++) {
+        if (pthread_create(&batch->workers[started].thread, NULL, batch_worker_func,
+                           &batch->workers[started]) != 0) {
+            fprintf(stderr, "Failed to start batch worker %d\n", started);
+            break;
+        }
+    }
+    if (started == 0) {
+        batch_free(batch);
+        return -1;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(batch->workers[i].thread, NULL);
+    }
+
+    double elapsed = (get_timestamp_us() - start) / 1e6;
+
+    uint64_t iq_bytes = 0;
+    uint64_t captured = 0;
+    for (int i = 0; i < batch->file_count; i++) {
+        if (batch->files[i].source == BATCH_SOURCE_IQ) {
+            iq_bytes += batch->files[i].size;
+        } else {
+            captured += batch->files[i].size;
+        }
+    }
+
+    bool failed = false;
+    uint64_t jobs_run = 0;
+    for (int i = 0; i < workers; i++) {
+        batch_worker_t *w = &batch->workers[i];
+        log_message(config->verbose, "  Worker %2d: %llu jobs (%llu stolen)\n", i,
+                    (unsigned long long)w->jobs_run, (unsigned long long)w->jobs_stolen);
+        jobs_run += w->jobs_run;
+        failed |= w->failed;
+    }
+
+    log_message(true, "Batch: %llu/%d jobs in %.2f s - %.1f MB IQ (%.1fx real time), "
+                "%llu captured bursts\n",
+                (unsigned long long)jobs_run, batch->job_count, elapsed,
+                iq_bytes / (1024.0 * 1024.0),
+                elapsed > 0 ? (iq_bytes / 2.0 / config->sample_rate) / elapsed : 0.0,
+                (unsigned long long)captured);
+
+    if (failed) {
+        fprintf(stderr, "Batch: out of memory storing results; outputs are incomplete\n");
+    }
+
+    int ret = write_outputs(batch);
+    batch_free(batch);
+    return failed ? -1 : ret;
+}
@@ -0,0 +1,566 @@
+/*
+ * Raw Burst Capture
+ * Append-only store of detected bursts with a fixed-record sidecar index
+ *
+ * A capture is two files sharing a prefix (host byte order):
+ *   PREFIX.tbc  data    "TBC1", version, creation time, then one record
+ *                       per burst: sync word, bit count, flags, the hard
+ *                       bits packed MSB first and, if flagged, one signed
+ *                       soft bit per hard bit
+ *   PREFIX.tbi  index   "TBI1", entry size, reserved, then one
+ *                       burst_index_entry_t per record in capture order
+ *
+ * Index entries are fixed size and naturally aligned, so readers mmap the
+ * index and use it as an array: time queries binary search it, frequency
+ * and talk group filters scan it without touching the data file. Both
+ * files are only ever appended to, and the writer flushes data before the
+ * index, so an index entry never refers to a record that is not on disk.
+ *
+ * The SDR thread only packs records into batches from a small pre-faulted
+ * pool and hands full ones to a writer thread, which does every write(),
+ * as the call recorder does. When no batch is free a live capture drops the
+ * burst and counts it; an offline one (batch mode) waits for the writer.
+ */
+
+#include "tetra_analyzer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CAPTURE_DATA_MAGIC "TBC1"
+#define CAPTURE_INDEX_MAGIC "TBI1"
+#define CAPTURE_VERSION 1
+#define CAPTURE_HEADER_BYTES 16
+#define CAPTURE_RECORD_SYNC 0xB5C3
+#define CAPTURE_RECORD_HEADER_BYTES 8
+#define CAPTURE_DATA_BUFFER (64 * 1024)
+#define CAPTURE_INDEX_BUFFER 256       // Entries held before an index flush
+#define CAPTURE_BATCH_COUNT 4          // Batches in flight
+#define CAPTURE_MAX_PATH 512
+
+// One write() of records, and one of the index entries that refer to them
+typedef struct {
+    uint8_t data[CAPTURE_DATA_BUFFER];
+    size_t data_len;
+    burst_index_entry_t index[CAPTURE_INDEX_BUFFER];
+    int index_len;
+} capture_batch_t;
+
+struct burst_capture {
+    int data_fd;                       // Writer thread only once it runs
+    int index_fd;
+    bool wait;                         // Offline: wait for a batch rather than drop
+    uint64_t data_offset;              // File offset of the next record
+    uint64_t count;                    // Entries in the index, including queued ones
+
+    capture_batch_t *batches;
+    capture_batch_t *current;          // Being filled by the capture thread
+
+    // Capture -> writer full batches and writer -> capture empty ones; each
+    // holds at most CAPTURE_BATCH_COUNT, so neither ever fills
+    capture_batch_t *full[CAPTURE_BATCH_COUNT];
+    _Alignas(64) _Atomic uint32_t full_head;
+    _Alignas(64) _Atomic uint32_t full_tail;
+    capture_batch_t *empty[CAPTURE_BATCH_COUNT];
+    _Alignas(64) _Atomic uint32_t empty_head;
+    _Alignas(64) _Atomic uint32_t empty_tail;
+
+    sem_t wakeup;                      // Batch queued, or closing
+    sem_t returned;                    // Batch emptied; posted only when waiting
+    pthread_t thread;
+    bool started;
+    _Atomic bool running;
+
+    _Atomic uint64_t dropped;          // Bursts no batch was free for
+    _Atomic uint64_t write_errors;
+};
+
+struct burst_index {
+    const uint8_t *data;
+    size_t data_size;
+    const uint8_t *index_map;
+    size_t index_size;
+    const burst_index_entry_t *entries;
+    uint64_t count;
+};
+
+static size_t record_bytes(uint16_t bit_count, uint16_t flags) {
+    size_t bytes = CAPTURE_RECORD_HEADER_BYTES + (bit_count + 7) / 8;
+    if (flags & BURST_FLAG_SOFT) {
+        bytes += bit_count;
+    }
+    return bytes;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Write the header of a new file, or check an existing one and return its size
+static int prepare_file(int fd, const char *magic, uint32_t field, uint64_t *size) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return -1;
+    }
+
+    uint8_t header[CAPTURE_HEADER_BYTES];
+    if (st.st_size == 0) {
+        uint64_t now = get_timestamp_us();
+        memset(header, 0, sizeof(header));
+        memcpy(header, magic, 4);
+        memcpy(header + 4, &field, 4);
+        memcpy(header + 8, &now, 8);
+        if (write_all(fd, header, sizeof(header)) < 0) {
+            return -1;
+        }
+        *size = CAPTURE_HEADER_BYTES;
+        return 0;
+    }
+
+    uint32_t stored;
+    if (pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header, magic, 4) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(&stored, header + 4, 4);
+    if (stored != field) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    *size = (uint64_t)st.st_size;
+    return 0;
+}
+
+static int open_capture_file(const char *prefix, const char *ext, int flags) {
+    char path[CAPTURE_MAX_PATH];
+    if (snprintf(path, sizeof(path), "%s%s", prefix, ext) >= (int)sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return open(path, flags | O_CLOEXEC, 0644);
+}
+
+static void put_batch(capture_batch_t **ring, _Atomic uint32_t *head, capture_batch_t *b) {
+    uint32_t h = atomic_load_explicit(head, memory_order_relaxed);
+    ring[h % CAPTURE_BATCH_COUNT] = b;
+    atomic_store_explicit(head, h + 1, memory_order_release);
+}
+
+static capture_batch_t* get_batch(capture_batch_t **ring, _Atomic uint32_t *head,
+                                  _Atomic uint32_t *tail) {
+    uint32_t t = atomic_load_explicit(tail, memory_order_relaxed);
+    uint32_t h = atomic_load_explicit(head, memory_order_acquire);
+    if (t == h) {
+        return NULL;
+    }
+
+    capture_batch_t *b = ring[t % CAPTURE_BATCH_COUNT];
+    atomic_store_explicit(tail, t + 1, memory_order_release);
+    return b;
+}
+
+// Writer thread: data first, so entries never point past the end of the data file
+static void write_batch(burst_capture_t *cap, capture_batch_t *b) {
+    if (write_all(cap->data_fd, b->data, b->data_len) < 0 ||
+        write_all(cap->index_fd, b->index, (size_t)b->index_len * sizeof(burst_index_entry_t)) < 0) {
+        atomic_fetch_add_explicit(&cap->write_errors, 1, memory_order_relaxed);
+        LOG_AT(LOG_LEVEL_WARN, 1, "Burst capture write error: %s\n", strerror(errno));
+    }
+    b->data_len = 0;
+    b->index_len = 0;
+}
+
+static void* writer_thread_func(void *arg) {
+    burst_capture_t *cap = (burst_capture_t *)arg;
+    capture_batch_t *b;
+
+    thread_policy_apply(THREAD_ROLE_RECORDER, -1);
+
+    for (;;) {
+        sem_wait(&cap->wakeup);
+
+        while ((b = get_batch(cap->full, &cap->full_head, &cap->full_tail)) != NULL) {
+            write_batch(cap, b);
+            put_batch(cap->empty, &cap->empty_head, b);
+            if (cap->wait) sem_post(&cap->returned);
+        }
+
+        if (!atomic_load_explicit(&cap->running, memory_order_acquire)) {
+            break;
+        }
+    }
+
+    thread_policy_leave();
+    return NULL;
+}
+
+static burst_capture_t* open_writer(const char *prefix, int flags, bool wait) {
+    burst_capture_t *cap = calloc(1, sizeof(burst_capture_t));
+    if (!cap) {
+        fprintf(stderr, "Failed to allocate burst capture\n");
+        return NULL;
+    }
+    cap->wait = wait;
+
+    cap->data_fd = open_capture_file(prefix, ".tbc", O_RDWR | O_CREAT | O_APPEND | flags);
+    cap->index_fd = open_capture_file(prefix, ".tbi", O_RDWR | O_CREAT | O_APPEND | flags);
+    if (cap->data_fd < 0 || cap->index_fd < 0) {
+        fprintf(stderr, "Failed to open burst capture %s: %s\n", prefix, strerror(errno));
+        burst_capture_close(cap);
+        return NULL;
+    }
+
+    uint64_t index_size;
+    if (prepare_file(cap->data_fd, CAPTURE_DATA_MAGIC, CAPTURE_VERSION, &cap->data_offset) < 0 ||
+        prepare_file(cap->index_fd, CAPTURE_INDEX_MAGIC, sizeof(burst_index_entry_t),
+                     &index_size) < 0) {
+        fprintf(stderr, "Burst capture %s is not a compatible capture: %s\n", prefix,
+                strerror(errno));
+        burst_capture_close(cap);
+        return NULL;
+    }
+
+    // Drop a partial entry left by an interrupted append
+    uint64_t entries = (index_size - CAPTURE_HEADER_BYTES) / sizeof(burst_index_entry_t);
+    uint64_t whole = CAPTURE_HEADER_BYTES + entries * sizeof(burst_index_entry_t);
+    if (whole != index_size && ftruncate(cap->index_fd, (off_t)whole) < 0) {
+        fprintf(stderr, "Failed to repair burst index %s.tbi: %s\n", prefix, strerror(errno));
+        burst_capture_close(cap);
+        return NULL;
+    }
+    cap->count = entries;
+
+    cap->batches = rt_alloc(RT_POOL_RECORDER, CAPTURE_BATCH_COUNT * sizeof(capture_batch_t));
+    if (!cap->batches) {
+        fprintf(stderr, "Failed to allocate burst capture buffers\n");
+        burst_capture_close(cap);
+        return NULL;
+    }
+    for (int i = 0; i < CAPTURE_BATCH_COUNT; i++) {
+        put_batch(cap->empty, &cap->empty_head, &cap->batches[i]);
+    }
+
+    sem_init(&cap->wakeup, 0, 0);
+    sem_init(&cap->returned, 0, 0);
+    atomic_init(&cap->running, true);
+    if (pthread_create(&cap->thread, NULL, writer_thread_func, cap) != 0) {
+        fprintf(stderr, "Failed to start burst capture writer\n");
+        sem_destroy(&cap->wakeup);
+        sem_destroy(&cap->returned);
+        burst_capture_close(cap);
+        return NULL;
+    }
+    cap->started = true;
+
+    log_message(true, "Burst capture: %s.tbc / %s.tbi (%llu bursts already stored)\n",
+                prefix, prefix, (unsigned long long)entries);
+
+    return cap;
+}
+
+// Live capture: append to the capture at prefix, creating it if there is none
+burst_capture_t* burst_capture_open(const char *prefix) {
+    return open_writer(prefix, 0, false);
+}
+
+// Offline capture: start a new one at prefix, replacing any existing one
+// (appending a second pass would put its bursts out of time order), and
+// never drop a burst
+burst_capture_t* burst_capture_create(const char *prefix) {
+    return open_writer(prefix, O_TRUNC, true);
+}
+
+// Capture thread: hand the current batch to the writer
+static void submit_batch(burst_capture_t *cap) {
+    if (!cap->current || cap->current->data_len == 0) return;
+
+    put_batch(cap->full, &cap->full_head, cap->current);
+    sem_post(&cap->wakeup);
+    cap->current = NULL;
+}
+
+static capture_batch_t* take_batch(burst_capture_t *cap) {
+    for (;;) {
+        capture_batch_t *b = get_batch(cap->empty, &cap->empty_head, &cap->empty_tail);
+        if (b || !cap->wait) return b;
+        sem_wait(&cap->returned);
+    }
+}
+
+int burst_capture_write(burst_capture_t *cap, const burst_index_entry_t *meta,
+                        const uint8_t *bits, const int8_t *soft) {
+    if (!cap || !meta || !bits) {
+        return -1;
+    }
+
+    uint16_t flags = soft ? BURST_FLAG_SOFT : 0;
+    size_t len = record_bytes(meta->bit_count, flags);
+    if (len > CAPTURE_DATA_BUFFER) {
+        return -1;
+    }
+
+    capture_batch_t *b = cap->current;
+    if (b && (b->index_len == CAPTURE_INDEX_BUFFER || b->data_len + len > CAPTURE_DATA_BUFFER)) {
+        submit_batch(cap);
+        b = NULL;
+    }
+    if (!b) {
+        b = cap->current = take_batch(cap);
+        if (!b) {
+            // Writer is behind: drop rather than stall the SDR thread
+            atomic_fetch_add_explicit(&cap->dropped, 1, memory_order_relaxed);
+            return -1;
+        }
+    }
+
+    uint8_t *rec = b->data + b->data_len;
+    uint16_t sync = CAPTURE_RECORD_SYNC;
+    uint16_t reserved = 0;
+    memcpy(rec, &sync, 2);
+    memcpy(rec + 2, &meta->bit_count, 2);
+    memcpy(rec + 4, &flags, 2);
+    memcpy(rec + 6, &reserved, 2);
+
+    // Hard bits, eight to a byte, MSB first
+    uint8_t *packed = rec + CAPTURE_RECORD_HEADER_BYTES;
+    int packed_bytes = (meta->bit_count + 7) / 8;
+    memset(packed, 0, (size_t)packed_bytes);
+    for (int i = 0; i < meta->bit_count; i++) {
+        packed[i >> 3] |= (uint8_t)((bits[i] & 1) << (7 - (i & 7)));
+    }
+    if (soft) {
+        memcpy(packed + packed_bytes, soft, meta->bit_count);
+    }
+
+    burst_index_entry_t *entry = &b->index[b->index_len++];
+    *entry = *meta;
+    entry->data_offset = cap->data_offset;
+    entry->flags = flags;
+
+    b->data_len += len;
+    cap->data_offset += len;
+    cap->count++;
+    return 0;
+}
+
+uint64_t burst_capture_count(const burst_capture_t *cap) {
+    return cap ? cap->count : 0;
+}
+
+void burst_capture_close(burst_capture_t *cap) {
+    if (!cap) return;
+
+    if (cap->started) {
+        // The writer drains every queued batch before it exits
+        submit_batch(cap);
+        atomic_store_explicit(&cap->running, false, memory_order_release);
+        sem_post(&cap->wakeup);
+        pthread_join(cap->thread, NULL);
+        sem_destroy(&cap->wakeup);
+        sem_destroy(&cap->returned);
+
+        log_message(true, "Burst capture closed (%llu bursts, %.1f MB, %llu dropped, "
+                    "%llu write errors)\n", (unsigned long long)cap->count,
+                    cap->data_offset / (1024.0 * 1024.0),
+                    (unsigned long long)atomic_load(&cap->dropped),
+                    (unsigned long long)atomic_load(&cap->write_errors));
+    }
+    if (cap->data_fd >= 0) close(cap->data_fd);
+    if (cap->index_fd >= 0) close(cap->index_fd);
+    rt_free(cap->batches);
+    free(cap);
+}
+
+// Map a whole file read-only; *map stays NULL for an empty file
+static int map_file(const char *prefix, const char *ext, const uint8_t **map, size_t *size) {
+    int fd = open_capture_file(prefix, ext, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    *size = (size_t)st.st_size;
+    *map = NULL;
+    if (*size > 0) {
+        void *p = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        *map = p;
+    }
+
+    close(fd);
+    return 0;
+}
+
+// Entries come from a file: a corrupt or truncated one must not point
+// outside the data mapping
+static bool record_in_bounds(const burst_index_t *idx, const burst_index_entry_t *e) {
+    size_t len = record_bytes(e->bit_count, e->flags);
+    return e->data_offset >= CAPTURE_HEADER_BYTES && e->data_offset <= idx->data_size &&
+           len <= idx->data_size - e->data_offset;
+}
+
+burst_index_t* burst_index_open(const char *prefix) {
+    burst_index_t *idx = calloc(1, sizeof(burst_index_t));
+    if (!idx) {
+        fprintf(stderr, "Failed to allocate burst index\n");
+        return NULL;
+    }
+
+    if (map_file(prefix, ".tbc", &idx->data, &idx->data_size) < 0 ||
+        map_file(prefix, ".tbi", &idx->index_map, &idx->index_size) < 0) {
+        fprintf(stderr, "Failed to open burst capture %s: %s\n", prefix, strerror(errno));
+        burst_index_close(idx);
+        return NULL;
+    }
+
+    uint32_t entry_size = 0;
+    if (idx->index_size >= CAPTURE_HEADER_BYTES) {
+        memcpy(&entry_size, idx->index_map + 4, 4);
+    }
+    if (idx->data_size < CAPTURE_HEADER_BYTES || idx->index_size < CAPTURE_HEADER_BYTES ||
+        memcmp(idx->data, CAPTURE_DATA_MAGIC, 4) != 0 ||
+        memcmp(idx->index_map, CAPTURE_INDEX_MAGIC, 4) != 0 ||
+        entry_size != sizeof(burst_index_entry_t)) {
+        fprintf(stderr, "%s is not a burst capture\n", prefix);
+        burst_index_close(idx);
+        return NULL;
+    }
+
+    idx->entries = (const burst_index_entry_t *)(idx->index_map + CAPTURE_HEADER_BYTES);
+    idx->count = (idx->index_size - CAPTURE_HEADER_BYTES) / sizeof(burst_index_entry_t);
+
+    // A capture still being written may have index entries ahead of the
+    // data this mapping covers; stop at the last complete record
+    while (idx->count > 0) {
+        if (record_in_bounds(idx, &idx->entries[idx->count - 1])) break;
+        idx->count--;
+    }
+
+    return idx;
+}
+
+uint64_t burst_index_count(const burst_index_t *idx) {
+    return idx ? idx->count : 0;
+}
+
+const burst_index_entry_t* burst_index_entry(const burst_index_t *idx, uint64_t i) {
+    if (!idx || i >= idx->count) {
+        return NULL;
+    }
+    return &idx->entries[i];
+}
+
+// First entry at or after time_us (count if none)
+uint64_t burst_index_find_time(const burst_index_t *idx, uint64_t time_us) {
+    if (!idx) return 0;
+
+    uint64_t lo = 0;
+    uint64_t hi = idx->count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (idx->entries[mid].timestamp_us < time_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Next entry at or after `from` that matches the query, or -1
+int64_t burst_index_next(const burst_index_t *idx, const burst_query_t *query, uint64_t from) {
+    if (!idx || !query) return -1;
+
+    uint64_t i = from;
+    if (query->start_us) {
+        uint64_t first = burst_index_find_time(idx, query->start_us);
+        if (first > i) i = first;
+    }
+
+    for (; i < idx->count; i++) {
+        const burst_index_entry_t *e = &idx->entries[i];
+        if (query->end_us && e->timestamp_us >= query->end_us) break;
+        if (query->frequency && e->frequency != query->frequency) continue;
+        if (query->talk_group && e->talk_group != query->talk_group) continue;
+        return (int64_t)i;
+    }
+    return -1;
+}
+
+static const uint8_t* record_payload(const burst_index_t *idx, const burst_index_entry_t *e) {
+    if (!record_in_bounds(idx, e)) {
+        return NULL;
+    }
+
+    const uint8_t *rec = idx->data + e->data_offset;
+    uint16_t sync;
+    uint16_t bit_count;
+    memcpy(&sync, rec, 2);
+    memcpy(&bit_count, rec + 2, 2);
+    if (sync != CAPTURE_RECORD_SYNC || bit_count != e->bit_count) {
+        return NULL;
+    }
+    return rec + CAPTURE_RECORD_HEADER_BYTES;
+}
+
+// Unpack a burst's hard bits, one per byte as in tetra_demod_t::demod_bits
+int burst_index_bits(const burst_index_t *idx, uint64_t i, uint8_t *bits) {
+    const burst_index_entry_t *e = burst_index_entry(idx, i);
+    if (!e || !bits) return -1;
+
+    const uint8_t *packed = record_payload(idx, e);
+    if (!packed) return -1;
+
+    for (int n = 0; n < e->bit_count; n++) {
+        bits[n] = (packed[n >> 3] >> (7 - (n & 7))) & 1;
+    }
+    return e->bit_count;
+}
+
+// Copy a burst's soft bits; returns 0 when the record has none
+int burst_index_soft(const burst_index_t *idx, uint64_t i, int8_t *soft) {
+    const burst_index_entry_t *e = burst_index_entry(idx, i);
+    if (!e || !soft) return -1;
+    if (!(e->flags & BURST_FLAG_SOFT)) return 0;
+
+    const uint8_t *packed = record_payload(idx, e);
+    if (!packed) return -1;
+
+    memcpy(soft, packed + (e->bit_count + 7) / 8, e->bit_count);
+    return e->bit_count;
+}
+
+void burst_index_close(burst_index_t *idx) {
+    if (!idx) return;
+
+    if (idx->data) munmap((void *)idx->data, idx->data_size);
+    if (idx->index_map) munmap((void *)idx->index_map, idx->index_size);
+    free(idx);
+}
@@ -0,0 +1,512 @@
+/*
+ * Per-call Recorder
+ * One WAV file per voice call, written by a dedicated I/O thread
+ *
+ * The capture thread only copies samples into large page-aligned buffers and
+ * hands full buffers to the writer through a lock-free job queue; the writer
+ * owns every file descriptor and does all pwrite()/fdatasync() calls, so an
+ * SD card stall delays the writer, never the SDR callback. When the buffer
+ * pool runs dry the capture thread drops samples and counts them instead of
+ * waiting. WAV files roll over to a new numbered segment before the 32-bit
+ * size fields would overflow; the compressed archive format is encoded on
+ * the writer thread too and has 64-bit offsets, so it never needs to.
+ */
+
+#include "tetra_analyzer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REC_BUFFER_BYTES (64 * 1024)   // One pwrite() per buffer
+#define REC_BUFFER_ALIGN 4096
+#define REC_BUFFER_COUNT 32            // 2 MB pool, ~4 minutes of one call
+#define REC_QUEUE_SIZE 128             // Jobs in flight (power of two)
+#define REC_WAV_HEADER_BYTES 44
+#define REC_SEGMENT_MAX_BYTES (0xFFFFFFFFu - REC_WAV_HEADER_BYTES - REC_BUFFER_BYTES)
+#define REC_PATH_MAX 512               // Recording directory
+#define REC_NAME_MAX 64                // "/call_<stamp>_tg<id>_src<id>"
+#define REC_SUFFIX_MAX 24              // "_part<n>.<ext>"
+
+typedef enum {
+    REC_JOB_OPEN,
+    REC_JOB_WRITE,
+    REC_JOB_CLOSE
+} rec_job_type_t;
+
+typedef struct {
+    rec_job_type_t type;
+    int slot;
+    uint32_t len;                      // WRITE: valid bytes in buf
+    uint8_t *buf;                      // WRITE: pool buffer, returned after use
+    uint32_t talk_group_id;            // OPEN: call identity
+    uint32_t source_id;
+    uint64_t grant_time;
+} rec_job_t;
+
+// Writer-side state of one slot's open file
+typedef struct {
+    int fd;
+    audio_archive_t *archive;          // Encoder when recording compressed
+    uint64_t grant_time;
+    char base[REC_PATH_MAX + REC_NAME_MAX];    // Path without segment suffix / extension
+    int segment;
+    uint64_t data_bytes;               // PCM bytes in the current segment
+    uint64_t unsynced_bytes;
+} rec_file_t;
+
+// Capture-side state of one slot
+typedef struct {
+    bool recording;
+    uint8_t *buf;
+    uint32_t len;
+} rec_slot_t;
+
+struct call_recorder {
+    char directory[REC_PATH_MAX];
+    int sample_rate;
+    uint64_t sync_bytes;               // fdatasync() after this many bytes (0 = on close)
+    record_format_t format;
+
+    // Capture -> writer jobs
+    rec_job_t jobs[REC_QUEUE_SIZE];
+    _Alignas(64) _Atomic uint32_t job_head;
+    _Alignas(64) _Atomic uint32_t job_tail;
+
+    // Writer -> capture buffer returns
+    uint8_t *free_bufs[REC_BUFFER_COUNT];
+    _Alignas(64) _Atomic uint32_t free_head;
+    _Alignas(64) _Atomic uint32_t free_tail;
+
+    uint8_t *pool;
+    sem_t wakeup;
+    pthread_t thread;
+    _Atomic bool running;
+
+    rec_slot_t slots[MAX_ACTIVE_CHANNELS];     // Capture thread only
+    rec_file_t files[MAX_ACTIVE_CHANNELS];     // Writer thread only
+
+    // Statistics
+    _Atomic uint64_t bytes_written;
+    _Atomic uint64_t files_opened;
+    _Atomic uint64_t samples_dropped;
+    _Atomic uint64_t write_errors;
+    _Atomic uint64_t max_write_us;
+};
+
+static bool push_job(call_recorder_t *rec, const rec_job_t *job) {
+    uint32_t head = atomic_load_explicit(&rec->job_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&rec->job_tail, memory_order_acquire);
+    if (head - tail >= REC_QUEUE_SIZE) {
+        return false;
+    }
+
+    rec->jobs[head & (REC_QUEUE_SIZE - 1)] = *job;
+    atomic_store_explicit(&rec->job_head, head + 1, memory_order_release);
+    sem_post(&rec->wakeup);
+    return true;
+}
+
+static bool pop_job(call_recorder_t *rec, rec_job_t *job) {
+    uint32_t tail = atomic_load_explicit(&rec->job_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&rec->job_head, memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+
+    *job = rec->jobs[tail & (REC_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&rec->job_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Buffers are returned only by the writer (and seeded before it starts);
+// the list holds at most REC_BUFFER_COUNT entries, so it never fills
+static void put_buffer(call_recorder_t *rec, uint8_t *buf) {
+    uint32_t head = atomic_load_explicit(&rec->free_head, memory_order_relaxed);
+    rec->free_bufs[head % REC_BUFFER_COUNT] = buf;
+    atomic_store_explicit(&rec->free_head, head + 1, memory_order_release);
+}
+
+static uint8_t* get_buffer(call_recorder_t *rec) {
+    uint32_t tail = atomic_load_explicit(&rec->free_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&rec->free_head, memory_order_acquire);
+    if (tail == head) {
+        return NULL;
+    }
+
+    uint8_t *buf = rec->free_bufs[tail % REC_BUFFER_COUNT];
+    atomic_store_explicit(&rec->free_tail, tail + 1, memory_order_release);
+    return buf;
+}
+
+static void wav_header(uint8_t *h, int sample_rate, uint32_t data_bytes) {
+    uint32_t riff_size = data_bytes + REC_WAV_HEADER_BYTES - 8;
+    uint32_t fmt_size = 16;
+    uint16_t audio_format = 1;         // PCM
+    uint16_t channels = 1;
+    uint32_t rate = (uint32_t)sample_rate;
+    uint32_t byte_rate = rate * 2;
+    uint16_t block_align = 2;
+    uint16_t bits = 16;
+
+    memcpy(h, "RIFF", 4);
+    memcpy(h + 4, &riff_size, 4);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    memcpy(h + 16, &fmt_size, 4);
+    memcpy(h + 20, &audio_format, 2);
+    memcpy(h + 22, &channels, 2);
+    memcpy(h + 24, &rate, 4);
+    memcpy(h + 28, &byte_rate, 4);
+    memcpy(h + 32, &block_align, 2);
+    memcpy(h + 34, &bits, 2);
+    memcpy(h + 36, "data", 4);
+    memcpy(h + 40, &data_bytes, 4);
+}
+
+// Writer thread: file operations
+
+static void file_close(call_recorder_t *rec, rec_file_t *f) {
+    if (f->fd < 0) return;
+
+    if (f->archive) {
+        // Final block, seek table and header
+        if (audio_archive_close(f->archive) < 0) {
+            atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        }
+        f->archive = NULL;
+    } else {
+        uint8_t header[REC_WAV_HEADER_BYTES];
+        wav_header(header, rec->sample_rate, (uint32_t)f->data_bytes);
+        if (pwrite(f->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        }
+    }
+    fdatasync(f->fd);
+    close(f->fd);
+    f->fd = -1;
+}
+
+static void file_open_segment(call_recorder_t *rec, rec_file_t *f) {
+    char path[REC_PATH_MAX + REC_NAME_MAX + REC_SUFFIX_MAX];
+    const char *ext = rec->format == RECORD_FORMAT_ARCHIVE ? "tca" : "wav";
+    int len;
+    if (f->segment == 0) {
+        len = snprintf(path, sizeof(path), "%s.%s", f->base, ext);
+    } else {
+        len = snprintf(path, sizeof(path), "%s_part%d.%s", f->base, f->segment + 1, ext);
+    }
+
+    // A truncated name could clash with another call's file: fail instead
+    f->data_bytes = 0;
+    f->unsynced_bytes = 0;
+    if (len < 0 || (size_t)len >= sizeof(path)) {
+        fprintf(stderr, "Call recording path too long: %s...\n", f->base);
+        atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        return;
+    }
+
+    f->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (f->fd < 0) {
+        fprintf(stderr, "Failed to open call recording %s: %s\n", path, strerror(errno));
+        atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        return;
+    }
+
+    if (rec->format == RECORD_FORMAT_ARCHIVE) {
+        f->archive = audio_archive_create(f->fd, rec->sample_rate, f->grant_time);
+        if (!f->archive) {
+            close(f->fd);
+            f->fd = -1;
+            atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+            return;
+        }
+    } else {
+        // Placeholder sizes, fixed up on close
+        uint8_t header[REC_WAV_HEADER_BYTES];
+        wav_header(header, rec->sample_rate, 0);
+        if (pwrite(f->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        }
+    }
+
+    atomic_fetch_add_explicit(&rec->files_opened, 1, memory_order_relaxed);
+    log_message(true, "Recording call to %s\n", path);
+}
+
+static void file_open(call_recorder_t *rec, rec_file_t *f, const rec_job_t *job) {
+    file_close(rec, f);
+
+    // Name by wall-clock grant time, talk group and source
+    time_t secs = (time_t)(job->grant_time / 1000000);
+    struct tm tm;
+    char stamp[32];
+    localtime_r(&secs, &tm);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+    // Built locally: f lives inside rec, so the compiler cannot rule out
+    // rec->directory overlapping f->base
+    char base[sizeof(f->base)];
+    int len = snprintf(base, sizeof(base), "%s/call_%s_tg%u_src%u",
+                       rec->directory, stamp, job->talk_group_id, job->source_id);
+    if (len < 0 || (size_t)len >= sizeof(base)) {
+        fprintf(stderr, "Call recording path too long in %s\n", rec->directory);
+        atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        return;
+    }
+    memcpy(f->base, base, (size_t)len + 1);
+    f->grant_time = job->grant_time;
+    f->segment = 0;
+    file_open_segment(rec, f);
+}
+
+static void file_write(call_recorder_t *rec, rec_file_t *f, const uint8_t *buf, uint32_t len) {
+    if (f->fd < 0) return;
+
+    // Start a new segment rather than overflow the 32-bit size fields
+    if (!f->archive && f->data_bytes + len > REC_SEGMENT_MAX_BYTES) {
+        file_close(rec, f);
+        f->segment++;
+        file_open_segment(rec, f);
+        if (f->fd < 0) return;
+    }
+
+    uint64_t start = get_timestamp_us();
+    ssize_t n;
+    if (f->archive) {
+        // Pool buffers are page aligned, so they can be read as samples
+        uint64_t before = audio_archive_bytes(f->archive);
+        if (audio_archive_write(f->archive, (const int16_t *)buf, (int)(len / sizeof(int16_t))) < 0) {
+            atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        }
+        n = (ssize_t)(audio_archive_bytes(f->archive) - before);
+    } else {
+        n = pwrite(f->fd, buf, len, (off_t)(REC_WAV_HEADER_BYTES + f->data_bytes));
+        if (n != (ssize_t)len) {
+            atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+            if (n < 0) return;
+        }
+    }
+
+    f->data_bytes += (uint64_t)n;
+    f->unsynced_bytes += (uint64_t)n;
+    if (rec->sync_bytes && f->unsynced_bytes >= rec->sync_bytes) {
+        fdatasync(f->fd);
+        f->unsynced_bytes = 0;
+    }
+
+    uint64_t elapsed = get_timestamp_us() - start;
+    uint64_t max = atomic_load_explicit(&rec->max_write_us, memory_order_relaxed);
+    if (elapsed > max) {
+        atomic_store_explicit(&rec->max_write_us, elapsed, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&rec->bytes_written, (uint64_t)n, memory_order_relaxed);
+}
+
+static void* writer_thread_func(void *arg) {
+    call_recorder_t *rec = (call_recorder_t *)arg;
+    rec_job_t job;
+
+    thread_policy_apply(THREAD_ROLE_RECORDER, -1);
+
+    for (;;) {
+        sem_wait(&rec->wakeup);
+
+        while (pop_job(rec, &job)) {
+            rec_file_t *f = &rec->files[job.slot];
+            switch (job.type) {
+                case REC_JOB_OPEN:
+                    file_open(rec, f, &job);
+                    break;
+                case REC_JOB_WRITE:
+                    file_write(rec, f, job.buf, job.len);
+                    put_buffer(rec, job.buf);
+                    break;
+                case REC_JOB_CLOSE:
+                    file_close(rec, f);
+                    break;
+            }
+        }
+
+        if (!atomic_load_explicit(&rec->running, memory_order_acquire)) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < MAX_ACTIVE_CHANNELS; i++) {
+        file_close(rec, &rec->files[i]);
+    }
+    thread_policy_leave();
+    return NULL;
+}
+
+// Capture thread API
+
+call_recorder_t* call_recorder_init(const char *directory, int sample_rate, uint32_t sync_bytes,
+                                    record_format_t format) {
+    if (!directory) return NULL;
+    if (strlen(directory) >= REC_PATH_MAX) {
+        fprintf(stderr, "Recording directory path too long (max %d): %s\n", REC_PATH_MAX - 1, directory);
+        return NULL;
+    }
+
+    if (mkdir(directory, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create recording directory %s: %s\n", directory, strerror(errno));
+        return NULL;
+    }
+
+    call_recorder_t *rec = rt_alloc(RT_POOL_RECORDER, sizeof(call_recorder_t));
+    if (!rec) {
+        fprintf(stderr, "Failed to allocate call recorder\n");
+        return NULL;
+    }
+
+    snprintf(rec->directory, sizeof(rec->directory), "%s", directory);
+    rec->sample_rate = sample_rate;
+    rec->sync_bytes = sync_bytes;
+    rec->format = format;
+    for (int i = 0; i < MAX_ACTIVE_CHANNELS; i++) {
+        rec->files[i].fd = -1;
+    }
+
+    if (posix_memalign((void **)&rec->pool, REC_BUFFER_ALIGN,
+                       (size_t)REC_BUFFER_BYTES * REC_BUFFER_COUNT) != 0) {
+        fprintf(stderr, "Failed to allocate recorder buffers\n");
+        rt_free(rec);
+        return NULL;
+    }
+    rt_memory_account(RT_POOL_RECORDER, (long)REC_BUFFER_BYTES * REC_BUFFER_COUNT);
+    for (int i = 0; i < REC_BUFFER_COUNT; i++) {
+        put_buffer(rec, rec->pool + (size_t)i * REC_BUFFER_BYTES);
+    }
+
+    sem_init(&rec->wakeup, 0, 0);
+    atomic_init(&rec->running, true);
+    if (pthread_create(&rec->thread, NULL, writer_thread_func, rec) != 0) {
+        fprintf(stderr, "Failed to start recorder thread\n");
+        sem_destroy(&rec->wakeup);
+        free(rec->pool);
+        rt_memory_account(RT_POOL_RECORDER, -(long)REC_BUFFER_BYTES * REC_BUFFER_COUNT);
+        rt_free(rec);
+        return NULL;
+    }
+
+    log_message(true, "Call recorder: %s (%s, %d KB buffers x %d, sync %s)\n", directory,
+                format == RECORD_FORMAT_ARCHIVE ? "compressed archive" : "WAV",
+                REC_BUFFER_BYTES / 1024, REC_BUFFER_COUNT, sync_bytes ? "periodic" : "on close");
+    return rec;
+}
+
+// Hand the slot's filled buffer to the writer. An empty buffer, or one the
+// full queue will not take (its samples are dropped), stays with the slot.
+static void flush_slot(call_recorder_t *rec, rec_slot_t *slot, int index) {
+    if (!slot->buf || slot->len == 0) return;
+
+    rec_job_t job = { .type = REC_JOB_WRITE, .slot = index, .len = slot->len, .buf = slot->buf };
+    if (push_job(rec, &job)) {
+        slot->buf = NULL;
+    } else {
+        atomic_fetch_add_explicit(&rec->samples_dropped, slot->len / sizeof(int16_t),
+                                  memory_order_relaxed);
+    }
+    slot->len = 0;
+}
+
+int call_recorder_start_call(call_recorder_t *rec, int slot, const voice_channel_t *ch) {
+    if (!rec || !ch || slot < 0 || slot >= MAX_ACTIVE_CHANNELS) {
+        return -1;
+    }
+
+    call_recorder_end_call(rec, slot);
+
+    rec_job_t job = {
+        .type = REC_JOB_OPEN,
+        .slot = slot,
+        .talk_group_id = ch->talk_group_id,
+        .source_id = ch->source_id,
+        .grant_time = ch->grant_time,
+    };
+    rec->slots[slot].recording = push_job(rec, &job);
+    return rec->slots[slot].recording ? 0 : -1;
+}
+
+int call_recorder_write(call_recorder_t *rec, int slot, const int16_t *samples, int count) {
+    if (!rec || !samples || count <= 0 || slot < 0 || slot >= MAX_ACTIVE_CHANNELS) {
+        return -1;
+    }
+
+    rec_slot_t *s = &rec->slots[slot];
+    if (!s->recording) return 0;
+
+    const uint8_t *src = (const uint8_t *)samples;
+    uint32_t remaining = (uint32_t)count * sizeof(int16_t);
+
+    while (remaining > 0) {
+        if (!s->buf) {
+            s->buf = get_buffer(rec);
+            s->len = 0;
+            if (!s->buf) {
+                // Writer is behind: drop rather than stall the capture thread
+                atomic_fetch_add_explicit(&rec->samples_dropped, remaining / sizeof(int16_t),
+                                          memory_order_relaxed);
+                break;
+            }
+        }
+
+        uint32_t n = REC_BUFFER_BYTES - s->len;
+        if (n > remaining) n = remaining;
+        memcpy(s->buf + s->len, src, n);
+        s->len += n;
+        src += n;
+        remaining -= n;
+
+        if (s->len == REC_BUFFER_BYTES) {
+            flush_slot(rec, s, slot);
+        }
+    }
+
+    return count;
+}
+
+void call_recorder_end_call(call_recorder_t *rec, int slot) {
+    if (!rec || slot < 0 || slot >= MAX_ACTIVE_CHANNELS) return;
+
+    rec_slot_t *s = &rec->slots[slot];
+    if (!s->recording) return;
+
+    flush_slot(rec, s, slot);
+    rec_job_t job = { .type = REC_JOB_CLOSE, .slot = slot };
+    push_job(rec, &job);
+    s->recording = false;
+}
+
+void call_recorder_cleanup(call_recorder_t *rec) {
+    if (!rec) return;
+
+    for (int i = 0; i < MAX_ACTIVE_CHANNELS; i++) {
+        call_recorder_end_call(rec, i);
+    }
+
+    atomic_store_explicit(&rec->running, false, memory_order_release);
+    sem_post(&rec->wakeup);
+    pthread_join(rec->thread, NULL);
+
+    log_message(true, "Call recorder closed: %llu files, %.1f MB written, %llu samples dropped, "
+                "%llu write errors, slowest write %.1f ms\n",
+                (unsigned long long)atomic_load(&rec->files_opened),
+                (double)atomic_load(&rec->bytes_written) / (1024.0 * 1024.0),
+                (unsigned long long)atomic_load(&rec->samples_dropped),
+                (unsigned long long)atomic_load(&rec->write_errors),
+                (double)atomic_load(&rec->max_write_us) / 1000.0);
+
+    sem_destroy(&rec->wakeup);
+    free(rec->pool);
+    rt_memory_account(RT_POOL_RECORDER, -(long)REC_BUFFER_BYTES * REC_BUFFER_COUNT);
+    rt_free(rec);
+}
@@ -0,0 +1,66 @@
+/*
+ * Clocks
+ * Monotonic timestamps and sample-accurate stream time
+ *
+ * Timestamps are wall clock microseconds, but taken from CLOCK_MONOTONIC plus
+ * an offset fixed on first use: they never jump when NTP steps the clock, and
+ * both clocks are read through the vDSO without a syscall. The coarse variant
+ * reads CLOCK_MONOTONIC_COARSE, which only loads the kernel's last tick
+ * (1-4 ms resolution) and is cheap enough for per-burst bookkeeping.
+ *
+ * Stream time comes from the capture itself: the position of a sample in the
+ * stream, divided by the sample rate, from a fixed origin. Burst times are
+ * therefore exact to the sample and do not depend on when a buffer happened
+ * to be processed, so replaying a recording reproduces them.
+ */
+
+#include "tetra_analyzer.h"
+#include <time.h>
+
+static pthread_once_t g_clock_once = PTHREAD_ONCE_INIT;
+static uint64_t g_wall_offset_us;
+
+static uint64_t read_clock_us(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void clock_init_offset(void) {
+    g_wall_offset_us = read_clock_us(CLOCK_REALTIME) - read_clock_us(CLOCK_MONOTONIC);
+}
+
+uint64_t get_timestamp_us(void) {
+    pthread_once(&g_clock_once, clock_init_offset);
+    return g_wall_offset_us + read_clock_us(CLOCK_MONOTONIC);
+}
+
+uint64_t get_timestamp_coarse_us(void) {
+    pthread_once(&g_clock_once, clock_init_offset);
+#ifdef CLOCK_MONOTONIC_COARSE
+    return g_wall_offset_us + read_clock_us(CLOCK_MONOTONIC_COARSE);
+#else
+    return g_wall_offset_us + read_clock_us(CLOCK_MONOTONIC);
+#endif
+}
+
+void stream_clock_init(stream_clock_t *clock, uint32_t sample_rate, uint64_t origin_us) {
+    if (!clock) return;
+
+    clock->sample_rate = sample_rate ? sample_rate : TETRA_SAMPLE_RATE;
+    clock->origin_us = origin_us;
+    clock->samples = 0;
+}
+
+void stream_clock_advance(stream_clock_t *clock, uint64_t samples) {
+    if (!clock) return;
+    clock->samples += samples;
+}
+
+uint64_t stream_clock_time_us(const stream_clock_t *clock, uint64_t sample) {
+    if (!clock) return 0;
+
+    // Whole seconds first, so long streams cannot overflow the product
+    uint64_t rate = clock->sample_rate;
+    return clock->origin_us + sample / rate * 1000000ULL + sample % rate * 1000000ULL / rate;
+}
@@ -1,12 +1,18 @@
 /*
  * TETRA Control Channel Decoder
  * Decodes signaling messages from TETRA trunked radio control channels
+ *
+ * PDU layouts are described by a static table of field descriptors rather
+ * than hand-written per-type code. Every field of the simplified PDUs lives
+ * in the first 64 bits, so decoding is one big-endian word load followed by
+ * a shift and mask per field - no heap traffic and no per-bit loops.
  */
 
 #include "tetra_analyzer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
 // TETRA PDU types (simplified)
 #define PDU_TYPE_D_CHANNEL_GRANT          0x01
@@ -17,21 +23,129 @@
 #define PDU_TYPE_D_EMERGENCY              0x06
 #define PDU_TYPE_D_AFFILIATION            0x07
 #define PDU_TYPE_D_STATUS                 0x08
+#define PDU_TYPE_COUNT                    0x09
+
+// PDU header: type in the first 8 bits, all fields within the first 64
+#define PDU_TYPE_BITS     8
+#define PDU_HEADER_BITS   64
+
+// Channel numbers are 25 kHz steps above this base (simplified)
+#define CHANNEL_BASE_FREQ 420000000
+#define CHANNEL_SPACING   25000
+
+// Where a decoded field is stored in ctrl_message_t
+typedef enum {
+    FIELD_TALK_GROUP,
+    FIELD_SOURCE,
+    FIELD_DEST,
+    FIELD_CHANNEL,
+    FIELD_ENCRYPTED,
+    FIELD_EMERGENCY,
+    FIELD_COUNT
+} pdu_field_target_t;
+
+// One field of a PDU layout (offset + width must not exceed PDU_HEADER_BITS)
+typedef struct {
+    uint8_t offset;                    // Bit offset from start of PDU, MSB first
+    uint8_t width;                     // Field width in bits (1-32)
+    uint8_t target;                    // pdu_field_target_t
+} pdu_field_t;
+
+#define PDU_MAX_FIELDS 5
+
+// Layout of one PDU type
+typedef struct {
+    bool valid;                        // Entry describes a known PDU type
+    bool emergency;                    // PDU type implies an emergency
+    ctrl_msg_type_t type;
+    uint8_t field_count;
+    pdu_field_t fields[PDU_MAX_FIELDS];
+} pdu_layout_t;
+
+// PDU layouts indexed by PDU type
+static const pdu_layout_t PDU_LAYOUTS[PDU_TYPE_COUNT] = {
+    [PDU_TYPE_D_CHANNEL_GRANT] = { true, false, CTRL_MSG_CHANNEL_GRANT, 5, {
+        {  8, 16, FIELD_TALK_GROUP },
+        { 24, 24, FIELD_SOURCE },
+        { 48, 12, FIELD_CHANNEL },
+        { 60,  1, FIELD_ENCRYPTED },
+        { 61,  1, FIELD_EMERGENCY } } },
+    [PDU_TYPE_D_CHANNEL_RELEASE] = { true, false, CTRL_MSG_CHANNEL_RELEASE, 1, {
+        {  8, 16, FIELD_TALK_GROUP } } },
+    [PDU_TYPE_D_GROUP_CALL] = { true, false, CTRL_MSG_GROUP_CALL, 3, {
+        {  8, 16, FIELD_TALK_GROUP },
+        { 24, 24, FIELD_SOURCE },
+        { 48,  1, FIELD_EMERGENCY } } },
+    [PDU_TYPE_D_UNIT_TO_UNIT] = { true, false, CTRL_MSG_UNIT_TO_UNIT, 3, {
+        {  8, 24, FIELD_SOURCE },
+        { 32, 24, FIELD_DEST },
+        { 56,  1, FIELD_ENCRYPTED } } },
+    [PDU_TYPE_D_REGISTRATION] = { true, false, CTRL_MSG_REGISTRATION, 2, {
+        {  8, 24, FIELD_SOURCE },
+        { 32, 16, FIELD_TALK_GROUP } } },
+    [PDU_TYPE_D_EMERGENCY] = { true, true, CTRL_MSG_EMERGENCY, 2, {
+        {  8, 24, FIELD_SOURCE },
+        { 32, 16, FIELD_TALK_GROUP } } },
+    [PDU_TYPE_D_AFFILIATION] = { true, false, CTRL_MSG_AFFILIATION, 2, {
+        {  8, 24, FIELD_SOURCE },
+        { 32, 16, FIELD_TALK_GROUP } } },
+    [PDU_TYPE_D_STATUS] = { true, false, CTRL_MSG_STATUS, 1, {
+        {  8, 24, FIELD_SOURCE } } },
+};
+
+// Per-type decode counters (updated from the SDR thread, read anywhere)
+static atomic_uint_fast64_t g_decoded[CTRL_MSG_UNKNOWN];
+static atomic_uint_fast64_t g_unknown;
+static atomic_uint_fast64_t g_rejected;
+
+// Load the first 64 bits of a packed, MSB-first bit buffer
+static inline uint64_t load_header_word(const uint8_t *packed) {
+    uint64_t word;
+    memcpy(&word, packed, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+// Extract a field from the header word
+static inline uint32_t field_value(uint64_t word, const pdu_field_t *field) {
+    return (uint32_t)((word << field->offset) >> (64 - field->width));
+}
+
+// Decode a PDU from its header word
+static bool decode_header_word(uint64_t word, ctrl_message_t *msg) {
+    memset(msg, 0, sizeof(ctrl_message_t));  // Timestamp is the caller's: it knows the burst time
+    msg->type = CTRL_MSG_UNKNOWN;
+
+    uint32_t pdu_type = (uint32_t)(word >> (64 - PDU_TYPE_BITS));
+    if (pdu_type >= PDU_TYPE_COUNT || !PDU_LAYOUTS[pdu_type].valid) {
+        atomic_fetch_add_explicit(&g_unknown, 1, memory_order_relaxed);
+        return false;
+    }
 
-// Extract bits from byte array
-static uint32_t extract_bits(const uint8_t *data, int start_bit, int num_bits) {
-    uint32_t result = 0;
+    const pdu_layout_t *layout = &PDU_LAYOUTS[pdu_type];
+    uint32_t values[FIELD_COUNT] = {0};
+    uint32_t present = 0;
 
-    for (int i = 0; i < num_bits; i++) {
-        int byte_idx = (start_bit + i) / 8;
-        int bit_idx = 7 - ((start_bit + i) % 8);
+    for (int i = 0; i < layout->field_count; i++) {
+        const pdu_field_t *field = &layout->fields[i];
+        values[field->target] = field_value(word, field);
+        present |= 1u << field->target;
+    }
 
-        if (data[byte_idx] & (1 << bit_idx)) {
-            result |= (1 << (num_bits - 1 - i));
-        }
+    msg->type = layout->type;
+    msg->talk_group_id = values[FIELD_TALK_GROUP];
+    msg->source_id = values[FIELD_SOURCE];
+    msg->dest_id = values[FIELD_DEST];
+    msg->encrypted = values[FIELD_ENCRYPTED] != 0;
+    msg->emergency = layout->emergency || values[FIELD_EMERGENCY] != 0;
+    if (present & (1u << FIELD_CHANNEL)) {
+        msg->channel_freq = CHANNEL_BASE_FREQ + values[FIELD_CHANNEL] * CHANNEL_SPACING;
     }
 
-    return result;
+    atomic_fetch_add_explicit(&g_decoded[layout->type], 1, memory_order_relaxed);
+    return true;
 }
 
 // Convert message type to string
@@ -49,103 +163,76 @@ const char* ctrl_msg_type_to_string(ctrl_msg_type_t type) {
     }
 }
 
-// Decode TETRA control channel data
+// Decode TETRA control channel data from a packed (MSB-first) bit buffer
 // This is a simplified decoder for educational purposes
 // Real TETRA decoding requires full protocol implementation
+bool decode_control_pdu_packed(const uint8_t *packed, int bit_count, ctrl_message_t *msg) {
+    if (!packed || !msg || bit_count < PDU_HEADER_BITS) {
+        atomic_fetch_add_explicit(&g_rejected, 1, memory_order_relaxed);
+        return false;
+    }
+
+    return decode_header_word(load_header_word(packed), msg);
+}
+
+// Decode TETRA control channel data from one-bit-per-byte demodulator output
 bool decode_control_channel_data(uint8_t *bits, int bit_count, ctrl_message_t *msg) {
-    if (!bits || !msg || bit_count < 64) {
+    if (!bits || !msg || bit_count < PDU_HEADER_BITS) {
+        atomic_fetch_add_explicit(&g_rejected, 1, memory_order_relaxed);
         return false;
     }
 
-    // Initialize message
-    memset(msg, 0, sizeof(ctrl_message_t));
-    msg->timestamp = get_timestamp_us();
-    msg->type = CTRL_MSG_UNKNOWN;
+    uint64_t word = 0;
+    for (int i = 0; i < PDU_HEADER_BITS; i++) {
+        word = (word << 1) | (bits[i] != 0);
+    }
+
+    return decode_header_word(word, msg);
+}
+
+// Decode the control PDU carried by a detected burst. Channel coded PDUs
+// sit in the SCH/HD block after the training sequence, or the one before
+// it when the burst was cut short; raw PDUs start at the first bit.
+bool decode_control_burst(lower_mac_t *mac, bool raw_control, const uint8_t *bits,
+                          int bit_count, int sync_offset, ctrl_message_t *msg) {
+    if (!mac || !bits || !msg) return false;
 
-    // Convert bits to bytes for easier processing
-    int byte_count = (bit_count + 7) / 8;
-    uint8_t *bytes = calloc(byte_count, sizeof(uint8_t));
-    if (!bytes) return false;
-
-    for (int i = 0; i < bit_count; i++) {
-        int byte_idx = i / 8;
-        int bit_idx = 7 - (i % 8);
-        if (bits[i]) {
-            bytes[byte_idx] |= (1 << bit_idx);
-        }
+    if (raw_control) {
+        return decode_control_channel_data((uint8_t *)bits, bit_count, msg);
     }
 
-    // Extract PDU type (simplified - first 8 bits)
-    uint8_t pdu_type = extract_bits(bytes, 0, 8);
-
-    // Decode based on PDU type
-    switch (pdu_type) {
-        case PDU_TYPE_D_CHANNEL_GRANT:
-            msg->type = CTRL_MSG_CHANNEL_GRANT;
-            // Extract talk group ID (bits 8-23, 16 bits)
-            msg->talk_group_id = extract_bits(bytes, 8, 16);
-            // Extract source ID (bits 24-47, 24 bits)
-            msg->source_id = extract_bits(bytes, 24, 24);
-            // Extract channel frequency offset (bits 48-59, 12 bits)
-            uint32_t freq_offset = extract_bits(bytes, 48, 12);
-            // Convert to actual frequency (simplified calculation)
-            // TETRA channels are typically 25 kHz apart
-            msg->channel_freq = 420000000 + (freq_offset * 25000);
-            // Extract encryption flag (bit 60)
-            msg->encrypted = extract_bits(bytes, 60, 1);
-            // Extract emergency flag (bit 61)
-            msg->emergency = extract_bits(bytes, 61, 1);
-            break;
-
-        case PDU_TYPE_D_CHANNEL_RELEASE:
-            msg->type = CTRL_MSG_CHANNEL_RELEASE;
-            msg->talk_group_id = extract_bits(bytes, 8, 16);
-            break;
-
-        case PDU_TYPE_D_GROUP_CALL:
-            msg->type = CTRL_MSG_GROUP_CALL;
-            msg->talk_group_id = extract_bits(bytes, 8, 16);
-            msg->source_id = extract_bits(bytes, 24, 24);
-            msg->emergency = extract_bits(bytes, 48, 1);
-            break;
-
-        case PDU_TYPE_D_UNIT_TO_UNIT:
-            msg->type = CTRL_MSG_UNIT_TO_UNIT;
-            msg->source_id = extract_bits(bytes, 8, 24);
-            msg->dest_id = extract_bits(bytes, 32, 24);
-            msg->encrypted = extract_bits(bytes, 56, 1);
-            break;
-
-        case PDU_TYPE_D_REGISTRATION:
-            msg->type = CTRL_MSG_REGISTRATION;
-            msg->source_id = extract_bits(bytes, 8, 24);
-            msg->talk_group_id = extract_bits(bytes, 32, 16);
-            break;
-
-        case PDU_TYPE_D_EMERGENCY:
-            msg->type = CTRL_MSG_EMERGENCY;
-            msg->source_id = extract_bits(bytes, 8, 24);
-            msg->talk_group_id = extract_bits(bytes, 32, 16);
-            msg->emergency = true;
-            break;
-
-        case PDU_TYPE_D_AFFILIATION:
-            msg->type = CTRL_MSG_AFFILIATION;
-            msg->source_id = extract_bits(bytes, 8, 24);
-            msg->talk_group_id = extract_bits(bytes, 32, 16);
-            break;
-
-        case PDU_TYPE_D_STATUS:
-            msg->type = CTRL_MSG_STATUS;
-            msg->source_id = extract_bits(bytes, 8, 24);
-            break;
-
-        default:
-            msg->type = CTRL_MSG_UNKNOWN;
-            free(bytes);
-            return false;
+    if (sync_offset < 0) return false;
+
+    int block_bits = lower_mac_type5_bits(LMAC_CHAN_SCH_HD);
+    int start = sync_offset + TETRA_TRAINING_SEQ_BITS;
+    if (start + block_bits > bit_count) {
+        start = sync_offset - block_bits;
     }
+    if (start < 0) return false;
 
-    free(bytes);
-    return true;
+    uint8_t type1[LMAC_MAX_TYPE1_BITS];
+    int n = lower_mac_decode_hard(mac, LMAC_CHAN_SCH_HD, bits + start, type1);
+    if (n < 0) {
+        return false;
+    }
+
+    return decode_control_channel_data(type1, n, msg);
+}
+
+void control_channel_get_stats(ctrl_decode_stats_t *stats) {
+    if (!stats) return;
+
+    for (int i = 0; i < CTRL_MSG_UNKNOWN; i++) {
+        stats->decoded[i] = atomic_load_explicit(&g_decoded[i], memory_order_relaxed);
+    }
+    stats->unknown = atomic_load_explicit(&g_unknown, memory_order_relaxed);
+    stats->rejected = atomic_load_explicit(&g_rejected, memory_order_relaxed);
+}
+
+void control_channel_reset_stats(void) {
+    for (int i = 0; i < CTRL_MSG_UNKNOWN; i++) {
+        atomic_store_explicit(&g_decoded[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&g_unknown, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_rejected, 0, memory_order_relaxed);
 }
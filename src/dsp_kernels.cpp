@@ -0,0 +1,78 @@
+/*
+ * DSP Kernels
+ * Compile-time specialised FIR designs and the training sequence correlator,
+ * exported to the C sources
+ *
+ * Each design is a constexpr table, its Q15 rounding for the fixed-point
+ * path, and the kernels instantiated for its tap count and ratio.
+ * signal_processing.c looks kernels up by tap count and decimation, so a
+ * caller with its own taps of a specialised length gets the unrolled kernel
+ * too; anything else takes the generic loop there.
+ */
+
+#include "dsp_kernels.hpp"
+
+using namespace tetra::dsp;
+
+namespace {
+
+// 2.4 Msps -> 150 ksps. Passes the 25 kHz channel; what folds onto it from
+// 150 kHz away is in the stopband
+constexpr coeff_table<64> DECIM16_TAPS = lowpass<64>(40000.0 / TETRA_SAMPLE_RATE);
+
+// 150 ksps -> 37.5 ksps. Cutoff at the output Nyquist rate
+constexpr coeff_table<48> DECIM4_TAPS = lowpass<48>(18750.0 / (TETRA_SAMPLE_RATE / 16.0));
+
+// Matched filter for the pi/4-DQPSK pulse, at 37.5k / 18k samples per symbol
+constexpr coeff_table<17> RRC035_TAPS = rrc<17>(0.35, (double)DSP_CHANNEL_RATE / TETRA_SYMBOL_RATE);
+
+constexpr coeff_table_q15<64> DECIM16_Q15 = to_q15(DECIM16_TAPS);
+constexpr coeff_table_q15<48> DECIM4_Q15 = to_q15(DECIM4_TAPS);
+constexpr coeff_table_q15<17> RRC035_Q15 = to_q15(RRC035_TAPS);
+
+template <size_t Taps, size_t Decim>
+void fir_cf32(const float *taps, const cf32_t *in, cf32_t *out, uint32_t out_count) {
+    fir_decimate<Taps, Decim>(taps, in, out, out_count);
+}
+
+template <size_t Taps, size_t Decim>
+void fir_f32(const float *taps, const float *in, float *out, uint32_t out_count) {
+    fir_decimate<Taps, Decim>(taps, in, out, out_count);
+}
+
+template <size_t Taps, size_t Decim>
+void fir_ci16(const int16_t *taps, const ci16_t *in, ci16_t *out, uint32_t out_count) {
+    fir_decimate_q15<Taps, Decim>(taps, in, out, out_count);
+}
+
+const dsp_fir_kernel_t FIR_KERNELS[DSP_FIR_COUNT] = {
+    { "lowpass 64/16", DECIM16_TAPS.taps, 64, 16, fir_cf32<64, 16>, fir_f32<64, 16>,
+      DECIM16_Q15.taps, fir_ci16<64, 16> },
+    { "lowpass 48/4", DECIM4_TAPS.taps, 48, 4, fir_cf32<48, 4>, fir_f32<48, 4>,
+      DECIM4_Q15.taps, fir_ci16<48, 4> },
+    { "rrc 0.35", RRC035_TAPS.taps, 17, 1, fir_cf32<17, 1>, fir_f32<17, 1>,
+      RRC035_Q15.taps, fir_ci16<17, 1> },
+};
+
+} // namespace
+
+extern "C" {
+
+const dsp_fir_kernel_t* dsp_fir_kernel(dsp_fir_id_t id) {
+    if ((unsigned)id >= DSP_FIR_COUNT) return NULL;
+    return &FIR_KERNELS[id];
+}
+
+const dsp_fir_kernel_t* dsp_fir_find(uint32_t ntaps, uint32_t decim) {
+    for (int i = 0; i < DSP_FIR_COUNT; i++) {
+        if (FIR_KERNELS[i].ntaps == ntaps && FIR_KERNELS[i].decim == decim) return &FIR_KERNELS[i];
+    }
+    return NULL;
+}
+
+void dsp_correlate_training(const uint8_t *bits, uint32_t count, uint8_t *matches) {
+    uint64_t pattern = pack_bits(TETRA_TRAINING_SEQ, TETRA_TRAINING_SEQ_BITS);
+    correlate_bits<TETRA_TRAINING_SEQ_BITS>(bits, count, pattern, matches);
+}
+
+} // extern "C"
@@ -0,0 +1,253 @@
+/*
+ * Adaptive Jitter Buffer
+ * Playout scheduling for real-time audio on top of the lock-free sample ring
+ *
+ * The producer (SDR thread) time-stamps every write and keeps an RFC 3550
+ * style running estimate of arrival jitter. The consumer (playback thread)
+ * pulls fixed 20 ms frames and steers the ring level towards a target delay
+ * derived from that estimate. A gap of more than a few frames is silence
+ * between talk spurts or calls, not jitter: it restarts the spacing
+ * measurement instead of feeding the estimate.
+ *
+ * The consumer's steering:
+ *   - level well above target: play 168 samples in 160 (5% faster)
+ *   - level well below target: play 152 samples in 160 (5% slower)
+ *   - ring empty: repeat the last frame with fading, then comfort noise,
+ *     and after a few frames stop and rebuffer to the target delay
+ */
+
+#include "tetra_analyzer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JB_FRAME JITTER_FRAME_SAMPLES
+#define JB_STRETCH_DELTA 8             // Samples gained/lost per time-scaled frame
+#define JB_MAX_TARGET_FRAMES 8         // Upper bound on playout delay (160 ms)
+#define JB_MAX_CONCEAL_FRAMES 5        // Concealed frames before rebuffering
+#define JB_REPEAT_FRAMES 2             // Repeated-frame concealment before comfort noise
+#define JB_COMFORT_NOISE_LEVEL 48      // Peak comfort noise amplitude
+#define JB_JITTER_SHIFT 4              // Jitter estimator gain 1/16
+#define JB_GAP_FRAMES 4                // Later than this is a new talk spurt (80 ms)
+
+typedef enum {
+    JB_BUFFERING,                      // Filling up to the target delay
+    JB_PLAYING,                        // Steady-state playout
+    JB_CONCEALING                      // Ring ran dry, covering the gap
+} jb_state_t;
+
+struct jitter_buffer {
+    audio_ring_t *ring;
+    int sample_rate;
+
+    // Producer side
+    uint64_t last_arrival_us;
+    int last_count;
+    uint32_t jitter_est_us;            // Producer-private estimate
+    _Atomic uint32_t jitter_us;        // Published estimate
+
+    // Consumer side
+    jb_state_t state;
+    int conceal_run;                   // Consecutive concealed frames
+    uint32_t noise_seed;
+    int16_t last_frame[JB_FRAME];
+    int16_t scratch[JB_FRAME + JB_STRETCH_DELTA];
+
+    // Metrics, written by the consumer
+    _Atomic uint32_t target_samples;
+    _Atomic uint32_t level_samples;
+    _Atomic uint64_t frames_played;
+    _Atomic uint64_t frames_concealed;
+    _Atomic uint64_t concealment_events;
+    _Atomic uint64_t frames_stretched;
+    _Atomic uint64_t frames_compressed;
+};
+
+jitter_buffer_t* jitter_buffer_create(audio_ring_t *ring, int sample_rate) {
+    if (!ring || sample_rate <= 0) {
+        return NULL;
+    }
+
+    jitter_buffer_t *jb = rt_alloc(RT_POOL_AUDIO, sizeof(jitter_buffer_t));
+    if (!jb) {
+        fprintf(stderr, "Failed to allocate jitter buffer\n");
+        return NULL;
+    }
+
+    jb->ring = ring;
+    jb->sample_rate = sample_rate;
+    jb->state = JB_BUFFERING;
+    jb->noise_seed = 0x2545F491;
+    atomic_init(&jb->jitter_us, 0);
+    atomic_init(&jb->target_samples, JB_FRAME);
+    atomic_init(&jb->level_samples, 0);
+
+    return jb;
+}
+
+void jitter_buffer_destroy(jitter_buffer_t *jb) {
+    rt_free(jb);
+}
+
+void jitter_buffer_reset(jitter_buffer_t *jb) {
+    if (!jb) return;
+
+    jb->last_arrival_us = 0;
+    jb->last_count = 0;
+    jb->jitter_est_us = 0;
+    atomic_store_explicit(&jb->jitter_us, 0, memory_order_relaxed);
+}
+
+int jitter_buffer_push_at(jitter_buffer_t *jb, const int16_t *samples, int count, uint64_t arrival_us) {
+    if (!jb || !samples || count <= 0) {
+        return -1;
+    }
+
+    // Transit deviation: actual spacing minus the audio duration of the
+    // previous write
+    if (jb->last_arrival_us) {
+        int64_t spacing = (int64_t)(arrival_us - jb->last_arrival_us);
+        int64_t expected = (int64_t)jb->last_count * 1000000 / jb->sample_rate;
+        int64_t d = spacing - expected;
+        if (d < 0) d = -d;
+
+        // A gap between talk spurts would pin the target at its cap for a
+        // whole spurt; only spacing within a spurt counts
+        if (d <= (int64_t)JB_GAP_FRAMES * JB_FRAME * 1000000 / jb->sample_rate) {
+            int64_t j = (int64_t)jb->jitter_est_us;
+            j += (d - j) >> JB_JITTER_SHIFT;
+            jb->jitter_est_us = (uint32_t)(j < 0 ? 0 : j);
+            atomic_store_explicit(&jb->jitter_us, jb->jitter_est_us, memory_order_relaxed);
+        }
+    }
+    jb->last_arrival_us = arrival_us;
+    jb->last_count = count;
+
+    return audio_ring_write(jb->ring, samples, count);
+}
+
+int jitter_buffer_push(jitter_buffer_t *jb, const int16_t *samples, int count) {
+    return jitter_buffer_push_at(jb, samples, count, get_timestamp_us());
+}
+
+// Target level: one frame plus twice the arrival jitter, capped
+static uint32_t target_level(jitter_buffer_t *jb) {
+    uint64_t jitter = atomic_load_explicit(&jb->jitter_us, memory_order_relaxed);
+    uint64_t target = JB_FRAME + 2 * jitter * (uint64_t)jb->sample_rate / 1000000;
+
+    if (target > (uint64_t)JB_FRAME * JB_MAX_TARGET_FRAMES) {
+        target = (uint64_t)JB_FRAME * JB_MAX_TARGET_FRAMES;
+    }
+    return (uint32_t)target;
+}
+
+// Play in_count input samples over one output frame (linear interpolation)
+static void time_scale(const int16_t *in, int in_count, int16_t *out) {
+    // Fixed-point read position with 16 fractional bits
+    uint32_t step = (uint32_t)(((uint64_t)(in_count - 1) << 16) / (JB_FRAME - 1));
+    uint32_t pos = 0;
+
+    for (int i = 0; i < JB_FRAME; i++) {
+        uint32_t idx = pos >> 16;
+        int32_t frac = (int32_t)(pos & 0xFFFF);
+        int32_t a = in[idx];
+        int32_t b = in[idx + 1 < (uint32_t)in_count ? idx + 1 : idx];
+        out[i] = (int16_t)(a + (((b - a) * frac) >> 16));
+        pos += step;
+    }
+}
+
+// Fill one frame while the ring is dry
+static void conceal_frame(jitter_buffer_t *jb, int16_t *out) {
+    if (jb->conceal_run < JB_REPEAT_FRAMES) {
+        // Repeat the last good frame, halving its level each time
+        int shift = jb->conceal_run + 1;
+        for (int i = 0; i < JB_FRAME; i++) {
+            out[i] = (int16_t)(jb->last_frame[i] >> shift);
+        }
+    } else {
+        // Low-level comfort noise (xorshift32)
+        uint32_t x = jb->noise_seed;
+        for (int i = 0; i < JB_FRAME; i++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            out[i] = (int16_t)((int32_t)(x % (2 * JB_COMFORT_NOISE_LEVEL + 1)) - JB_COMFORT_NOISE_LEVEL);
+        }
+        jb->noise_seed = x;
+    }
+
+    jb->conceal_run++;
+    atomic_fetch_add_explicit(&jb->frames_concealed, 1, memory_order_relaxed);
+}
+
+int jitter_buffer_pull(jitter_buffer_t *jb, int16_t *frame) {
+    if (!jb || !frame) {
+        return -1;
+    }
+
+    uint32_t level = audio_ring_available(jb->ring);
+    uint32_t target = target_level(jb);
+    atomic_store_explicit(&jb->level_samples, level, memory_order_relaxed);
+    atomic_store_explicit(&jb->target_samples, target, memory_order_relaxed);
+
+    if (jb->state == JB_BUFFERING) {
+        if (level < target) {
+            return 0;
+        }
+        jb->state = JB_PLAYING;
+    }
+
+    if (level < JB_FRAME - JB_STRETCH_DELTA) {
+        // Underrun: conceal for a few frames, then go quiet and rebuffer
+        if (jb->state == JB_PLAYING) {
+            jb->state = JB_CONCEALING;
+            jb->conceal_run = 0;
+            atomic_fetch_add_explicit(&jb->concealment_events, 1, memory_order_relaxed);
+        }
+        if (jb->conceal_run >= JB_MAX_CONCEAL_FRAMES) {
+            jb->state = JB_BUFFERING;
+            return 0;
+        }
+        conceal_frame(jb, frame);
+        return JB_FRAME;
+    }
+
+    // Steer the level towards the target with a half-frame dead band
+    int in_count = JB_FRAME;
+    if (level > target + JB_FRAME / 2 && level >= JB_FRAME + JB_STRETCH_DELTA) {
+        in_count = JB_FRAME + JB_STRETCH_DELTA;
+    } else if (level < target - JB_FRAME / 2 || level < JB_FRAME) {
+        in_count = JB_FRAME - JB_STRETCH_DELTA;
+    }
+
+    if (in_count == JB_FRAME) {
+        audio_ring_read(jb->ring, frame, JB_FRAME);
+    } else {
+        audio_ring_read(jb->ring, jb->scratch, in_count);
+        time_scale(jb->scratch, in_count, frame);
+        atomic_fetch_add_explicit(in_count > JB_FRAME ? &jb->frames_compressed : &jb->frames_stretched,
+                                  1, memory_order_relaxed);
+    }
+
+    memcpy(jb->last_frame, frame, sizeof(jb->last_frame));
+    jb->state = JB_PLAYING;
+    jb->conceal_run = 0;
+    atomic_fetch_add_explicit(&jb->frames_played, 1, memory_order_relaxed);
+    return JB_FRAME;
+}
+
+void jitter_buffer_get_stats(jitter_buffer_t *jb, jitter_stats_t *stats) {
+    if (!jb || !stats) return;
+
+    float ms_per_sample = 1000.0f / (float)jb->sample_rate;
+    stats->jitter_ms = (float)atomic_load_explicit(&jb->jitter_us, memory_order_relaxed) / 1000.0f;
+    stats->target_ms = (float)atomic_load_explicit(&jb->target_samples, memory_order_relaxed) * ms_per_sample;
+    stats->latency_ms = (float)atomic_load_explicit(&jb->level_samples, memory_order_relaxed) * ms_per_sample;
+    stats->frames_played = atomic_load_explicit(&jb->frames_played, memory_order_relaxed);
+    stats->frames_concealed = atomic_load_explicit(&jb->frames_concealed, memory_order_relaxed);
+    stats->concealment_events = atomic_load_explicit(&jb->concealment_events, memory_order_relaxed);
+    stats->frames_stretched = atomic_load_explicit(&jb->frames_stretched, memory_order_relaxed);
+    stats->frames_compressed = atomic_load_explicit(&jb->frames_compressed, memory_order_relaxed);
+}
@@ -0,0 +1,234 @@
+/*
+ * End-to-end Latency Probe
+ * Per-stage latency histograms from SDR buffer arrival to audio out
+ *
+ * The SDR thread tags each capture buffer with its arrival time and stamps
+ * the tag after demodulation, burst detection and speech decoding. Decoded
+ * audio queued for playback leaves a mark (ring position, arrival and decode
+ * times) on a small SPSC queue for the ring it goes into: the playout ring,
+ * or its call's mixer stream. The playback thread retires marks as the
+ * jitter buffers pull those samples and adds the device delay ALSA reports,
+ * giving the moment the sample is actually played.
+ *
+ * Histograms are log-linear (8 sub-buckets per power of two, so percentiles
+ * are within 12.5%) with atomic counters: each stage has one writer and the
+ * report can be read at any time.
+ */
+
+#include "tetra_analyzer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LATENCY_CACHE_LINE 64
+#define LATENCY_SUB_BITS 3             // 8 sub-buckets per octave
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_LINEAR (2 * LATENCY_SUB_BUCKETS)   // Exact buckets below 16 us
+#define LATENCY_MAX_BIT 32             // Values clamp at ~71 minutes
+#define LATENCY_BUCKETS (LATENCY_LINEAR + (LATENCY_MAX_BIT - LATENCY_SUB_BITS - 1) * LATENCY_SUB_BUCKETS)
+#define LATENCY_MARKS 64               // Decoded frames in flight per ring, power of two
+
+typedef struct {
+    _Atomic uint64_t buckets[LATENCY_BUCKETS];
+    _Atomic uint64_t count;
+    _Atomic uint64_t max_us;
+} latency_hist_t;
+
+// Decoded audio on its way through the playout ring
+typedef struct {
+    uint32_t position;                 // Ring position of the first sample
+    uint64_t arrival_us;
+    uint64_t decoded_us;
+} latency_mark_t;
+
+// SDR thread produces, playback thread consumes
+typedef struct {
+    _Alignas(LATENCY_CACHE_LINE)
+    _Atomic uint32_t head;
+
+    _Alignas(LATENCY_CACHE_LINE)
+    _Atomic uint32_t tail;
+
+    _Alignas(LATENCY_CACHE_LINE)
+    latency_mark_t marks[LATENCY_MARKS];
+} latency_queue_t;
+
+struct latency_probe {
+    latency_hist_t stages[LATENCY_STAGE_COUNT];
+    latency_queue_t queues[LATENCY_QUEUES];
+    _Atomic uint64_t marks_dropped;    // Queue full: frame not tracked
+};
+
+static const char *STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+    "demodulate",
+    "burst detect",
+    "codec",
+    "playout queue",
+    "device",
+    "end to end"
+};
+
+static int bucket_of(uint64_t us) {
+    if (us < LATENCY_LINEAR) return (int)us;
+
+    int bit = 63 - __builtin_clzll(us);
+    if (bit >= LATENCY_MAX_BIT) return LATENCY_BUCKETS - 1;
+
+    int sub = (int)(us >> (bit - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return LATENCY_LINEAR + (bit - LATENCY_SUB_BITS - 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Largest value that lands in bucket b
+static uint64_t bucket_limit(int b) {
+    if (b < LATENCY_LINEAR) return (uint64_t)b;
+
+    int bit = (b - LATENCY_LINEAR) / LATENCY_SUB_BUCKETS + LATENCY_SUB_BITS + 1;
+    uint64_t sub = (uint64_t)((b - LATENCY_LINEAR) % LATENCY_SUB_BUCKETS);
+    uint64_t base = (LATENCY_SUB_BUCKETS + sub) << (bit - LATENCY_SUB_BITS);
+    return base + (1ULL << (bit - LATENCY_SUB_BITS)) - 1;
+}
+
+latency_probe_t* latency_probe_create(void) {
+    latency_probe_t *probe = aligned_alloc(LATENCY_CACHE_LINE, sizeof(latency_probe_t));
+    if (!probe) {
+        fprintf(stderr, "Failed to allocate latency probe\n");
+        return NULL;
+    }
+    memset(probe, 0, sizeof(latency_probe_t));
+    return probe;
+}
+
+void latency_probe_destroy(latency_probe_t *probe) {
+    free(probe);
+}
+
+void latency_tag_start(latency_tag_t *tag) {
+    if (!tag) return;
+
+    tag->arrival_us = get_timestamp_us();
+    tag->last_us = tag->arrival_us;
+}
+
+void latency_probe_record(latency_probe_t *probe, latency_stage_t stage, uint64_t us) {
+    if (!probe || stage >= LATENCY_STAGE_COUNT) return;
+
+    latency_hist_t *h = &probe->stages[stage];
+    atomic_fetch_add_explicit(&h->buckets[bucket_of(us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+
+    // One writer per stage, so a plain compare is enough
+    if (us > atomic_load_explicit(&h->max_us, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max_us, us, memory_order_relaxed);
+    }
+}
+
+void latency_probe_stage(latency_probe_t *probe, latency_tag_t *tag, latency_stage_t stage) {
+    if (!probe || !tag) return;
+
+    uint64_t now = get_timestamp_us();
+    latency_probe_record(probe, stage, now - tag->last_us);
+    tag->last_us = now;
+}
+
+void latency_probe_queue(latency_probe_t *probe, int queue, const latency_tag_t *tag,
+                         uint32_t position) {
+    if (!probe || !tag || queue < 0 || queue >= LATENCY_QUEUES) return;
+
+    latency_queue_t *q = &probe->queues[queue];
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head - tail >= LATENCY_MARKS) {
+        atomic_fetch_add_explicit(&probe->marks_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    latency_mark_t *m = &q->marks[head & (LATENCY_MARKS - 1)];
+    m->position = position;
+    m->arrival_us = tag->arrival_us;
+    m->decoded_us = tag->last_us;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+}
+
+void latency_probe_played(latency_probe_t *probe, int queue, uint32_t read_position, uint64_t out_us,
+                          int sample_rate) {
+    if (!probe || queue < 0 || queue >= LATENCY_QUEUES || sample_rate <= 0) return;
+
+    latency_queue_t *q = &probe->queues[queue];
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail == head) return;
+
+    uint64_t now = get_timestamp_us();
+    while (tail != head) {
+        latency_mark_t *m = &q->marks[tail & (LATENCY_MARKS - 1)];
+
+        // Free-running positions: the mark is consumed once the read index passes it
+        int32_t behind = (int32_t)(read_position - m->position);
+        if (behind <= 0) break;
+
+        // Samples pulled after this one reach the speaker later than it
+        uint64_t after_us = (uint64_t)behind * 1000000 / (uint64_t)sample_rate;
+        uint64_t played = out_us > now + after_us ? out_us - after_us : now;
+
+        latency_probe_record(probe, LATENCY_STAGE_QUEUE, now - m->decoded_us);
+        latency_probe_record(probe, LATENCY_STAGE_DEVICE, played - now);
+        latency_probe_record(probe, LATENCY_STAGE_TOTAL, played - m->arrival_us);
+        tail++;
+    }
+
+    atomic_store_explicit(&q->tail, tail, memory_order_release);
+}
+
+void latency_probe_summary(latency_probe_t *probe, latency_stage_t stage, latency_summary_t *summary) {
+    if (!summary) return;
+    memset(summary, 0, sizeof(*summary));
+    if (!probe || stage >= LATENCY_STAGE_COUNT) return;
+
+    latency_hist_t *h = &probe->stages[stage];
+    uint64_t counts[LATENCY_BUCKETS];
+    uint64_t total = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        counts[b] = atomic_load_explicit(&h->buckets[b], memory_order_relaxed);
+        total += counts[b];
+    }
+
+    summary->count = total;
+    summary->max_us = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    if (total == 0) return;
+
+    // Nearest rank, reported as the bucket's upper bound (never above the max)
+    uint64_t rank50 = (total * 50 + 99) / 100;
+    uint64_t rank99 = (total * 99 + 99) / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (!counts[b]) continue;
+        uint64_t limit = bucket_limit(b) < summary->max_us ? bucket_limit(b) : summary->max_us;
+        if (seen < rank50 && seen + counts[b] >= rank50) summary->p50_us = limit;
+        if (seen < rank99 && seen + counts[b] >= rank99) summary->p99_us = limit;
+        seen += counts[b];
+    }
+}
+
+void latency_probe_print(latency_probe_t *probe) {
+    if (!probe) return;
+
+    log_message(true, "\nLatency (ms)       samples      p50      p99      max\n");
+    for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        latency_summary_t sum;
+        latency_probe_summary(probe, (latency_stage_t)s, &sum);
+        if (sum.count == 0) {
+            log_message(true, "  %-15s %9s\n", STAGE_NAMES[s], "-");
+            continue;
+        }
+        log_message(true, "  %-15s %9llu %8.2f %8.2f %8.2f\n", STAGE_NAMES[s],
+                    (unsigned long long)sum.count, (double)sum.p50_us / 1000.0,
+                    (double)sum.p99_us / 1000.0, (double)sum.max_us / 1000.0);
+    }
+
+    uint64_t dropped = atomic_load_explicit(&probe->marks_dropped, memory_order_relaxed);
+    if (dropped) {
+        log_message(true, "  %llu decoded frames untracked (mark queue full)\n",
+                    (unsigned long long)dropped);
+    }
+}
@@ -0,0 +1,644 @@
+/*
+ * Asynchronous Logging
+ * Binary log records on per-thread lock-free rings, formatted off the hot path
+ *
+ * A logging thread only copies the call site, format pointer, timestamp and
+ * raw argument values into a fixed-size record on its own SPSC ring - no
+ * formatting, no locks, no syscalls. A background thread merges the rings by
+ * timestamp, runs printf formatting one conversion at a time and writes the
+ * result to stdout. A full ring drops the record and counts it; call sites
+ * with a rate limit count what they suppress. Both counts are reported in
+ * the output stream. A thread's ring is retired when the thread exits and
+ * freed by the background thread once it has drained it, so slots are only
+ * held by live threads.
+ *
+ * Until log_start() (and after log_stop()) records are formatted and written
+ * synchronously, so tools and tests that never start the logger still print.
+ */
+
+#include "tetra_analyzer.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_CACHE_LINE 64
+#define LOG_RING_RECORDS 256           // Per thread, power of two
+#define LOG_MAX_RINGS 128              // Threads logging at once
+#define LOG_MAX_ARGS 12
+#define LOG_RECORD_SIZE 256
+#define LOG_TEXT_BYTES (LOG_RECORD_SIZE - 3 * sizeof(uint64_t) - LOG_MAX_ARGS * sizeof(uint64_t) - 8)
+#define LOG_LINE_MAX 1024
+#define LOG_IDLE_NS 5000000            // Consumer poll interval when all rings are empty
+
+// Argument types, as read from the va_list
+typedef enum {
+    ARG_NONE,                          // %% or unsupported conversion
+    ARG_INT,
+    ARG_UINT,
+    ARG_LONG,
+    ARG_ULONG,
+    ARG_LLONG,
+    ARG_ULLONG,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_UINTMAX,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_STRING,
+    ARG_POINTER
+} log_arg_t;
+
+// One conversion specification from a format string
+typedef struct {
+    const char *start;                 // At the '%'
+    const char *end;                   // Past the conversion character
+    int stars;                         // '*' width/precision arguments before the value
+    log_arg_t type;
+} log_spec_t;
+
+typedef struct {
+    log_site_t *site;
+    const char *format;
+    uint64_t time_ns;
+    uint64_t args[LOG_MAX_ARGS];       // Integers, doubles (bit copy), or text offset | length << 16
+    uint32_t suppressed;               // Records from this site rate limited just before this one
+    uint16_t text_used;
+    uint8_t arg_count;
+    uint8_t truncated;                 // Arguments or string text did not fit
+    char text[LOG_TEXT_BYTES];         // Copies of %s arguments
+} log_record_t;
+
+_Static_assert(sizeof(log_record_t) == LOG_RECORD_SIZE, "log record must be fixed-size");
+
+typedef struct {
+    // Producer-owned cache line
+    _Alignas(LOG_CACHE_LINE)
+    _Atomic uint32_t head;
+    _Atomic uint64_t dropped;          // Records lost because the ring was full
+    _Atomic bool retired;              // Owner exited: free once empty
+
+    // Consumer-owned cache line
+    _Alignas(LOG_CACHE_LINE)
+    _Atomic uint32_t tail;
+
+    _Alignas(LOG_CACHE_LINE)
+    log_record_t records[LOG_RING_RECORDS];
+} log_ring_t;
+
+static struct {
+    _Atomic int level;
+    _Atomic bool running;
+    pthread_t thread;
+    bool at_exit_registered;
+    pthread_mutex_t lock;              // Ring slots, start/stop and synchronous writes
+
+    _Atomic(log_ring_t *) rings[LOG_MAX_RINGS];   // NULL once a retired ring is freed
+    _Atomic int ring_count;            // Slots ever used
+
+    _Atomic uint64_t passes;           // Completed consumer drain passes
+    _Atomic uint64_t written;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t suppressed;
+} g_log = {
+    .level = LOG_LEVEL_INFO,
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static _Thread_local log_ring_t *t_ring;
+static _Thread_local bool t_ring_failed;
+static pthread_key_t g_ring_key;       // Retires the ring when its thread exits
+static pthread_once_t g_ring_key_once = PTHREAD_ONCE_INIT;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Parse the conversion at `p` (just past a '%')
+static const char* parse_spec(const char *p, log_spec_t *spec) {
+    spec->start = p - 1;
+    spec->stars = 0;
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+    if (*p == '*') { spec->stars++; p++; }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { spec->stars++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    // Length modifier
+    char len = 0;
+    if (p[0] == 'h') {
+        p += p[1] == 'h' ? 2 : 1;
+    } else if (p[0] == 'l' && p[1] == 'l') {
+        len = 'L';
+        p += 2;
+    } else if (*p == 'l' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L') {
+        len = *p++;
+    }
+
+    char conv = *p;
+    if (conv) p++;
+    spec->end = p;
+
+    switch (conv) {
+        case 'd': case 'i': case 'c':
+            spec->type = len == 'l' ? ARG_LONG : len == 'L' ? ARG_LLONG : len == 'z' ? ARG_SIZE :
+                         len == 'j' ? ARG_INTMAX : len == 't' ? ARG_PTRDIFF : ARG_INT;
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            spec->type = len == 'l' ? ARG_ULONG : len == 'L' ? ARG_ULLONG : len == 'z' ? ARG_SIZE :
+                         len == 'j' ? ARG_UINTMAX : len == 't' ? ARG_PTRDIFF : ARG_UINT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->type = len == 'L' ? ARG_LDOUBLE : ARG_DOUBLE;
+            break;
+        case 's':
+            spec->type = ARG_STRING;
+            break;
+        case 'p':
+            spec->type = ARG_POINTER;
+            break;
+        default:
+            spec->type = ARG_NONE;     // %%, %n and anything unknown
+            break;
+    }
+    return p;
+}
+
+static void store_string(log_record_t *rec, const char *s) {
+    if (!s) s = "(null)";
+
+    size_t len = strlen(s);
+    size_t room = LOG_TEXT_BYTES - rec->text_used;
+    if (len > room) {
+        len = room;
+        rec->truncated = 1;
+    }
+    memcpy(rec->text + rec->text_used, s, len);
+    rec->args[rec->arg_count++] = rec->text_used | (uint64_t)len << 16;
+    rec->text_used = (uint16_t)(rec->text_used + len);
+}
+
+// Copy the raw arguments of `format` into the record
+static void capture_args(log_record_t *rec, const char *format, va_list args) {
+    const char *p = format;
+    log_spec_t spec;
+
+    while ((p = strchr(p, '%')) != NULL) {
+        p = parse_spec(p + 1, &spec);
+        if (spec.type == ARG_NONE) continue;
+
+        if (rec->arg_count + spec.stars + 1 > LOG_MAX_ARGS) {
+            rec->truncated = 1;
+            return;
+        }
+        for (int i = 0; i < spec.stars; i++) {
+            rec->args[rec->arg_count++] = (uint64_t)(int64_t)va_arg(args, int);
+        }
+
+        uint64_t v = 0;
+        switch (spec.type) {
+            case ARG_INT:     v = (uint64_t)(int64_t)va_arg(args, int); break;
+            case ARG_UINT:    v = va_arg(args, unsigned int); break;
+            case ARG_LONG:    v = (uint64_t)(int64_t)va_arg(args, long); break;
+            case ARG_ULONG:   v = va_arg(args, unsigned long); break;
+            case ARG_LLONG:   v = (uint64_t)va_arg(args, long long); break;
+            case ARG_ULLONG:  v = va_arg(args, unsigned long long); break;
+            case ARG_SIZE:    v = va_arg(args, size_t); break;
+            case ARG_INTMAX:  v = (uint64_t)va_arg(args, intmax_t); break;
+            case ARG_UINTMAX: v = va_arg(args, uintmax_t); break;
+            case ARG_PTRDIFF: v = (uint64_t)va_arg(args, ptrdiff_t); break;
+            case ARG_POINTER: v = (uint64_t)(uintptr_t)va_arg(args, void *); break;
+            case ARG_DOUBLE: {
+                double d = va_arg(args, double);
+                memcpy(&v, &d, sizeof(v));
+                break;
+            }
+            case ARG_LDOUBLE: {
+                double d = (double)va_arg(args, long double);
+                memcpy(&v, &d, sizeof(v));
+                break;
+            }
+            case ARG_STRING:
+                store_string(rec, va_arg(args, const char *));
+                continue;
+            case ARG_NONE:
+                break;
+        }
+        rec->args[rec->arg_count++] = v;
+    }
+}
+
+// Format a record into `line`, one conversion at a time
+static size_t format_record(const log_record_t *rec, char *line, size_t size) {
+    const char *p = rec->format;
+    size_t n = 0;
+    int arg = 0;
+    log_spec_t spec;
+
+    while (*p && n < size - 1) {
+        const char *pct = strchr(p, '%');
+        size_t lit = pct ? (size_t)(pct - p) : strlen(p);
+        if (lit > size - 1 - n) lit = size - 1 - n;
+        memcpy(line + n, p, lit);
+        n += lit;
+        if (!pct) break;
+
+        p = parse_spec(pct + 1, &spec);
+        if (spec.type == ARG_NONE) {
+            if (spec.end - spec.start == 2 && spec.start[1] == '%' && n < size - 1) {
+                line[n++] = '%';
+            }
+            continue;
+        }
+        if (arg + spec.stars + 1 > rec->arg_count) break;
+
+        // Rebuild the conversion with '*' replaced by the captured values
+        char fmt[64];
+        size_t f = 0;
+        for (const char *s = spec.start; s < spec.end && f < sizeof(fmt) - 16; s++) {
+            if (*s == '*') {
+                f += (size_t)snprintf(fmt + f, sizeof(fmt) - f, "%d", (int)rec->args[arg++]);
+            } else {
+                fmt[f++] = *s;
+            }
+        }
+        fmt[f] = '\0';
+
+        uint64_t v = rec->args[arg++];
+        char *out = line + n;
+        size_t room = size - n;
+        int w = 0;
+        double d;
+
+        switch (spec.type) {
+            case ARG_INT:     w = snprintf(out, room, fmt, (int)(int64_t)v); break;
+            case ARG_UINT:    w = snprintf(out, room, fmt, (unsigned int)v); break;
+            case ARG_LONG:    w = snprintf(out, room, fmt, (long)(int64_t)v); break;
+            case ARG_ULONG:   w = snprintf(out, room, fmt, (unsigned long)v); break;
+            case ARG_LLONG:   w = snprintf(out, room, fmt, (long long)v); break;
+            case ARG_ULLONG:  w = snprintf(out, room, fmt, (unsigned long long)v); break;
+            case ARG_SIZE:    w = snprintf(out, room, fmt, (size_t)v); break;
+            case ARG_INTMAX:  w = snprintf(out, room, fmt, (intmax_t)v); break;
+            case ARG_UINTMAX: w = snprintf(out, room, fmt, (uintmax_t)v); break;
+            case ARG_PTRDIFF: w = snprintf(out, room, fmt, (ptrdiff_t)v); break;
+            case ARG_POINTER: w = snprintf(out, room, fmt, (void *)(uintptr_t)v); break;
+            case ARG_DOUBLE:
+                memcpy(&d, &v, sizeof(d));
+                w = snprintf(out, room, fmt, d);
+                break;
+            case ARG_LDOUBLE:
+                memcpy(&d, &v, sizeof(d));
+                w = snprintf(out, room, fmt, (long double)d);
+                break;
+            case ARG_STRING: {
+                // Stored strings are not terminated: print them with a precision
+                char sfmt[72];
+                const char *dot = strchr(fmt, '.');
+                int prec = (int)(v >> 16);
+                if (dot) {
+                    int want = atoi(dot + 1);
+                    if (want < prec) prec = want;
+                    snprintf(sfmt, sizeof(sfmt), "%.*s.*s", (int)(dot - fmt), fmt);
+                } else {
+                    snprintf(sfmt, sizeof(sfmt), "%.*s.*s", (int)strlen(fmt) - 1, fmt);
+                }
+                w = snprintf(out, room, sfmt, prec, rec->text + (v & 0xFFFF));
+                break;
+            }
+            case ARG_NONE:
+                break;
+        }
+        if (w > 0) n += (size_t)w < room ? (size_t)w : room - 1;
+    }
+
+    if (rec->truncated && n + 4 < size) {
+        // Keep a trailing newline after the marker
+        bool nl = n > 0 && line[n - 1] == '\n';
+        if (nl) n--;
+        memcpy(line + n, "...", 3);
+        n += 3;
+        if (nl) line[n++] = '\n';
+    }
+    line[n] = '\0';
+    return n;
+}
+
+static void write_record(const log_record_t *rec) {
+    char line[LOG_LINE_MAX];
+    size_t n = format_record(rec, line, sizeof(line));
+    if (rec->suppressed) {
+        printf("[log] %u similar messages suppressed\n", rec->suppressed);
+    }
+    fwrite(line, 1, n, stdout);
+    atomic_fetch_add_explicit(&g_log.written, 1, memory_order_relaxed);
+}
+
+// Rate limit per call site: at most max_per_sec records in each wall second
+static bool rate_allow(log_site_t *site, uint64_t time_ns) {
+    if (site->max_per_sec == 0) return true;
+
+    uint32_t second = (uint32_t)(time_ns / 1000000000ULL);
+    uint64_t w = atomic_load_explicit(&site->window, memory_order_relaxed);
+    for (;;) {
+        uint64_t next;
+        if ((uint32_t)(w >> 32) != second) {
+            next = (uint64_t)second << 32 | 1;
+        } else if ((uint32_t)w >= site->max_per_sec) {
+            atomic_fetch_add_explicit(&site->suppressed, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&g_log.suppressed, 1, memory_order_relaxed);
+            return false;
+        } else {
+            next = w + 1;
+        }
+        if (atomic_compare_exchange_weak_explicit(&site->window, &w, next,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+// Thread exit: hand the ring to the consumer, which frees it once drained.
+// Anything logged by later destructors on this thread is written synchronously
+static void ring_retire(void *arg) {
+    log_ring_t *ring = (log_ring_t *)arg;
+
+    t_ring = NULL;
+    t_ring_failed = true;
+    atomic_store_explicit(&ring->retired, true, memory_order_release);
+}
+
+static void ring_key_create(void) {
+    if (pthread_key_create(&g_ring_key, ring_retire) != 0) {
+        fprintf(stderr, "Failed to create log ring key; rings of exited threads are kept\n");
+    }
+}
+
+static log_ring_t* thread_ring(void) {
+    if (t_ring || t_ring_failed) return t_ring;
+
+    pthread_once(&g_ring_key_once, ring_key_create);
+
+    log_ring_t *ring = aligned_alloc(LOG_CACHE_LINE, sizeof(log_ring_t));
+    if (!ring) {
+        t_ring_failed = true;
+        return NULL;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->retired, false);
+
+    // Reuse a slot freed by an exited thread before taking a new one
+    pthread_mutex_lock(&g_log.lock);
+    int count = atomic_load_explicit(&g_log.ring_count, memory_order_relaxed);
+    int slot = count < LOG_MAX_RINGS ? count : -1;
+    for (int i = 0; i < count; i++) {
+        if (!atomic_load_explicit(&g_log.rings[i], memory_order_relaxed)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot >= 0) {
+        atomic_store_explicit(&g_log.rings[slot], ring, memory_order_release);
+        if (slot == count) {
+            atomic_store_explicit(&g_log.ring_count, count + 1, memory_order_release);
+        }
+        t_ring = ring;
+    }
+    pthread_mutex_unlock(&g_log.lock);
+
+    // Out of ring slots: this thread keeps logging synchronously
+    if (!t_ring) {
+        free(ring);
+        t_ring_failed = true;
+        return NULL;
+    }
+    pthread_setspecific(g_ring_key, ring);
+    return t_ring;
+}
+
+void log_vwrite(log_site_t *site, const char *format, va_list args) {
+    if (!site || !format) return;
+    if ((int)site->level > atomic_load_explicit(&g_log.level, memory_order_relaxed)) return;
+
+    uint64_t now = monotonic_ns();
+    if (!rate_allow(site, now)) return;
+
+    uint32_t suppressed = 0;
+    if (site->max_per_sec && atomic_load_explicit(&site->suppressed, memory_order_relaxed)) {
+        suppressed = atomic_exchange_explicit(&site->suppressed, 0, memory_order_relaxed);
+    }
+
+    log_ring_t *ring = atomic_load_explicit(&g_log.running, memory_order_acquire) ? thread_ring()
+                                                                                   : NULL;
+    if (!ring) {
+        log_record_t rec;
+        rec.site = site;
+        rec.format = format;
+        rec.time_ns = now;
+        rec.suppressed = suppressed;
+        rec.text_used = 0;
+        rec.arg_count = 0;
+        rec.truncated = 0;
+        capture_args(&rec, format, args);
+
+        pthread_mutex_lock(&g_log.lock);
+        write_record(&rec);
+        fflush(stdout);
+        pthread_mutex_unlock(&g_log.lock);
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= LOG_RING_RECORDS) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    log_record_t *rec = &ring->records[head & (LOG_RING_RECORDS - 1)];
+    rec->site = site;
+    rec->format = format;
+    rec->time_ns = now;
+    rec->suppressed = suppressed;
+    rec->text_used = 0;
+    rec->arg_count = 0;
+    rec->truncated = 0;
+    capture_args(rec, format, args);
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void log_write(log_site_t *site, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    log_vwrite(site, format, args);
+    va_end(args);
+}
+
+// Function form for C++ callers, where log_message is not a macro
+void (log_message)(bool verbose, const char *format, ...) {
+    static log_site_t site = { .level = LOG_LEVEL_INFO };
+    if (!verbose) return;
+
+    va_list args;
+    va_start(args, format);
+    log_vwrite(&site, format, args);
+    va_end(args);
+}
+
+// Merge all rings in timestamp order until every one is empty
+static void drain(void) {
+    int count = atomic_load_explicit(&g_log.ring_count, memory_order_acquire);
+    bool wrote = false;
+
+    for (;;) {
+        log_ring_t *best = NULL;
+        uint64_t best_time = UINT64_MAX;
+
+        for (int i = 0; i < count; i++) {
+            log_ring_t *ring = atomic_load_explicit(&g_log.rings[i], memory_order_acquire);
+            if (!ring) continue;
+
+            uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            if (atomic_load_explicit(&ring->head, memory_order_acquire) == tail) continue;
+
+            uint64_t t = ring->records[tail & (LOG_RING_RECORDS - 1)].time_ns;
+            if (t < best_time) {
+                best_time = t;
+                best = ring;
+            }
+        }
+        if (!best) break;
+
+        uint32_t tail = atomic_load_explicit(&best->tail, memory_order_relaxed);
+        write_record(&best->records[tail & (LOG_RING_RECORDS - 1)]);
+        atomic_store_explicit(&best->tail, tail + 1, memory_order_release);
+        wrote = true;
+    }
+
+    for (int i = 0; i < count; i++) {
+        log_ring_t *ring = atomic_load_explicit(&g_log.rings[i], memory_order_acquire);
+        if (!ring) continue;
+
+        // The owner's last record and drop count come before it retires the ring
+        bool done = atomic_load_explicit(&ring->retired, memory_order_acquire) &&
+                    atomic_load_explicit(&ring->head, memory_order_acquire) ==
+                    atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        uint64_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+        if (dropped) {
+            atomic_fetch_add_explicit(&g_log.dropped, dropped, memory_order_relaxed);
+            printf("[log] %llu messages dropped (ring full)\n", (unsigned long long)dropped);
+            wrote = true;
+        }
+
+        if (done) {
+            pthread_mutex_lock(&g_log.lock);
+            atomic_store_explicit(&g_log.rings[i], NULL, memory_order_relaxed);
+            pthread_mutex_unlock(&g_log.lock);
+            free(ring);
+        }
+    }
+
+    if (wrote) fflush(stdout);
+}
+
+static void* log_thread_func(void *arg) {
+    (void)arg;
+    struct timespec idle = { 0, LOG_IDLE_NS };
+
+    thread_policy_apply(THREAD_ROLE_LOG, -1);
+
+    while (atomic_load_explicit(&g_log.running, memory_order_acquire)) {
+        drain();
+        atomic_fetch_add_explicit(&g_log.passes, 1, memory_order_release);
+        nanosleep(&idle, NULL);
+    }
+
+    drain();
+    thread_policy_leave();
+    return NULL;
+}
+
+void log_set_level(log_level_t level) {
+    atomic_store_explicit(&g_log.level, level, memory_order_relaxed);
+}
+
+int log_start(void) {
+    pthread_mutex_lock(&g_log.lock);
+    if (atomic_load_explicit(&g_log.running, memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_log.lock);
+        return 0;
+    }
+
+    atomic_store_explicit(&g_log.running, true, memory_order_release);
+    if (pthread_create(&g_log.thread, NULL, log_thread_func, NULL) != 0) {
+        atomic_store_explicit(&g_log.running, false, memory_order_release);
+        pthread_mutex_unlock(&g_log.lock);
+        fprintf(stderr, "Failed to start log thread; logging synchronously\n");
+        return -1;
+    }
+
+    // Early returns from main must not lose queued records
+    if (!g_log.at_exit_registered) {
+        atexit(log_stop);
+        g_log.at_exit_registered = true;
+    }
+    pthread_mutex_unlock(&g_log.lock);
+    return 0;
+}
+
+void log_flush(void) {
+    if (!atomic_load_explicit(&g_log.running, memory_order_acquire)) {
+        fflush(stdout);
+        return;
+    }
+
+    // Two completed passes guarantee one started after everything queued so far
+    uint64_t target = atomic_load_explicit(&g_log.passes, memory_order_acquire) + 2;
+    struct timespec wait = { 0, 1000000 };
+    while (atomic_load_explicit(&g_log.passes, memory_order_acquire) < target &&
+           atomic_load_explicit(&g_log.running, memory_order_acquire)) {
+        nanosleep(&wait, NULL);
+    }
+}
+
+// Call once producer threads have stopped; later records are written synchronously
+void log_stop(void) {
+    pthread_mutex_lock(&g_log.lock);
+    if (!atomic_load_explicit(&g_log.running, memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_log.lock);
+        return;
+    }
+    atomic_store_explicit(&g_log.running, false, memory_order_release);
+    pthread_mutex_unlock(&g_log.lock);
+
+    pthread_join(g_log.thread, NULL);
+    fflush(stdout);
+}
+
+void log_get_stats(log_stats_t *stats) {
+    if (!stats) return;
+
+    stats->written = atomic_load_explicit(&g_log.written, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&g_log.dropped, memory_order_relaxed);
+    stats->suppressed = atomic_load_explicit(&g_log.suppressed, memory_order_relaxed);
+
+    // Under the lock, so the consumer cannot free a ring being read
+    pthread_mutex_lock(&g_log.lock);
+    for (int i = 0; i < atomic_load_explicit(&g_log.ring_count, memory_order_relaxed); i++) {
+        log_ring_t *ring = atomic_load_explicit(&g_log.rings[i], memory_order_relaxed);
+        if (ring) stats->dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&g_log.lock);
+}
@@ -0,0 +1,196 @@
+/*
+ * TETRA Lower MAC Channel Coding
+ * Descrambling, block deinterleaving, RCPC depuncturing, Viterbi decoding
+ * and CRC-16 checking for signalling blocks (EN 300 392-2, clause 8)
+ *
+ * Coding chain per logical channel:
+ *   type-1 (payload) + CRC-16 -> type-2, + 4 tail bits -> type-3,
+ *   rate 2/3 RCPC of the K=5 mother code -> type-4 (block interleaved),
+ *   scrambled with the cell's colour code -> type-5 (on air)
+ *
+ * The decoder walks the chain backwards on soft bits and rejects any block
+ * whose CRC does not match, so bit errors never reach the PDU decoder.
+ */
+
+#include "tetra_analyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LMAC_CRC_BITS 16
+#define LMAC_TAIL_BITS 4
+#define LMAC_SCRAMB_INIT 3             // Scrambling code for BSCH / unknown cell
+#define LMAC_SOFT_ONE 127              // Soft value of a confident '1' bit
+
+// Rate 2/3 RCPC puncturing: keep mother bits 1, 2 and 5 of every 8
+#define RCPC_PERIOD 8
+#define RCPC_T 3
+static const uint8_t RCPC_P_2_3[RCPC_T + 1] = { 0, 1, 2, 5 };
+
+typedef struct {
+    uint16_t type1_bits;               // Payload bits
+    uint16_t type5_bits;               // Coded bits on air
+    uint16_t interleave_a;             // Block interleaver parameter a
+    bool colour_scrambled;             // Scrambled with the cell code (not BSCH)
+} lmac_channel_info_t;
+
+static const lmac_channel_info_t LMAC_CHANNELS[] = {
+    [LMAC_CHAN_BSCH]   = {  60, 120,  11, false },
+    [LMAC_CHAN_SCH_HD] = { 124, 216, 101, true },
+    [LMAC_CHAN_SCH_F]  = { 268, 432, 103, true },
+};
+
+// Scrambling LFSR, taps 32 26 23 22 16 12 11 10 8 7 5 4 2 1
+static inline uint8_t scramb_next_bit(uint32_t *lfsr) {
+    uint32_t r = *lfsr;
+    uint32_t bit = (r ^ (r >> 6) ^ (r >> 9) ^ (r >> 10) ^ (r >> 16) ^ (r >> 20) ^
+                    (r >> 21) ^ (r >> 22) ^ (r >> 24) ^ (r >> 25) ^ (r >> 27) ^
+                    (r >> 28) ^ (r >> 30) ^ (r >> 31)) & 1;
+    *lfsr = (r >> 1) | (bit << 31);
+    return (uint8_t)bit;
+}
+
+static uint32_t channel_scramb_init(const lower_mac_t *mac, lmac_channel_t chan) {
+    return LMAC_CHANNELS[chan].colour_scrambled ? mac->scramb_init : LMAC_SCRAMB_INIT;
+}
+
+// Block (de)interleaver index: type-3 bit i (1-based) goes to type-4 bit k
+static inline unsigned interleave_index(unsigned K, unsigned a, unsigned i) {
+    return 1 + (a * i) % K;
+}
+
+// Index of the mother code bit carried by punctured bit j (1-based)
+static inline unsigned rcpc_mother_index(unsigned j) {
+    unsigned block = (j - 1) / RCPC_T;
+    return RCPC_PERIOD * block + RCPC_P_2_3[j - RCPC_T * block];
+}
+
+uint16_t tetra_crc16(const uint8_t *bits, int len) {
+    uint16_t crc = 0xFFFF;
+
+    for (int i = 0; i < len; i++) {
+        if (((crc >> 15) ^ bits[i]) & 1) {
+            crc = (uint16_t)((crc << 1) ^ 0x1021);
+        } else {
+            crc = (uint16_t)(crc << 1);
+        }
+    }
+
+    return (uint16_t)~crc;
+}
+
+void lower_mac_init(lower_mac_t *mac, uint16_t mcc, uint16_t mnc, uint8_t colour_code) {
+    if (!mac) return;
+
+    memset(mac, 0, sizeof(lower_mac_t));
+
+    // Scrambling code: MCC(10) | MNC(14) | colour code(6), then two '1' bits
+    uint32_t code = (uint32_t)(colour_code & 0x3F) |
+                    ((uint32_t)(mnc & 0x3FFF) << 6) |
+                    ((uint32_t)(mcc & 0x3FF) << 20);
+    mac->scramb_init = (code << 2) | LMAC_SCRAMB_INIT;
+}
+
+int lower_mac_type1_bits(lmac_channel_t chan) {
+    return LMAC_CHANNELS[chan].type1_bits;
+}
+
+int lower_mac_type5_bits(lmac_channel_t chan) {
+    return LMAC_CHANNELS[chan].type5_bits;
+}
+
+int lower_mac_decode(lower_mac_t *mac, lmac_channel_t chan, const int8_t *soft,
+                     uint8_t *type1_bits) {
+    if (!mac || !soft || !type1_bits) {
+        return -1;
+    }
+
+    const lmac_channel_info_t *info = &LMAC_CHANNELS[chan];
+    unsigned K = info->type5_bits;
+    int type3_bits = info->type1_bits + LMAC_CRC_BITS + LMAC_TAIL_BITS;
+
+    // Descramble: flip soft values where the scrambling sequence is '1'
+    int8_t type4[LMAC_MAX_TYPE5_BITS];
+    uint32_t lfsr = channel_scramb_init(mac, chan);
+    for (unsigned i = 0; i < K; i++) {
+        int8_t s = soft[i];
+        type4[i] = scramb_next_bit(&lfsr) ? (int8_t)(s == INT8_MIN ? INT8_MAX : -s) : s;
+    }
+
+    // Deinterleave and depuncture straight into the mother code sequence;
+    // punctured positions stay 0 (erasure)
+    int8_t mother[LMAC_MAX_TYPE3_BITS * VITERBI_CODE_RATE];
+    memset(mother, 0, (size_t)type3_bits * VITERBI_CODE_RATE);
+    for (unsigned j = 1; j <= K; j++) {
+        mother[rcpc_mother_index(j) - 1] = type4[interleave_index(K, info->interleave_a, j) - 1];
+    }
+
+    uint8_t type3[LMAC_MAX_TYPE3_BITS];
+    if (viterbi_decode(mother, type3_bits, type3) < 0) {
+        return -1;
+    }
+
+    // CRC over the payload, compared with the 16 received check bits
+    uint16_t crc = tetra_crc16(type3, info->type1_bits);
+    uint16_t rx_crc = 0;
+    for (int i = 0; i < LMAC_CRC_BITS; i++) {
+        rx_crc = (uint16_t)((rx_crc << 1) | type3[info->type1_bits + i]);
+    }
+
+    if (crc != rx_crc) {
+        mac->crc_errors++;
+        return -1;
+    }
+
+    memcpy(type1_bits, type3, info->type1_bits);
+    mac->blocks_ok++;
+    return info->type1_bits;
+}
+
+int lower_mac_decode_hard(lower_mac_t *mac, lmac_channel_t chan, const uint8_t *bits,
+                          uint8_t *type1_bits) {
+    if (!bits) return -1;
+
+    int8_t soft[LMAC_MAX_TYPE5_BITS];
+    int n = LMAC_CHANNELS[chan].type5_bits;
+    for (int i = 0; i < n; i++) {
+        soft[i] = bits[i] ? LMAC_SOFT_ONE : -LMAC_SOFT_ONE;
+    }
+
+    return lower_mac_decode(mac, chan, soft, type1_bits);
+}
+
+int lower_mac_encode(const lower_mac_t *mac, lmac_channel_t chan, const uint8_t *type1_bits,
+                     uint8_t *type5_bits) {
+    if (!mac || !type1_bits || !type5_bits) {
+        return -1;
+    }
+
+    const lmac_channel_info_t *info = &LMAC_CHANNELS[chan];
+    unsigned K = info->type5_bits;
+    int type3_bits = info->type1_bits + LMAC_CRC_BITS + LMAC_TAIL_BITS;
+
+    // Type-3: payload, CRC (MSB first) and zero tail bits
+    uint8_t type3[LMAC_MAX_TYPE3_BITS];
+    memcpy(type3, type1_bits, info->type1_bits);
+    uint16_t crc = tetra_crc16(type1_bits, info->type1_bits);
+    for (int i = 0; i < LMAC_CRC_BITS; i++) {
+        type3[info->type1_bits + i] = (crc >> (LMAC_CRC_BITS - 1 - i)) & 1;
+    }
+    memset(type3 + info->type1_bits + LMAC_CRC_BITS, 0, LMAC_TAIL_BITS);
+
+    uint8_t mother[LMAC_MAX_TYPE3_BITS * VITERBI_CODE_RATE];
+    viterbi_encode(type3, type3_bits, mother);
+
+    // Puncture and interleave, then scramble
+    for (unsigned j = 1; j <= K; j++) {
+        type5_bits[interleave_index(K, info->interleave_a, j) - 1] = mother[rcpc_mother_index(j) - 1];
+    }
+
+    uint32_t lfsr = channel_scramb_init(mac, chan);
+    for (unsigned i = 0; i < K; i++) {
+        type5_bits[i] ^= scramb_next_bit(&lfsr);
+    }
+
+    return (int)K;
+}
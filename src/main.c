@@ -16,10 +16,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <unistd.h>
 #include <getopt.h>
 
-static volatile bool g_running = true;
+#define MAIN_POLL_US 100000            // Housekeeping interval while capturing
+
+static volatile sig_atomic_t g_running = 1;     // Cleared by SIGINT/SIGTERM
+static _Atomic bool g_capture_done;             // SDR thread returned
+static int g_capture_result;
+static volatile sig_atomic_t g_trace_dump = 0;  // SIGUSR1: write the trace rings now
 static tetra_config_t g_config;
 static rtl_sdr_t *g_sdr = NULL;
 static tetra_demod_t *g_demod = NULL;
@@ -27,17 +33,52 @@ static tea1_context_t g_tea1_ctx;
 static audio_output_t *g_audio = NULL;
 static audio_playback_t *g_playback = NULL;
 static tetra_codec_t *g_codec = NULL;
+static audio_mixer_t *g_mixer = NULL;
+static call_recorder_t *g_recorder = NULL;
+static burst_capture_t *g_capture = NULL;
+static stream_clock_t g_stream;              // Sample position of the SDR stream
+static uint64_t g_slot_grant[MAX_ACTIVE_CHANNELS];  // Call each voice slot's stream/recording belongs to
 static detection_params_t *g_params = NULL;
 static detection_status_t *g_status = NULL;
 static channel_manager_t *g_channel_mgr = NULL;
+static latency_probe_t *g_latency = NULL;
+static uint64_t g_buffer_seq = 0;            // SDR buffers delivered, for trace events
+
+// Long-only command line options
+enum {
+    OPT_CELL = 256,
+    OPT_RAW_CONTROL,
+    OPT_STEREO,
+    OPT_RECORD_DIR,
+    OPT_RECORD_FORMAT,
+    OPT_CAPTURE,
+    OPT_BATCH,
+    OPT_JOBS,
+    OPT_LATENCY,
+    OPT_LATENCY_LOOPBACK,
+    OPT_TRACE,
+    OPT_CPUS,
+    OPT_REALTIME,
+    OPT_RT_PRIORITY,
+    OPT_MLOCK,
+    OPT_HUGEPAGES,
+    OPT_FAULT_STATS,
+    OPT_MEMORY_REPORT,
+    OPT_DSP
+};
 
 // Forward declaration
 void sdr_callback(uint8_t *buf, uint32_t len, void *ctx);
 
+// Only async-signal-safe work here: the main loop does the rest
 void signal_handler(int signum) {
     (void)signum;
-    log_message(true, "\nShutting down gracefully...\n");
-    g_running = false;
+    g_running = 0;
+}
+
+void trace_dump_handler(int signum) {
+    (void)signum;
+    g_trace_dump = 1;
 }
 
 void print_banner(void) {
@@ -69,6 +110,39 @@ void print_usage(const char *prog) {
     printf("  -T, --trunking         Enable trunked radio mode 📻\n");
     printf("  -c, --control-freq     Control channel frequency (for trunking)\n");
     printf("  -t, --talk-group ID    Add monitored talk group (can use multiple times)\n");
+    printf("      --cell MCC:MNC:CC  Network code and colour code for descrambling\n");
+    printf("      --raw-control      Control PDUs are not channel coded (lab transmitters)\n");
+    printf("      --stereo           Trunked audio: pan simultaneous calls across stereo\n");
+    printf("      --record-dir DIR   Trunked mode: record each call to its own file in DIR\n");
+    printf("      --record-format F  Call recording format: wav (default) or archive\n");
+    printf("                         (lossless compressed .tca with seek table)\n");
+    printf("      --capture PREFIX   Store every detected burst's bits in PREFIX.tbc\n");
+    printf("                         with a time/frequency/talk group index PREFIX.tbi\n");
+    printf("      --batch DIR        Offline: decode every IQ recording (.cu8/.iq/.raw) and\n");
+    printf("                         burst capture (.tbi) in DIR on all cores, then write\n");
+    printf("                         time-ordered bursts (--capture, replacing what is\n");
+    printf("                         there), messages and audio (-o)\n");
+    printf("      --jobs N           Batch worker threads (default: one per CPU)\n");
+    printf("      --latency          Report p50/p99/max latency per stage, from SDR buffer\n");
+    printf("                         arrival to the sample leaving the sound card\n");
+    printf("      --latency-loopback Measure latency on simulated voice bursts (no dongle)\n");
+    printf("      --trace FILE       Record per-buffer stage timings; written to FILE on exit\n");
+    printf("                         and on SIGUSR1 (.json: Chrome trace, else Perfetto)\n");
+    printf("      --cpus ROLE=LIST   Pin a thread role to CPUs, e.g. capture=2, audio=3,\n");
+    printf("                         gui=0-1 (roles: capture control audio gui log\n");
+    printf("                         recorder batch; repeatable)\n");
+    printf("      --realtime         SCHED_FIFO for capture (60) and audio (70); needs\n");
+    printf("                         CAP_SYS_NICE or an rtprio limit, else ignored\n");
+    printf("      --rt-priority ROLE=N  SCHED_FIFO priority 1-99 for one role (repeatable)\n");
+    printf("      --mlock            Lock all memory (mlockall) so nothing is paged out;\n");
+    printf("                         needs CAP_IPC_LOCK or a high enough ulimit -l\n");
+    printf("      --hugepages        Back sample buffers with huge pages (vm.nr_hugepages,\n");
+    printf("                         else transparent huge pages)\n");
+    printf("      --fault-stats      Report minor/major page faults per stage at exit\n");
+    printf("      --memory-report    Report memory in use and peak per subsystem at exit\n");
+    printf("      --dsp PATH         Demodulator arithmetic: float or q15 (fixed point, for\n");
+    printf("                         FPU-weak cores such as the Cortex-A53; default %s)\n",
+           dsp_path_name(dsp_get_path()));
     printf("  -v, --verbose          Verbose output\n");
     printf("  -k, --use-vulnerability Use known TEA1 vulnerability\n");
     printf("  -h, --help             Show this help\n\n");
@@ -80,6 +154,10 @@ void print_usage(const char *prog) {
     printf("  %s -f 420000000 -k -o audio.wav # Crack and save audio\n", prog);
     printf("  %s -f 420000000 -G              # Launch with graphical interface\n", prog);
     printf("  %s -T -c 420000000 -t 1 -t 2 -r # Trunked mode: follow TG 1 & 2\n", prog);
+    printf("  %s --batch lab/ -k -o all.wav   # Reprocess recordings offline\n", prog);
+    printf("  %s --latency-loopback -r        # Measure pipeline latency to the speaker\n", prog);
+    printf("  %s -k -r --realtime --cpus capture=2 --cpus audio=3  # Pi: dedicated cores\n", prog);
+    printf("  %s -k -r --realtime --mlock --fault-stats  # Check for faults on the hot path\n", prog);
     printf("\n");
     printf("Trunked Radio Mode:\n");
     printf("  In trunked mode, the analyzer monitors a control channel and automatically\n");
@@ -89,45 +167,192 @@ void print_usage(const char *prog) {
     printf("\n");
 }
 
-// SDR thread wrapper for GUI mode
+// SDR capture thread
 void* rtl_sdr_start_wrapper(void *arg) {
     (void)arg;
-    rtl_sdr_start(g_sdr, sdr_callback, NULL);
+    g_capture_result = rtl_sdr_start(g_sdr, sdr_callback, NULL);
+    atomic_store(&g_capture_done, true);
     return NULL;
 }
 
+// What the signal handlers only flag, done here and never on the SDR thread:
+// file I/O there would cause the very stalls a trace is taken to find
+static void* housekeeping_loop(void *arg) {
+    (void)arg;
+    while (g_running && !atomic_load(&g_capture_done)) {
+        if (g_trace_dump) {
+            g_trace_dump = 0;
+            trace_write(g_config.trace_file, trace_format_for_path(g_config.trace_file));
+        }
+        usleep(MAIN_POLL_US);
+    }
+    return NULL;
+}
+
+// CLI mode: the SDR thread captures while the main thread waits for it to
+// finish or for a signal
+static int run_capture(void) {
+    pthread_t sdr_thread;
+    if (pthread_create(&sdr_thread, NULL, rtl_sdr_start_wrapper, NULL) != 0) {
+        return -1;
+    }
+
+    housekeeping_loop(NULL);
+    if (!g_running) {
+        log_message(true, "\nShutting down gracefully...\n");
+    }
+
+    rtl_sdr_stop(g_sdr);
+    pthread_join(sdr_thread, NULL);
+    return g_capture_result;
+}
+
+// Voice channel slot being followed, or -1 outside a call. A new grant on
+// a slot reopens its mixer stream and starts a new recording.
+static int current_voice_slot(void) {
+    if (!g_channel_mgr) return -1;
+
+    int idx = g_channel_mgr->current_channel_idx;
+    if (idx < 0 || idx >= MAX_ACTIVE_CHANNELS) return -1;
+
+    voice_channel_t *ch = &g_channel_mgr->voice_channels[idx];
+    if (!ch->active) return -1;
+
+    if (g_slot_grant[idx] != ch->grant_time) {
+        if (g_mixer) {
+            talk_group_t *tg = channel_manager_get_talk_group(g_channel_mgr, ch->talk_group_id);
+            if (audio_mixer_stream_open(g_mixer, idx, tg ? tg->priority : 0, ch->emergency) < 0) {
+                return -1;
+            }
+            if (g_config.stereo_audio) {
+                // Spread slots over five positions from left to right
+                audio_mixer_stream_set_pan(g_mixer, idx, (float)(idx % 5 - 2) * 0.4f);
+            }
+        }
+        if (g_recorder) {
+            call_recorder_start_call(g_recorder, idx, ch);
+        }
+        g_slot_grant[idx] = ch->grant_time;
+    }
+
+    return idx;
+}
+
+// Append the burst just detected on `demod` to the capture file
+static void capture_burst(tetra_demod_t *demod, uint64_t burst_time) {
+    burst_index_entry_t meta;
+    memset(&meta, 0, sizeof(meta));
+    meta.timestamp_us = burst_time;
+    meta.frequency = g_config.frequency;
+    meta.correlation = demod->sync_correlation;
+    meta.power = demod->signal_power;
+    meta.sync_offset = demod->sync_offset;
+    meta.bit_count = (uint16_t)demod->bit_count;
+
+    if (g_channel_mgr) {
+        meta.frequency = g_channel_mgr->current_frequency;
+        int idx = g_channel_mgr->current_channel_idx;
+        if (demod != g_channel_mgr->control_demod && idx >= 0 && idx < MAX_ACTIVE_CHANNELS &&
+            g_channel_mgr->voice_channels[idx].active) {
+            meta.talk_group = g_channel_mgr->voice_channels[idx].talk_group_id;
+        }
+    }
+
+    // The demodulator makes hard decisions only, so no soft bits are stored
+    burst_capture_write(g_capture, &meta, demod->demod_bits, NULL);
+}
+
+// Close recordings of calls the control channel has released
+static void end_released_calls(void) {
+    if (!g_channel_mgr) return;
+
+    for (int i = 0; i < MAX_ACTIVE_CHANNELS; i++) {
+        if (g_slot_grant[i] && !g_channel_mgr->voice_channels[i].active) {
+            call_recorder_end_call(g_recorder, i);
+            g_slot_grant[i] = 0;
+        }
+    }
+}
+
 void sdr_callback(uint8_t *buf, uint32_t len, void *ctx) {
     (void)ctx;
 
     if (!g_running) return;
 
+    uint64_t seq = g_buffer_seq++;
+
     // In trunking mode, use channel manager's demodulator
     tetra_demod_t *active_demod = g_demod;
     if (g_config.enable_trunking && g_channel_mgr) {
         // If on control channel, use control demodulator
         if (g_channel_mgr->current_frequency == g_config.trunking.control_channel_freq) {
             active_demod = g_channel_mgr->control_demod;
+        } else if (g_channel_mgr->current_channel_idx >= 0) {
+            // Followed voice channel: its own demodulator once the monitor thread has made it
+            tetra_demod_t *demod = atomic_load_explicit(
+                &g_channel_mgr->voice_channels[g_channel_mgr->current_channel_idx].demod,
+                memory_order_acquire);
+            if (demod) active_demod = demod;
         }
     }
 
+    // Control channel bursts carry signalling, not speech
+    tetra_demod_t *voice_demod = active_demod;
+    if (g_channel_mgr && active_demod == g_channel_mgr->control_demod) {
+        voice_demod = NULL;
+    }
+
+    // Latency is measured from the moment the buffer is handed over
+    latency_tag_t tag;
+    if (g_latency) latency_tag_start(&tag);
+
+    // Bursts are stamped by their position in the sample stream
+    uint64_t buffer_start = g_stream.samples;
+    stream_clock_advance(&g_stream, len / 2);
+
     // Process samples through TETRA demodulator
-    if (tetra_demod_process(active_demod, buf, len) > 0) {
+    rt_fault_mark_t faults;
+    rt_faults_begin(&faults);
+    uint64_t trace_start = TRACE_BEGIN();
+    int demodulated = tetra_demod_process(active_demod, buf, len);
+    TRACE_END(trace_start, "dsp", "demodulate", "seq", seq, "samples", len / 2,
+              "bits", demodulated);
+    rt_faults_end(&faults, RT_STAGE_DEMOD);
+    if (g_latency) latency_probe_stage(g_latency, &tag, LATENCY_STAGE_DEMOD);
+
+    if (demodulated > 0) {
         // Check if we detected a TETRA burst
-        if (tetra_detect_burst(active_demod)) {
-            log_message(g_config.verbose, "TETRA burst detected!\n");
+        rt_faults_begin(&faults);
+        trace_start = TRACE_BEGIN();
+        bool detected = tetra_detect_burst(active_demod);
+        TRACE_END(trace_start, "dsp", "burst detect", "seq", seq, "bursts", detected,
+                  "power", active_demod->signal_power);
+        rt_faults_end(&faults, RT_STAGE_DETECT);
+        if (g_latency) latency_probe_stage(g_latency, &tag, LATENCY_STAGE_DETECT);
+
+        if (detected) {
+            uint64_t burst_time = stream_clock_time_us(&g_stream, buffer_start +
+                                                       tetra_demod_sync_sample(active_demod));
+            LOG_AT(LOG_LEVEL_DEBUG, 100, "TETRA burst detected!\n");
+
+            if (g_capture) {
+                capture_burst(active_demod, burst_time);
+            }
 
             // In trunking mode, try to decode control channel messages
             if (g_config.enable_trunking && g_channel_mgr &&
                 active_demod == g_channel_mgr->control_demod) {
                 ctrl_message_t ctrl_msg;
-                if (decode_control_channel_data(active_demod->demod_bits,
-                                               active_demod->bit_count, &ctrl_msg)) {
+                if (channel_manager_decode_control_burst(g_channel_mgr, active_demod, &ctrl_msg)) {
+                    ctrl_msg.timestamp = burst_time;
                     channel_manager_process_control_message(g_channel_mgr, &ctrl_msg);
+                    end_released_calls();
                 }
             }
 
             // Attempt TEA1 decryption if we have encrypted data
-            if (g_config.use_known_vulnerability && g_demod->bit_count >= TETRA_CODEC_FRAME_SIZE) {
+            if (g_config.use_known_vulnerability && voice_demod &&
+                voice_demod->bit_count >= TETRA_CODEC_FRAME_SIZE) {
                 uint8_t encrypted_bits[TETRA_CODEC_FRAME_SIZE / 8 + 1];
                 uint8_t decrypted_bits[TETRA_CODEC_FRAME_SIZE / 8 + 1];
 
@@ -136,8 +361,8 @@ void sdr_callback(uint8_t *buf, uint32_t len, void *ctx) {
                 for (int i = 0; i < byte_count; i++) {
                     encrypted_bits[i] = 0;
                     for (int j = 0; j < 8 && (i * 8 + j) < TETRA_CODEC_FRAME_SIZE; j++) {
-                        if (i * 8 + j < g_demod->bit_count) {
-                            encrypted_bits[i] |= (g_demod->demod_bits[i * 8 + j] << (7 - j));
+                        if (i * 8 + j < voice_demod->bit_count) {
+                            encrypted_bits[i] |= (voice_demod->demod_bits[i * 8 + j] << (7 - j));
                         }
                     }
                 }
@@ -145,22 +370,58 @@ void sdr_callback(uint8_t *buf, uint32_t len, void *ctx) {
                 // Decrypt the frame (simplified - treating as stream)
                 tea1_decrypt_stream(&g_tea1_ctx, encrypted_bits, decrypted_bits, byte_count);
 
-                if (g_config.verbose && g_demod->bit_count >= TEA1_BLOCK_SIZE * 8) {
+                if (g_config.verbose && voice_demod->bit_count >= TEA1_BLOCK_SIZE * 8) {
                     hex_dump(encrypted_bits, TEA1_BLOCK_SIZE, "Encrypted");
                     hex_dump(decrypted_bits, TEA1_BLOCK_SIZE, "Decrypted");
                 }
 
                 // Decode TETRA audio codec if we have enough data
-                if (g_codec && g_demod->bit_count >= TETRA_CODEC_FRAME_SIZE) {
+                if (g_codec && voice_demod->bit_count >= TETRA_CODEC_FRAME_SIZE) {
                     int16_t audio_samples[TETRA_CODEC_SAMPLES];
 
-                    // Decode the audio frame
-                    int decoded = tetra_codec_decode_frame(g_codec, decrypted_bits, audio_samples);
+                    // Decode the audio frame (into its call's mixer stream when trunking)
+                    int slot = current_voice_slot();
+                    uint32_t position = (slot >= 0 && g_mixer)
+                        ? audio_mixer_write_position(g_mixer, slot) : 0;
+                    rt_faults_begin(&faults);
+                    trace_start = TRACE_BEGIN();
+                    int decoded = (slot >= 0 && g_mixer)
+                        ? audio_mixer_decode_frame(g_mixer, slot, decrypted_bits, audio_samples)
+                        : tetra_codec_decode_frame(g_codec, decrypted_bits, audio_samples);
+                    TRACE_END(trace_start, "codec", "decode frame", "seq", seq,
+                              "samples", decoded, "slot", slot);
+                    rt_faults_end(&faults, RT_STAGE_CODEC);
 
                     if (decoded > 0) {
+                        if (g_latency) latency_probe_stage(g_latency, &tag, LATENCY_STAGE_CODEC);
+
                         // Send to real-time playback if enabled
                         if (g_playback && g_config.enable_realtime_audio) {
-                            audio_playback_write(g_playback, audio_samples, decoded);
+                            if (g_mixer) {
+                                if (slot >= 0) {
+                                    // The stream's ring now holds the frame from position on
+                                    if (g_latency) {
+                                        latency_probe_queue(g_latency, LATENCY_QUEUE_MIXER(slot),
+                                                            &tag, position);
+                                    }
+                                    audio_playback_notify(g_playback);
+                                }
+                            } else {
+                                audio_playback_write_tagged(g_playback, audio_samples, decoded,
+                                                            g_latency ? &tag : NULL);
+                            }
+                        }
+
+                        // Without a device the audio ends at the decoder; frames the
+                        // mixer has no stream for are never played and not counted
+                        if (g_latency && !(g_playback && g_config.enable_realtime_audio)) {
+                            latency_probe_record(g_latency, LATENCY_STAGE_TOTAL,
+                                                 tag.last_us - tag.arrival_us);
+                        }
+
+                        // Per-call recording
+                        if (g_recorder && slot >= 0) {
+                            call_recorder_write(g_recorder, slot, audio_samples, decoded);
                         }
 
                         // Also write to file if specified
@@ -186,9 +447,13 @@ int main(int argc, char **argv) {
     g_config.verbose = false;
     g_config.use_known_vulnerability = false;
     g_config.enable_realtime_audio = false;
+    g_config.stereo_audio = false;
     g_config.enable_gui = false;
     g_config.enable_trunking = false;
     g_config.output_file = NULL;
+    g_config.record_dir = NULL;
+    g_config.record_format = RECORD_FORMAT_WAV;
+    thread_policy_init(&g_config.threads);
 
     // Initialize trunking configuration
     g_config.trunking.enabled = false;
@@ -198,10 +463,15 @@ int main(int argc, char **argv) {
     g_config.trunking.priority_threshold = 0;
     g_config.trunking.hold_time_ms = 2000;  // 2 seconds
     g_config.trunking.emergency_override = true;
+    g_config.trunking.raw_control = false;
+    g_config.trunking.mcc = 0;
+    g_config.trunking.mnc = 0;
+    g_config.trunking.colour_code = 0;
 
     // Track talk groups to monitor
     uint32_t monitored_talk_groups[32];
     int monitored_tg_count = 0;
+    bool realtime = false;
 
     // Parse command line arguments
     static struct option long_options[] = {
@@ -219,6 +489,25 @@ int main(int argc, char **argv) {
         {"verbose", no_argument, 0, 'v'},
         {"use-vulnerability", no_argument, 0, 'k'},
         {"help", no_argument, 0, 'h'},
+        {"cell", required_argument, 0, OPT_CELL},
+        {"raw-control", no_argument, 0, OPT_RAW_CONTROL},
+        {"stereo", no_argument, 0, OPT_STEREO},
+        {"record-dir", required_argument, 0, OPT_RECORD_DIR},
+        {"record-format", required_argument, 0, OPT_RECORD_FORMAT},
+        {"capture", required_argument, 0, OPT_CAPTURE},
+        {"batch", required_argument, 0, OPT_BATCH},
+        {"jobs", required_argument, 0, OPT_JOBS},
+        {"latency", no_argument, 0, OPT_LATENCY},
+        {"latency-loopback", no_argument, 0, OPT_LATENCY_LOOPBACK},
+        {"trace", required_argument, 0, OPT_TRACE},
+        {"cpus", required_argument, 0, OPT_CPUS},
+        {"realtime", no_argument, 0, OPT_REALTIME},
+        {"rt-priority", required_argument, 0, OPT_RT_PRIORITY},
+        {"mlock", no_argument, 0, OPT_MLOCK},
+        {"hugepages", no_argument, 0, OPT_HUGEPAGES},
+        {"fault-stats", no_argument, 0, OPT_FAULT_STATS},
+        {"memory-report", no_argument, 0, OPT_MEMORY_REPORT},
+        {"dsp", required_argument, 0, OPT_DSP},
         {0, 0, 0, 0}
     };
 
@@ -275,6 +564,95 @@ int main(int argc, char **argv) {
             case 'k':
                 g_config.use_known_vulnerability = true;
                 break;
+            case OPT_TRACE:
+                g_config.trace_file = optarg;
+                break;
+            case OPT_CPUS:
+                if (thread_policy_parse_cpus(&g_config.threads, optarg) < 0) {
+                    fprintf(stderr, "Error: --cpus expects ROLE=CPULIST (e.g. capture=2 or gui=0-1)\n");
+                    return 1;
+                }
+                break;
+            case OPT_REALTIME:
+                realtime = true;
+                break;
+            case OPT_RT_PRIORITY:
+                if (thread_policy_parse_priority(&g_config.threads, optarg) < 0) {
+                    fprintf(stderr, "Error: --rt-priority expects ROLE=PRIORITY (1-99)\n");
+                    return 1;
+                }
+                break;
+            case OPT_MLOCK:
+                g_config.lock_memory = true;
+                break;
+            case OPT_HUGEPAGES:
+                g_config.huge_pages = true;
+                break;
+            case OPT_FAULT_STATS:
+                g_config.fault_stats = true;
+                break;
+            case OPT_MEMORY_REPORT:
+                g_config.memory_report = true;
+                break;
+            case OPT_DSP:
+                if (strcmp(optarg, "float") == 0) {
+                    dsp_set_path(DSP_PATH_FLOAT);
+                } else if (strcmp(optarg, "q15") == 0) {
+                    dsp_set_path(DSP_PATH_Q15);
+                } else {
+                    fprintf(stderr, "Invalid --dsp '%s' (expected float or q15)\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_CELL: {
+                unsigned mcc, mnc, cc;
+                if (sscanf(optarg, "%u:%u:%u", &mcc, &mnc, &cc) != 3 ||
+                    mcc > 0x3FF || mnc > 0x3FFF || cc > 0x3F) {
+                    fprintf(stderr, "Error: --cell expects MCC:MNC:CC (e.g. 204:1337:1)\n");
+                    return 1;
+                }
+                g_config.trunking.mcc = (uint16_t)mcc;
+                g_config.trunking.mnc = (uint16_t)mnc;
+                g_config.trunking.colour_code = (uint8_t)cc;
+                break;
+            }
+            case OPT_RAW_CONTROL:
+                g_config.trunking.raw_control = true;
+                break;
+            case OPT_STEREO:
+                g_config.stereo_audio = true;
+                break;
+            case OPT_RECORD_DIR:
+                g_config.record_dir = optarg;
+                break;
+            case OPT_RECORD_FORMAT:
+                if (strcmp(optarg, "wav") == 0) {
+                    g_config.record_format = RECORD_FORMAT_WAV;
+                } else if (strcmp(optarg, "archive") == 0) {
+                    g_config.record_format = RECORD_FORMAT_ARCHIVE;
+                } else {
+                    fprintf(stderr, "Invalid --record-format '%s' (expected wav or archive)\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_CAPTURE:
+                g_config.capture_prefix = optarg;
+                break;
+            case OPT_BATCH:
+                g_config.batch_dir = optarg;
+                break;
+            case OPT_JOBS:
+                g_config.batch_jobs = atoi(optarg);
+                break;
+            case OPT_LATENCY:
+                g_config.latency_probe = true;
+                break;
+            case OPT_LATENCY_LOOPBACK:
+                // Loopback bursts are voice: run them through TEA1 and the codec
+                g_config.latency_probe = true;
+                g_config.latency_loopback = true;
+                g_config.use_known_vulnerability = true;
+                break;
             case 'h':
                 print_banner();
                 print_usage(argv[0]);
@@ -295,9 +673,43 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    // Every thread started from here on takes its role's affinity and priority
+    if (realtime) {
+        thread_policy_set_realtime(&g_config.threads);
+    }
+    thread_policy_set(&g_config.threads);
+
+    // Formatting and terminal I/O move to the log thread from here on
+    log_set_level(g_config.verbose ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO);
+    log_start();
+
+    // Before any pipeline buffer is allocated, so all of them are locked and resident
+    rt_memory_init(g_config.lock_memory, g_config.huge_pages);
+    rt_faults_enable(g_config.fault_stats);
+    bool memory_report = g_config.lock_memory || g_config.huge_pages || g_config.fault_stats ||
+                         g_config.memory_report;
+
+    if (g_config.trace_file) {
+        trace_set_enabled(true);
+    }
+
+    // Offline mode needs no dongle, GUI or live pipeline
+    if (g_config.batch_dir) {
+        int ret = batch_run(&g_config) == 0 ? 0 : 1;
+        if (g_config.trace_file) {
+            trace_write(g_config.trace_file, trace_format_for_path(g_config.trace_file));
+        }
+        thread_policy_report();
+        if (memory_report) rt_memory_report();
+        return ret;
+    }
+
     // Setup signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    if (g_config.trace_file) {
+        signal(SIGUSR1, trace_dump_handler);
+    }
 
     // Initialize components
     log_message(true, "Initializing TETRA analyzer...\n");
@@ -352,8 +764,13 @@ int main(int argc, char **argv) {
     uint8_t default_key[TEA1_KEY_SIZE] = {0}; // Will be cracked
     tea1_init(&g_tea1_ctx, default_key, g_config.use_known_vulnerability);
 
-    // Initialize TETRA codec (needed for real-time audio or file output)
-    if (g_config.enable_realtime_audio || g_config.output_file) {
+    if (g_config.latency_probe) {
+        g_latency = latency_probe_create();
+    }
+
+    // Initialize TETRA codec (needed for real-time audio, file output or latency)
+    if (g_config.enable_realtime_audio || g_config.output_file || g_config.record_dir ||
+        g_config.latency_probe) {
         g_codec = tetra_codec_init();
         if (!g_codec) {
             fprintf(stderr, "Warning: Failed to initialize TETRA codec\n");
@@ -362,8 +779,17 @@ int main(int argc, char **argv) {
 
     // Initialize real-time audio playback if enabled
     if (g_config.enable_realtime_audio) {
-        g_playback = audio_playback_init(TETRA_AUDIO_SAMPLE_RATE);
+        // Trunked mode can follow several calls; give each its own stream
+        if (g_config.enable_trunking) {
+            g_mixer = audio_mixer_init(TETRA_AUDIO_SAMPLE_RATE, g_config.stereo_audio ? 2 : 1);
+            if (!g_mixer) {
+                fprintf(stderr, "Warning: Failed to initialize audio mixer\n");
+            }
+        }
+
+        g_playback = audio_playback_init(TETRA_AUDIO_SAMPLE_RATE, g_mixer);
         if (g_playback) {
+            audio_playback_set_latency_probe(g_playback, g_latency);
             audio_playback_start(g_playback);
             log_message(true, "\n");
         } else {
@@ -380,6 +806,28 @@ int main(int argc, char **argv) {
         }
     }
 
+    // Initialize per-call recording (trunked mode follows calls by slot)
+    if (g_config.record_dir) {
+        if (!g_config.enable_trunking) {
+            fprintf(stderr, "Warning: --record-dir needs trunked mode (-T); ignoring\n");
+        } else {
+            // fdatasync every 1 MB bounds data lost on power failure to ~1 minute of audio
+            g_recorder = call_recorder_init(g_config.record_dir, TETRA_AUDIO_SAMPLE_RATE, 1024 * 1024,
+                                            g_config.record_format);
+            if (!g_recorder) {
+                fprintf(stderr, "Warning: Failed to initialize call recorder\n");
+            }
+        }
+    }
+
+    // Initialize raw burst capture if specified
+    if (g_config.capture_prefix) {
+        g_capture = burst_capture_open(g_config.capture_prefix);
+        if (!g_capture) {
+            fprintf(stderr, "Warning: Failed to open burst capture\n");
+        }
+    }
+
     // Initialize trunked radio system if enabled
     if (g_config.enable_trunking) {
         log_message(true, "\n📻 Initializing trunked radio system...\n");
@@ -427,6 +875,7 @@ int main(int argc, char **argv) {
 
     // Start SDR capture
     log_message(true, "Starting SDR capture...\n");
+    stream_clock_init(&g_stream, g_config.sample_rate, get_timestamp_us());
     if (g_config.enable_realtime_audio) {
         log_message(true, "🎧 Real-time audio enabled - listen to your speakers!\n");
     }
@@ -439,7 +888,7 @@ int main(int argc, char **argv) {
     if (g_config.enable_gui) {
         // Start SDR capture in background thread for GUI mode
         pthread_t sdr_thread;
-        if (pthread_create(&sdr_thread, NULL, (void*(*)(void*))rtl_sdr_start_wrapper, NULL) != 0) {
+        if (pthread_create(&sdr_thread, NULL, rtl_sdr_start_wrapper, NULL) != 0) {
             fprintf(stderr, "Failed to start SDR thread\n");
 #ifdef HAVE_IMGUI
             if (gui) tetra_gui_cleanup(gui);
@@ -451,20 +900,27 @@ int main(int argc, char **argv) {
             return 1;
         }
 
+        // The GUI owns the main thread, so flagged signal work gets its own
+        pthread_t housekeeping_thread;
+        bool housekeeping = pthread_create(&housekeeping_thread, NULL, housekeeping_loop, NULL) == 0;
+
         // Run GUI main loop (blocks until window is closed)
+        thread_policy_apply(THREAD_ROLE_GUI, -1);
         tetra_gui_run(gui);
+        thread_policy_leave();
 
         // Signal SDR to stop
-        g_running = false;
+        g_running = 0;
         rtl_sdr_stop(g_sdr);
         pthread_join(sdr_thread, NULL);
+        if (housekeeping) pthread_join(housekeeping_thread, NULL);
 
         // Cleanup GUI
         tetra_gui_cleanup(gui);
     } else {
 #endif
-        // Traditional CLI mode - SDR runs in main thread
-        if (rtl_sdr_start(g_sdr, sdr_callback, NULL) < 0) {
+        // CLI mode
+        if (run_capture() < 0) {
             fprintf(stderr, "Failed to start SDR capture\n");
             tetra_demod_cleanup(g_demod);
             rtl_sdr_cleanup(g_sdr);
@@ -478,6 +934,7 @@ int main(int argc, char **argv) {
 
     // Cleanup
     log_message(true, "\nCleaning up...\n");
+    log_flush();  // Statistics below are printed directly
 
     // Stop channel manager if running
     if (g_channel_mgr) {
@@ -495,14 +952,38 @@ int main(int argc, char **argv) {
         audio_playback_cleanup(g_playback);
     }
 
+    if (g_mixer) {
+        audio_mixer_print_statistics(g_mixer);
+        audio_mixer_cleanup(g_mixer);
+    }
+
     if (g_audio) {
         audio_output_cleanup(g_audio);
     }
 
+    if (g_recorder) {
+        call_recorder_cleanup(g_recorder);
+    }
+
+    if (g_capture) {
+        burst_capture_close(g_capture);
+    }
+
     if (g_codec) {
         tetra_codec_cleanup(g_codec);
     }
 
+    if (g_config.trace_file) {
+        trace_set_enabled(false);
+        trace_write(g_config.trace_file, trace_format_for_path(g_config.trace_file));
+    }
+
+    // After playback has drained, so every queued frame has been retired
+    if (g_latency) {
+        latency_probe_print(g_latency);
+        latency_probe_destroy(g_latency);
+    }
+
     if (g_status) {
         detection_status_cleanup(g_status);
     }
@@ -511,7 +992,10 @@ int main(int argc, char **argv) {
         detection_params_cleanup(g_params);
     }
 
+    thread_policy_report();
+    if (memory_report) rt_memory_report();
     log_message(true, "Shutdown complete.\n");
+    log_stop();
 
     return 0;
 }
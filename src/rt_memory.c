@@ -0,0 +1,368 @@
+/*
+ * Real-time Memory
+ * Pre-faulted, locked, aligned arena for pipeline buffers, and page fault
+ * accounting per pipeline stage
+ *
+ * Sample buffers, rings and decoder state come from chunks that are mapped
+ * and populated up front, so every page is resident before the first buffer arrives
+ * instead of being faulted in (and zeroed by the kernel) on first touch in
+ * the real-time path. Blocks are cache-line aligned, which also satisfies
+ * every SIMD load in the DSP kernels.
+ *
+ * Requests are rounded up to a size class (64, 96, 128, 192, ... bytes: powers
+ * of two and their midpoints, so at most a third is slack), and a freed block
+ * goes on its class's free list for the next request of that class: reuse is
+ * O(1), and memory that varying sizes free is not stranded. Blocks above
+ * RT_CLASS_MAX get a mapping of their own, unmapped again when freed; small
+ * chunks are kept until exit.
+ *
+ * Allocation takes a mutex and can map and populate a chunk, so the real-time
+ * threads allocate nothing while capturing. Everything on the capture and
+ * audio paths, mixer streams included, is created at startup. After that the
+ * arena serves only off-path callers: the channel monitor thread (voice
+ * demodulators), recorder setup, batch workers, and tetra_bench.
+ *
+ * Every block is charged to a subsystem pool, and memory allocated outside
+ * the arena (the call recorder's page-aligned write buffers, per-thread
+ * trace rings) is accounted for with rt_memory_account(), so the exit report
+ * shows where a small board's RAM goes.
+ *
+ * Optionally chunks are backed by huge pages (MAP_HUGETLB from the reserved
+ * pool, else transparent huge pages), and the whole process is locked with
+ * mlockall(MCL_ONFAULT) so nothing can be swapped out; MCL_ONFAULT keeps the
+ * lock from populating every thread's 8 MB stack up front.
+ */
+
+#define _GNU_SOURCE
+#include "tetra_analyzer.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#define RT_ALIGN 64                    // Cache line, and the widest SIMD load
+#define RT_CHUNK_SIZE (2u << 20)       // One huge page
+#define RT_HUGE_PAGE (2u << 20)
+#define RT_CLASS_MAX (RT_CHUNK_SIZE / 4)   // Larger blocks are mapped on their own
+#define RT_CLASS_COUNT 27              // 64 B .. RT_CLASS_MAX
+#define RT_CLASS_LARGE -1
+
+// Precedes every block; padded so the block itself stays aligned
+typedef struct rt_block {
+    size_t size;                       // Usable bytes: the class size
+    struct rt_block *next;             // Free list link while free
+    int pool;                          // Subsystem charged for the block
+    int size_class;                    // Index, or RT_CLASS_LARGE for its own mapping
+    char pad[RT_ALIGN - sizeof(size_t) - sizeof(void *) - 2 * sizeof(int)];
+} rt_block_t;
+
+typedef struct rt_chunk {
+    struct rt_chunk *next;
+    size_t size;
+    size_t used;
+    bool huge;                         // Backed by reserved huge pages
+} rt_chunk_t;
+
+static struct {
+    pthread_mutex_t lock;
+    bool huge_pages;
+    bool huge_warned;
+    bool locked;                       // mlockall succeeded
+    rt_chunk_t *chunks;                // Newest first; allocation bumps the head
+    rt_block_t *free_lists[RT_CLASS_COUNT];
+    rt_memory_stats_t stats;
+} g_rt = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static const char *STAGE_NAMES[RT_STAGE_COUNT] = {
+    "capture", "demodulate", "burst detect", "codec", "playback"
+};
+
+static const char *POOL_NAMES[RT_POOL_COUNT] = {
+    "capture", "demodulators", "codec", "audio", "trunking", "recorder", "batch", "trace"
+};
+
+static _Atomic bool g_faults_enabled;
+static _Atomic uint64_t g_minor_faults[RT_STAGE_COUNT];
+static _Atomic uint64_t g_major_faults[RT_STAGE_COUNT];
+
+static size_t round_up(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+// Class k holds 64 << k/2 bytes, half as much again for odd k
+static size_t class_size(int k) {
+    size_t size = (size_t)RT_ALIGN << (k / 2);
+    return k % 2 ? size + size / 2 : size;
+}
+
+// Smallest class holding `size` bytes, or RT_CLASS_LARGE
+static int size_class(size_t size) {
+    for (int k = 0; k < RT_CLASS_COUNT; k++) {
+        if (class_size(k) >= size) return k;
+    }
+    return RT_CLASS_LARGE;
+}
+
+int rt_memory_init(bool lock_memory, bool huge_pages) {
+    pthread_mutex_lock(&g_rt.lock);
+    g_rt.huge_pages = huge_pages;
+    pthread_mutex_unlock(&g_rt.lock);
+
+    if (!lock_memory) return 0;
+
+    int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+    flags |= MCL_ONFAULT;
+#endif
+    int ret = mlockall(flags);
+#ifdef MCL_ONFAULT
+    if (ret < 0 && errno == EINVAL) {
+        ret = mlockall(MCL_CURRENT | MCL_FUTURE);   // Kernels before 4.4
+    }
+#endif
+    if (ret < 0) {
+        log_message(true, "⚠ mlockall failed (%s): memory may be swapped out. Raise the memlock "
+                    "limit (ulimit -l) or grant CAP_IPC_LOCK\n", strerror(errno));
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_rt.lock);
+    g_rt.locked = true;
+    pthread_mutex_unlock(&g_rt.lock);
+    log_message(true, "Memory locked (mlockall)\n");
+    return 0;
+}
+
+// Map one populated chunk of at least `size` bytes, huge pages if asked
+static rt_chunk_t* map_chunk(size_t size) {
+    void *p = MAP_FAILED;
+    bool huge = false;
+
+    if (g_rt.huge_pages) {
+#ifdef MAP_HUGETLB
+        size = round_up(size, RT_HUGE_PAGE);
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        huge = p != MAP_FAILED;
+#endif
+        if (!huge && !g_rt.huge_warned) {
+            g_rt.huge_warned = true;
+            log_message(true, "⚠ No reserved huge pages (vm.nr_hugepages): using transparent huge pages\n");
+        }
+    }
+    if (p == MAP_FAILED) {
+        size = round_up(size, RT_HUGE_PAGE);
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            fprintf(stderr, "Failed to map %zu bytes of pipeline memory: %s\n", size, strerror(errno));
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        // No reserved pool: let khugepaged back it transparently instead
+        if (g_rt.huge_pages) madvise(p, size, MADV_HUGEPAGE);
+#endif
+        // Populate after the advice so THP can be used for the first faults
+        memset(p, 0, size);
+    }
+
+    rt_chunk_t *chunk = p;
+    chunk->size = size;
+    chunk->used = round_up(sizeof(rt_chunk_t), RT_ALIGN);
+    chunk->huge = huge;
+
+    g_rt.stats.mapped_bytes += size;
+    if (huge) g_rt.stats.huge_bytes += size;
+    g_rt.stats.chunks++;
+    return chunk;
+}
+
+// Caller holds g_rt.lock
+static void charge(int pool, long delta) {
+    g_rt.stats.pool_bytes[pool] += (size_t)delta;
+    if (g_rt.stats.pool_bytes[pool] > g_rt.stats.pool_peak[pool]) {
+        g_rt.stats.pool_peak[pool] = g_rt.stats.pool_bytes[pool];
+    }
+}
+
+// Caller holds g_rt.lock
+static void* alloc_large(size_t need) {
+    size_t header = round_up(sizeof(rt_chunk_t), RT_ALIGN);
+    rt_chunk_t *chunk = map_chunk(header + sizeof(rt_block_t) + need);
+    if (!chunk) return NULL;
+
+    // Behind the current chunk, which keeps bumping
+    if (g_rt.chunks) {
+        chunk->next = g_rt.chunks->next;
+        g_rt.chunks->next = chunk;
+    } else {
+        chunk->next = NULL;
+        g_rt.chunks = chunk;
+    }
+
+    rt_block_t *b = (rt_block_t *)((uint8_t *)chunk + header);
+    b->size = need;
+    b->size_class = RT_CLASS_LARGE;
+    chunk->used = chunk->size;
+    return b + 1;
+}
+
+// Caller holds g_rt.lock
+static void free_large(rt_block_t *b) {
+    rt_chunk_t *chunk = (rt_chunk_t *)((uint8_t *)b - round_up(sizeof(rt_chunk_t), RT_ALIGN));
+    for (rt_chunk_t **link = &g_rt.chunks; *link; link = &(*link)->next) {
+        if (*link == chunk) {
+            *link = chunk->next;
+            break;
+        }
+    }
+
+    g_rt.stats.mapped_bytes -= chunk->size;
+    if (chunk->huge) g_rt.stats.huge_bytes -= chunk->size;
+    g_rt.stats.chunks--;
+    munmap(chunk, chunk->size);
+}
+
+// Caller holds g_rt.lock
+static void* alloc_class(int k) {
+    size_t need = class_size(k);
+
+    // A freed block of the class is already resident
+    rt_block_t *b = g_rt.free_lists[k];
+    if (b) {
+        g_rt.free_lists[k] = b->next;
+        b->next = NULL;
+        memset(b + 1, 0, need);
+        return b + 1;
+    }
+
+    size_t total = need + sizeof(rt_block_t);
+    rt_chunk_t *chunk = g_rt.chunks;
+    if (!chunk || chunk->size - chunk->used < total) {
+        chunk = map_chunk(RT_CHUNK_SIZE);
+        if (!chunk) return NULL;
+        chunk->next = g_rt.chunks;
+        g_rt.chunks = chunk;
+    }
+
+    b = (rt_block_t *)((uint8_t *)chunk + chunk->used);
+    b->size = need;
+    b->size_class = k;
+    b->next = NULL;
+    chunk->used += total;
+    return b + 1;
+}
+
+void* rt_alloc(rt_pool_t pool, size_t size) {
+    if (size == 0 || pool >= RT_POOL_COUNT) return NULL;
+
+    int k = size_class(size);
+
+    pthread_mutex_lock(&g_rt.lock);
+    void *ptr = k == RT_CLASS_LARGE ? alloc_large(round_up(size, RT_ALIGN)) : alloc_class(k);
+    if (ptr) {
+        rt_block_t *b = (rt_block_t *)ptr - 1;
+        b->pool = pool;
+        charge(pool, (long)b->size);
+        g_rt.stats.used_bytes += b->size;
+        if (g_rt.stats.used_bytes > g_rt.stats.peak_bytes) {
+            g_rt.stats.peak_bytes = g_rt.stats.used_bytes;
+        }
+    }
+    pthread_mutex_unlock(&g_rt.lock);
+    return ptr;
+}
+
+void rt_free(void *ptr) {
+    if (!ptr) return;
+
+    rt_block_t *b = (rt_block_t *)ptr - 1;
+    pthread_mutex_lock(&g_rt.lock);
+    g_rt.stats.used_bytes -= b->size;
+    charge(b->pool, -(long)b->size);
+    if (b->size_class == RT_CLASS_LARGE) {
+        free_large(b);
+    } else {
+        b->next = g_rt.free_lists[b->size_class];
+        g_rt.free_lists[b->size_class] = b;
+    }
+    pthread_mutex_unlock(&g_rt.lock);
+}
+
+void rt_memory_account(rt_pool_t pool, long delta) {
+    if (pool >= RT_POOL_COUNT) return;
+
+    pthread_mutex_lock(&g_rt.lock);
+    charge(pool, delta);
+    pthread_mutex_unlock(&g_rt.lock);
+}
+
+void rt_memory_get_stats(rt_memory_stats_t *stats) {
+    if (!stats) return;
+
+    pthread_mutex_lock(&g_rt.lock);
+    *stats = g_rt.stats;
+    stats->locked = g_rt.locked;
+    pthread_mutex_unlock(&g_rt.lock);
+}
+
+void rt_faults_enable(bool enabled) {
+    atomic_store_explicit(&g_faults_enabled, enabled, memory_order_relaxed);
+}
+
+void rt_faults_begin(rt_fault_mark_t *mark) {
+    mark->valid = false;
+    if (!atomic_load_explicit(&g_faults_enabled, memory_order_relaxed)) return;
+
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        mark->minor = ru.ru_minflt;
+        mark->major = ru.ru_majflt;
+        mark->valid = true;
+    }
+}
+
+void rt_faults_end(rt_fault_mark_t *mark, rt_stage_t stage) {
+    if (!mark->valid || stage >= RT_STAGE_COUNT) return;
+
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        atomic_fetch_add_explicit(&g_minor_faults[stage], (uint64_t)(ru.ru_minflt - mark->minor),
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&g_major_faults[stage], (uint64_t)(ru.ru_majflt - mark->major),
+                                  memory_order_relaxed);
+    }
+}
+
+void rt_memory_report(void) {
+    rt_memory_stats_t stats;
+    rt_memory_get_stats(&stats);
+
+    log_message(true, "\nPipeline memory: %.1f MB mapped in %u chunks (%.1f MB huge pages), "
+                "peak %.1f MB in use, %s\n", (double)stats.mapped_bytes / 1048576.0, stats.chunks,
+                (double)stats.huge_bytes / 1048576.0, (double)stats.peak_bytes / 1048576.0,
+                stats.locked ? "locked" : "not locked");
+
+    log_message(true, "Memory (KB)          in use     peak\n");
+    for (int p = 0; p < RT_POOL_COUNT; p++) {
+        if (!stats.pool_peak[p]) continue;
+        log_message(true, "  %-15s %9.1f %8.1f\n", POOL_NAMES[p], (double)stats.pool_bytes[p] / 1024.0,
+                    (double)stats.pool_peak[p] / 1024.0);
+    }
+
+    if (!atomic_load_explicit(&g_faults_enabled, memory_order_relaxed)) return;
+
+    log_message(true, "Page faults        minor    major\n");
+    for (int s = 0; s < RT_STAGE_COUNT; s++) {
+        log_message(true, "  %-15s %8llu %8llu\n", STAGE_NAMES[s],
+                    (unsigned long long)atomic_load_explicit(&g_minor_faults[s], memory_order_relaxed),
+                    (unsigned long long)atomic_load_explicit(&g_major_faults[s], memory_order_relaxed));
+    }
+
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        log_message(true, "  %-15s %8ld %8ld\n", "process total", ru.ru_minflt, ru.ru_majflt);
+    }
+}
@@ -4,6 +4,7 @@
  */
 
 #include "tetra_analyzer.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -33,6 +34,33 @@ static int rtlsdr_read_sync(rtlsdr_dev_t *dev, void *buf, int len, int *n_read)
 }
 #endif
 
+#define LOOPBACK_SYMBOL_SAMPLES (TETRA_SAMPLE_RATE / TETRA_SYMBOL_RATE)
+#define LOOPBACK_DEVIATION 0.4f        // FM deviation, radians per sample
+#define LOOPBACK_SYNC_OFFSET 300       // Training sequence position, clear of the codec frame
+
+// One buffer holding a single voice burst: random payload with the training
+// sequence, frequency-shift modulated so each symbol is centred on the
+// demodulator's sampling instant
+static void generate_voice_burst(uint8_t *iq, uint32_t len) {
+    uint8_t bits[TETRA_BURST_LENGTH];
+    for (int b = 0; b < TETRA_BURST_LENGTH; b++) {
+        bits[b] = (uint8_t)(rand() & 1);
+    }
+    memcpy(bits + LOOPBACK_SYNC_OFFSET, TETRA_TRAINING_SEQ, TETRA_TRAINING_SEQ_BITS);
+
+    float phase = 0.0f;
+    for (uint32_t n = 0; n < len / 2; n++) {
+        uint32_t sym = (n + LOOPBACK_SYMBOL_SAMPLES / 2) / LOOPBACK_SYMBOL_SAMPLES;
+        float dir = sym < TETRA_BURST_LENGTH ? (bits[sym] ? 1.0f : -1.0f) : 0.0f;
+        phase += dir * LOOPBACK_DEVIATION;
+        if (phase > (float)M_PI) phase -= 2.0f * (float)M_PI;
+        if (phase < -(float)M_PI) phase += 2.0f * (float)M_PI;
+
+        iq[2 * n] = (uint8_t)lrintf(127.5f + 60.0f * cosf(phase) + (float)(rand() % 5 - 2));
+        iq[2 * n + 1] = (uint8_t)lrintf(127.5f + 60.0f * sinf(phase) + (float)(rand() % 5 - 2));
+    }
+}
+
 rtl_sdr_t* rtl_sdr_init(tetra_config_t *config) {
     rtl_sdr_t *sdr = calloc(1, sizeof(rtl_sdr_t));
     if (!sdr) {
@@ -40,6 +68,16 @@ rtl_sdr_t* rtl_sdr_init(tetra_config_t *config) {
         return NULL;
     }
 
+    // The loopback test never touches a dongle
+    if (config->latency_loopback) {
+        sdr->frequency = config->frequency;
+        sdr->sample_rate = config->sample_rate;
+        sdr->gain = config->gain;
+        sdr->loopback = true;
+        sdr->running = true;
+        return sdr;
+    }
+
     int device_count = rtlsdr_get_device_count();
     if (device_count == 0) {
         fprintf(stderr, "No RTL-SDR devices found.\n");
@@ -54,7 +92,7 @@ rtl_sdr_t* rtl_sdr_init(tetra_config_t *config) {
         sdr->frequency = config->frequency;
         sdr->sample_rate = config->sample_rate;
         sdr->gain = config->gain;
-        sdr->running = false;
+        sdr->running = true;
         return sdr;
     }
 
@@ -100,6 +138,7 @@ rtl_sdr_t* rtl_sdr_init(tetra_config_t *config) {
 
     // Reset buffer
     rtlsdr_reset_buffer(dev);
+    sdr->running = true;
 
     log_message(config->verbose, "RTL-SDR initialized successfully\n");
 
@@ -109,43 +148,72 @@ rtl_sdr_t* rtl_sdr_init(tetra_config_t *config) {
 int rtl_sdr_start(rtl_sdr_t *sdr, void (*callback)(uint8_t *buf, uint32_t len, void *ctx), void *ctx) {
     if (!sdr) return -1;
 
-    sdr->running = true;
+    // running was set at init and only rtl_sdr_stop() clears it, so a stop
+    // that comes before this thread gets going is not undone
+    thread_policy_apply(THREAD_ROLE_CAPTURE, -1);
 
     // If no device (simulation mode), generate test data
     if (!sdr->dev) {
-        log_message(true, "Running in SIMULATION mode - generating test TETRA signals\n");
+        log_message(true, sdr->loopback ? "Running latency LOOPBACK - one voice burst per buffer\n"
+                                         : "Running in SIMULATION mode - generating test TETRA signals\n");
+
+        uint8_t *test_buffer = rt_alloc(RT_POOL_CAPTURE, SDR_BUFFER_SIZE);
+        if (!test_buffer) {
+            thread_policy_leave();
+            return -1;
+        }
 
-        uint8_t *test_buffer = malloc(SDR_BUFFER_SIZE);
-        if (!test_buffer) return -1;
+        // Loopback paces buffers at the rate a dongle would deliver them
+        uint64_t buffer_us = (uint64_t)SDR_BUFFER_SIZE / 2 * 1000000 / sdr->sample_rate;
+        uint64_t next_us = get_timestamp_us();
 
         // Generate simulated I/Q data
         for (int iteration = 0; iteration < 100 && sdr->running; iteration++) {
-            // Generate pseudo-random I/Q samples with TETRA-like characteristics
-            for (int i = 0; i < SDR_BUFFER_SIZE; i++) {
-                // Simple simulation: noise + carrier
-                test_buffer[i] = 127 + (rand() % 50) - 25;
+            rt_fault_mark_t faults;
+            rt_faults_begin(&faults);
+            if (sdr->loopback) {
+                generate_voice_burst(test_buffer, SDR_BUFFER_SIZE);
+
+                // Buffer complete once its last sample would have arrived
+                next_us += buffer_us;
+                uint64_t now = get_timestamp_us();
+                if (next_us > now) usleep((useconds_t)(next_us - now));
+            } else {
+                // Generate pseudo-random I/Q samples with TETRA-like characteristics
+                for (int i = 0; i < SDR_BUFFER_SIZE; i++) {
+                    // Simple simulation: noise + carrier
+                    test_buffer[i] = 127 + (rand() % 50) - 25;
+                }
             }
+            rt_faults_end(&faults, RT_STAGE_CAPTURE);
 
             // Call callback with test data
             callback(test_buffer, SDR_BUFFER_SIZE, ctx);
 
-            usleep(100000); // 100ms delay
+            if (!sdr->loopback) {
+                usleep(100000); // 100ms delay
+            }
         }
 
-        free(test_buffer);
+        rt_free(test_buffer);
+        thread_policy_leave();
         return 0;
     }
 
     // Real RTL-SDR reading
-    uint8_t *buffer = malloc(SDR_BUFFER_SIZE);
+    uint8_t *buffer = rt_alloc(RT_POOL_CAPTURE, SDR_BUFFER_SIZE);
     if (!buffer) {
         fprintf(stderr, "Failed to allocate read buffer\n");
+        thread_policy_leave();
         return -1;
     }
 
     while (sdr->running) {
         int n_read = 0;
+        rt_fault_mark_t faults;
+        rt_faults_begin(&faults);
         int r = rtlsdr_read_sync(sdr->dev, buffer, SDR_BUFFER_SIZE, &n_read);
+        rt_faults_end(&faults, RT_STAGE_CAPTURE);
 
         if (r < 0) {
             fprintf(stderr, "RTL-SDR read error\n");
@@ -157,7 +225,8 @@ int rtl_sdr_start(rtl_sdr_t *sdr, void (*callback)(uint8_t *buf, uint32_t len, v
         }
     }
 
-    free(buffer);
+    rt_free(buffer);
+    thread_policy_leave();
     return 0;
 }
 
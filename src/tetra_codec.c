@@ -4,6 +4,9 @@
  *
  * TETRA uses ACELP (Algebraic Code Excited Linear Prediction) codec
  * This is a simplified educational implementation for demonstration
+ *
+ * The decoder is streaming: LPC synthesis and de-emphasis filter memories
+ * are kept in tetra_codec_t, so consecutive frames join without clicks.
  */
 
 #include "tetra_analyzer.h"
@@ -12,23 +15,72 @@
 #include <string.h>
 #include <math.h>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // LPC (Linear Predictive Coding) order
 #define LPC_ORDER 10
 
-// Extract bits from byte array
-static uint32_t extract_bits(const uint8_t *data, int start_bit, int num_bits) {
-    uint32_t result = 0;
-
-    for (int i = 0; i < num_bits; i++) {
-        int byte_idx = (start_bit + i) / 8;
-        int bit_idx = 7 - ((start_bit + i) % 8);
+// Synthesis taps padded to a multiple of 4 for SIMD; must match synth_mem
+#define LPC_TAPS_PADDED 12
+
+// Output scaling to int16 (leaves 6 dB of headroom)
+#define CODEC_OUTPUT_SCALE 16384.0f
+
+// Frames synthesized per int16 conversion pass in the batch API
+#define CODEC_BATCH_FRAMES 8
+
+// Quantized parameters of one frame
+typedef struct {
+    uint32_t lpc;                      // 10 x 3-bit LPC indices
+    uint32_t pitch_period;             // 7 bits
+    uint32_t pitch_gain;               // 4 bits
+    uint64_t codebook;                 // 52 bits: pulse positions and signs
+    uint32_t fixed_gain;               // 10 bits
+} codec_params_t;
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
 
-        if (data[byte_idx] & (1 << bit_idx)) {
-            result |= (1 << (num_bits - 1 - i));
-        }
+// Field of width bits at bit offset off of the 128-bit big-endian word w0:w1
+static inline uint64_t frame_field(uint64_t w0, uint64_t w1, int off, int width) {
+    uint64_t v;
+    if (off >= 64) {
+        v = w1 << (off - 64);
+    } else if (off > 0) {
+        v = (w0 << off) | (w1 >> (64 - off));
+    } else {
+        v = w0;
     }
+    return v >> (64 - width);
+}
 
-    return result;
+// Unpack frame parameters with two word loads and constant shifts
+// Frame layout (simplified):
+// - LPC parameters: 30 bits       (bit 0)
+// - Pitch period: 7 bits          (bit 30)
+// - Pitch gain: 4 bits            (bit 37)
+// - Fixed codebook: 4 pulses, 52 bits (bit 41)
+// - Fixed gain: 10 bits           (bit 93)
+// - Remaining gains: 34 bits (unused by this decoder)
+static inline void unpack_params(const uint8_t *frame, codec_params_t *p) {
+    uint64_t w0 = load_be64(frame);
+    uint64_t w1 = load_be64(frame + 8);
+
+    p->lpc = (uint32_t)frame_field(w0, w1, 0, 30);
+    p->pitch_period = (uint32_t)frame_field(w0, w1, 30, 7);
+    p->pitch_gain = (uint32_t)frame_field(w0, w1, 37, 4);
+    p->codebook = frame_field(w0, w1, 41, 52);
+    p->fixed_gain = (uint32_t)frame_field(w0, w1, 93, 10);
 }
 
 // Decode LPC coefficients from quantized values
@@ -46,7 +98,7 @@ static void decode_lpc_coeffs(uint32_t lpc_params, float *coeffs) {
 }
 
 // Generate excitation signal from codebook
-static void generate_excitation(tetra_codec_t *codec, uint32_t codebook_idx,
+static void generate_excitation(tetra_codec_t *codec, uint64_t codebook_idx,
                                 float gain, float *excitation) {
     (void)codec; // Reserved for future adaptive codebook implementation
 
@@ -65,44 +117,76 @@ static void generate_excitation(tetra_codec_t *codec, uint32_t codebook_idx,
     }
 }
 
-// LPC synthesis filter
-static void lpc_synthesis(const float *lpc_coeffs, const float *excitation,
-                         float *output, int length) {
-    float state[LPC_ORDER] = {0};
+// Dot product of 12 history samples with the padded, reversed coefficients
+static inline float lpc_predict(const float *hist, const float *taps) {
+#if defined(__SSE__)
+    __m128 acc = _mm_mul_ps(_mm_loadu_ps(hist), _mm_load_ps(taps));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(hist + 4), _mm_load_ps(taps + 4)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(hist + 8), _mm_load_ps(taps + 8)));
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON)
+    float32x4_t acc = vmulq_f32(vld1q_f32(hist), vld1q_f32(taps));
+    acc = vmlaq_f32(acc, vld1q_f32(hist + 4), vld1q_f32(taps + 4));
+    acc = vmlaq_f32(acc, vld1q_f32(hist + 8), vld1q_f32(taps + 8));
+#if defined(__aarch64__)
+    return vaddvq_f32(acc);
+#else
+    float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#endif
+#else
+    float acc = 0.0f;
+    for (int m = 0; m < LPC_TAPS_PADDED; m++) {
+        acc += hist[m] * taps[m];
+    }
+    return acc;
+#endif
+}
 
-    for (int n = 0; n < length; n++) {
-        float prediction = 0.0f;
-
-        // LPC prediction
-        for (int k = 0; k < LPC_ORDER; k++) {
-            if (n - k - 1 >= 0) {
-                prediction += lpc_coeffs[k] * output[n - k - 1];
-            } else {
-                prediction += lpc_coeffs[k] * state[LPC_ORDER - 1 + (n - k - 1)];
-            }
-        }
+// LPC synthesis filter
+// Runs over one contiguous buffer: the previous frame's last outputs followed
+// by the current frame, so the tap window never needs a bounds branch.
+static void lpc_synthesis(tetra_codec_t *codec, const float *excitation,
+                          float *output, int length) {
+    // Reversed coefficients: taps[m] weights hist[n + m], i.e. output[n - 12 + m]
+    float taps[LPC_TAPS_PADDED] __attribute__((aligned(16))) = {0};
+    for (int k = 0; k < LPC_ORDER; k++) {
+        taps[LPC_TAPS_PADDED - 1 - k] = codec->lpc_coeffs[k];
+    }
 
-        // Add excitation
-        output[n] = excitation[n] + prediction;
+    float hist[LPC_TAPS_PADDED + TETRA_CODEC_SAMPLES];
+    memcpy(hist, codec->synth_mem, sizeof(codec->synth_mem));
+    float *y = hist + LPC_TAPS_PADDED;
 
-        // Apply soft limiting
-        if (output[n] > 1.0f) output[n] = 1.0f;
-        if (output[n] < -1.0f) output[n] = -1.0f;
+    for (int n = 0; n < length; n++) {
+        // Add excitation, then soft limit
+        float v = excitation[n] + lpc_predict(&hist[n], taps);
+        y[n] = fminf(fmaxf(v, -1.0f), 1.0f);
     }
+
+    memcpy(output, y, length * sizeof(float));
+    memcpy(codec->synth_mem, &hist[length], sizeof(codec->synth_mem));
 }
 
 // Post-processing and de-emphasis filter
-static void post_process(float *samples, int length) {
-    // De-emphasis filter (inverse pre-emphasis)
-    float alpha = 0.95f;
-
-    for (int i = length - 1; i > 0; i--) {
-        samples[i] = samples[i] + alpha * samples[i - 1];
+// y[n] = x[n] + alpha * x[n - 1], with x[-1] carried over from the last frame
+static void post_process(tetra_codec_t *codec, float *samples, int length) {
+    const float alpha = 0.95f;
+    float prev = codec->deemph_mem;
+
+    for (int i = 0; i < length; i++) {
+        float x = samples[i];
+        samples[i] = x + alpha * prev;
+        prev = x;
     }
+
+    codec->deemph_mem = prev;
 }
 
 tetra_codec_t* tetra_codec_init(void) {
-    tetra_codec_t *codec = calloc(1, sizeof(tetra_codec_t));
+    tetra_codec_t *codec = rt_alloc(RT_POOL_CODEC, sizeof(tetra_codec_t));
     if (!codec) {
         fprintf(stderr, "Failed to allocate TETRA codec structure\n");
         return NULL;
@@ -117,85 +201,115 @@ tetra_codec_t* tetra_codec_init(void) {
         codec->lpc_coeffs[i] = 0.0f;
     }
 
-    log_message(true, "TETRA codec initialized (ACELP-based, 8 kHz)\n");
+    // One per mixer stream as well, so detail rather than info
+    LOG_AT(LOG_LEVEL_DEBUG, 0, "TETRA codec initialized (ACELP-based, 8 kHz)\n");
 
     return codec;
 }
 
-int tetra_codec_decode_frame(tetra_codec_t *codec, const uint8_t *encoded_bits,
-                             int16_t *audio_samples) {
-    if (!codec || !encoded_bits || !audio_samples) {
-        return -1;
-    }
-
-    // TETRA codec frame structure (simplified):
-    // - LPC parameters: 30 bits
-    // - Pitch period: 7 bits
-    // - Pitch gain: 4 bits
-    // - Fixed codebook: 4 pulses × 13 bits = 52 bits
-    // - Gains: 20 bits
-    // Total: ~137 bits per frame
-
-    // Extract parameters from bitstream
-    uint32_t lpc_params = extract_bits(encoded_bits, 0, 30);
-    uint32_t pitch_period_idx = extract_bits(encoded_bits, 30, 7);
-    uint32_t pitch_gain_idx = extract_bits(encoded_bits, 37, 4);
-    uint32_t codebook_idx = extract_bits(encoded_bits, 41, 52);
-    uint32_t fixed_gain_idx = extract_bits(encoded_bits, 93, 10);
-
+// Decode one frame's parameters to float samples, advancing codec state
+static void decode_params(tetra_codec_t *codec, const codec_params_t *params, float *decoded_samples) {
     // Decode LPC coefficients
-    decode_lpc_coeffs(lpc_params, codec->lpc_coeffs);
+    decode_lpc_coeffs(params->lpc, codec->lpc_coeffs);
 
     // Decode pitch parameters
-    codec->pitch_period = 20.0f + (float)pitch_period_idx * 0.5f;  // 20-83.5 samples
-    codec->pitch_gain = (float)pitch_gain_idx / 15.0f;  // 0.0 to 1.0
+    codec->pitch_period = 20.0f + (float)params->pitch_period * 0.5f;  // 20-83.5 samples
+    codec->pitch_gain = (float)params->pitch_gain / 15.0f;  // 0.0 to 1.0
 
     // Decode gain
-    float fixed_gain = powf(10.0f, ((float)fixed_gain_idx - 512.0f) / 20.0f / 20.0f);
+    float fixed_gain = powf(10.0f, ((float)params->fixed_gain - 512.0f) / 20.0f / 20.0f);
 
     // Generate excitation signal
     float excitation[TETRA_CODEC_SAMPLES];
-    generate_excitation(codec, codebook_idx, fixed_gain, excitation);
-
-    // Add pitch prediction (adaptive codebook)
-    for (int i = 0; i < TETRA_CODEC_SAMPLES; i++) {
-        int pitch_idx = i - (int)codec->pitch_period;
-        if (pitch_idx >= 0) {
-            excitation[i] += codec->pitch_gain * excitation[pitch_idx];
-        } else if (pitch_idx >= -TETRA_CODEC_SAMPLES) {
-            excitation[i] += codec->pitch_gain * codec->excitation[TETRA_CODEC_SAMPLES + pitch_idx];
-        }
+    generate_excitation(codec, params->codebook, fixed_gain, excitation);
+
+    // Add pitch prediction (adaptive codebook): the first pitch_lag samples
+    // look back into the previous frame's excitation (lag < frame length)
+    int pitch_lag = (int)codec->pitch_period;
+    for (int i = 0; i < pitch_lag; i++) {
+        excitation[i] += codec->pitch_gain * codec->excitation[TETRA_CODEC_SAMPLES - pitch_lag + i];
+    }
+    for (int i = pitch_lag; i < TETRA_CODEC_SAMPLES; i++) {
+        excitation[i] += codec->pitch_gain * excitation[i - pitch_lag];
     }
 
     // Save excitation for next frame
     memcpy(codec->excitation, excitation, TETRA_CODEC_SAMPLES * sizeof(float));
 
     // LPC synthesis filtering
-    float decoded_samples[TETRA_CODEC_SAMPLES];
-    lpc_synthesis(codec->lpc_coeffs, excitation, decoded_samples, TETRA_CODEC_SAMPLES);
+    lpc_synthesis(codec, excitation, decoded_samples, TETRA_CODEC_SAMPLES);
 
     // Post-processing
-    post_process(decoded_samples, TETRA_CODEC_SAMPLES);
+    post_process(codec, decoded_samples, TETRA_CODEC_SAMPLES);
 
-    // Convert to int16 samples
-    for (int i = 0; i < TETRA_CODEC_SAMPLES; i++) {
-        // Scale to int16 range with soft clipping
-        float sample = decoded_samples[i] * 16384.0f;  // Leave headroom
-
-        if (sample > 32767.0f) sample = 32767.0f;
-        if (sample < -32768.0f) sample = -32768.0f;
+    codec->frame_count++;
+}
 
-        audio_samples[i] = (int16_t)sample;
+int tetra_codec_decode_frame(tetra_codec_t *codec, const uint8_t *encoded_bits,
+                             int16_t *audio_samples) {
+    if (!codec || !encoded_bits || !audio_samples) {
+        return -1;
     }
 
-    codec->frame_count++;
+    codec_params_t params;
+    unpack_params(encoded_bits, &params);
+
+    float decoded_samples[TETRA_CODEC_SAMPLES];
+    decode_params(codec, &params, decoded_samples);
+
+    // Convert to int16 samples with saturation
+    convert_float_to_int16(decoded_samples, audio_samples, TETRA_CODEC_SAMPLES, CODEC_OUTPUT_SCALE);
 
     return TETRA_CODEC_SAMPLES;
 }
 
+// Decode count frames; frame i (TETRA_CODEC_FRAME_BYTES apart in frames) is
+// decoded by codecs[i] into audio_samples + i * TETRA_CODEC_SAMPLES.
+// Frames of one stream repeat the same codec and are decoded in order.
+int tetra_codec_decode_frames(tetra_codec_t *const *codecs, const uint8_t *frames,
+                              int16_t *audio_samples, int count) {
+    if (!codecs || !frames || !audio_samples || count < 0) {
+        return -1;
+    }
+
+    float decoded[CODEC_BATCH_FRAMES * TETRA_CODEC_SAMPLES];
+
+    for (int base = 0; base < count; base += CODEC_BATCH_FRAMES) {
+        int n = count - base < CODEC_BATCH_FRAMES ? count - base : CODEC_BATCH_FRAMES;
+
+        for (int i = 0; i < n; i++) {
+            tetra_codec_t *codec = codecs[base + i];
+            if (!codec) {
+                return -1;
+            }
+
+            codec_params_t params;
+            unpack_params(frames + (size_t)(base + i) * TETRA_CODEC_FRAME_BYTES, &params);
+            decode_params(codec, &params, &decoded[i * TETRA_CODEC_SAMPLES]);
+        }
+
+        convert_float_to_int16(decoded, audio_samples + (size_t)base * TETRA_CODEC_SAMPLES,
+                               (uint32_t)n * TETRA_CODEC_SAMPLES, CODEC_OUTPUT_SCALE);
+    }
+
+    return count * TETRA_CODEC_SAMPLES;
+}
+
+// Clear filter memories, e.g. at the start of a new call
+void tetra_codec_reset(tetra_codec_t *codec) {
+    if (!codec) return;
+
+    memset(codec->synth_mem, 0, sizeof(codec->synth_mem));
+    memset(codec->excitation, 0, sizeof(codec->excitation));
+    codec->deemph_mem = 0.0f;
+}
+
 void tetra_codec_cleanup(tetra_codec_t *codec) {
     if (codec) {
-        log_message(true, "TETRA codec decoded %d frames\n", codec->frame_count);
-        free(codec);
+        // Mixer streams that never carried a call have nothing to report
+        if (codec->frame_count > 0) {
+            log_message(true, "TETRA codec decoded %d frames\n", codec->frame_count);
+        }
+        rt_free(codec);
     }
 }
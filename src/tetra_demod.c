@@ -9,63 +9,117 @@
 #include <string.h>
 #include <math.h>
 
+// Bit spacing of the symbol slicer: ~133 samples/symbol at 2.4 Msps
+#define DEMOD_SAMPLES_PER_SYMBOL (int)(2400000.0f / 18000.0f)
+
 // TETRA training sequence for burst detection
-static const uint8_t TETRA_TRAINING_SEQ[22] = {
+const uint8_t TETRA_TRAINING_SEQ[TETRA_TRAINING_SEQ_BITS] = {
     1, 1, 0, 0, 1, 0, 1, 0, 0, 1, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1, 0
 };
 
 tetra_demod_t* tetra_demod_init(uint32_t sample_rate, detection_params_t *params, detection_status_t *status, float squelch_threshold) {
     (void)sample_rate; // Reserved for future use
 
-    tetra_demod_t *demod = calloc(1, sizeof(tetra_demod_t));
+    // One allocation, scratch included, resident and aligned from the arena
+    tetra_demod_t *demod = rt_alloc(RT_POOL_DEMOD, sizeof(tetra_demod_t));
     if (!demod) {
         fprintf(stderr, "Failed to allocate demodulator structure\n");
         return NULL;
     }
 
-    demod->sample_count = SDR_BUFFER_SIZE / 2; // I/Q pairs
+    demod->path = dsp_get_path();
     demod->squelch_threshold = squelch_threshold;
-
-    // Allocate sample buffers (optimized for low memory)
-    demod->i_samples = calloc(demod->sample_count, sizeof(float));
-    demod->q_samples = calloc(demod->sample_count, sizeof(float));
-    demod->demod_bits = calloc(TETRA_BURST_LENGTH, sizeof(uint8_t));
-
-    if (!demod->i_samples || !demod->q_samples || !demod->demod_bits) {
-        fprintf(stderr, "Failed to allocate demodulator buffers\n");
-        tetra_demod_cleanup(demod);
-        return NULL;
-    }
-
     demod->bit_count = 0;
+    demod->sync_offset = -1;
     demod->symbol_timing = 0.0f;
     demod->params = params;
     demod->status = status;
 
-    log_message(true, "TETRA demodulator: squelch = %.1f (adjust with -q if needed)\n", squelch_threshold);
+    log_message(true, "TETRA demodulator: squelch = %.1f (adjust with -q if needed), %s DSP\n",
+                squelch_threshold, dsp_path_name(demod->path));
 
     return demod;
 }
 
+// Discriminator, filter and slicer over the first `needed` samples
+static int demod_blocks_f32(tetra_demod_t *demod, const uint8_t *iq_data, uint32_t needed, float lpf_cutoff) {
+    cf32_t *samples = demod->scratch.f32.samples;
+    float *demod_output = demod->scratch.f32.output;
+    int bit_index = 0;
+
+    for (uint32_t start = 0; start < needed; start += TETRA_DEMOD_BLOCK) {
+        uint32_t n = needed - start < TETRA_DEMOD_BLOCK ? needed - start : TETRA_DEMOD_BLOCK;
+        convert_cu8_to_cf32(iq_data + (size_t)start * 2, samples + 1, n);
+
+        if (start == 0) {
+            quadrature_demod_cf32(samples + 1, demod_output + 1, n);
+            low_pass_filter(demod_output + 1, n, lpf_cutoff);
+        } else {
+            float carried = demod_output[0];
+            quadrature_demod_cf32(samples, demod_output, n + 1);
+            demod_output[0] = carried;
+            low_pass_filter(demod_output, n + 1, lpf_cutoff);
+        }
+
+        // Symbol timing recovery and bit extraction (simplified)
+        // Real implementation would use Gardner or Mueller-Müller timing recovery
+        uint32_t first = (start + DEMOD_SAMPLES_PER_SYMBOL - 1) / DEMOD_SAMPLES_PER_SYMBOL * DEMOD_SAMPLES_PER_SYMBOL;
+        for (uint32_t i = first; i < start + n && bit_index < TETRA_BURST_LENGTH; i += DEMOD_SAMPLES_PER_SYMBOL) {
+            // Simple threshold detection
+            demod->demod_bits[bit_index++] = (demod_output[i - start + 1] > 0.0f) ? 1 : 0;
+        }
+
+        samples[0] = samples[n];
+        demod_output[0] = demod_output[n];
+    }
+    return bit_index;
+}
+
+// The same in Q15: phase steps with 32768 = pi, filtered in Q15
+static int demod_blocks_q15(tetra_demod_t *demod, const uint8_t *iq_data, uint32_t needed, float lpf_cutoff) {
+    ci16_t *samples = demod->scratch.q15.samples;
+    int16_t *demod_output = demod->scratch.q15.output;
+    int32_t alpha = (int32_t)(lpf_cutoff * 32768.0f + 0.5f);
+    int bit_index = 0;
+
+    if (alpha < 0) alpha = 0;
+    if (alpha > 32768) alpha = 32768;
+
+    for (uint32_t start = 0; start < needed; start += TETRA_DEMOD_BLOCK) {
+        uint32_t n = needed - start < TETRA_DEMOD_BLOCK ? needed - start : TETRA_DEMOD_BLOCK;
+        convert_cu8_to_ci16(iq_data + (size_t)start * 2, samples + 1, n);
+
+        if (start == 0) {
+            quadrature_demod_ci16(samples + 1, demod_output + 1, n);
+            low_pass_filter_q15(demod_output + 1, n, alpha);
+        } else {
+            int16_t carried = demod_output[0];
+            quadrature_demod_ci16(samples, demod_output, n + 1);
+            demod_output[0] = carried;
+            low_pass_filter_q15(demod_output, n + 1, alpha);
+        }
+
+        uint32_t first = (start + DEMOD_SAMPLES_PER_SYMBOL - 1) / DEMOD_SAMPLES_PER_SYMBOL * DEMOD_SAMPLES_PER_SYMBOL;
+        for (uint32_t i = first; i < start + n && bit_index < TETRA_BURST_LENGTH; i += DEMOD_SAMPLES_PER_SYMBOL) {
+            demod->demod_bits[bit_index++] = demod_output[i - start + 1] > 0 ? 1 : 0;
+        }
+
+        samples[0] = samples[n];
+        demod_output[0] = demod_output[n];
+    }
+    return bit_index;
+}
+
 int tetra_demod_process(tetra_demod_t *demod, uint8_t *iq_data, uint32_t len) {
     if (!demod || !iq_data || len < 2) {
         return -1;
     }
 
-    // Convert uint8 I/Q samples to float and separate I/Q
     uint32_t sample_pairs = len / 2;
-    if (sample_pairs > (uint32_t)demod->sample_count) {
-        sample_pairs = demod->sample_count;
-    }
 
-    // Convert and separate I/Q in one pass to avoid buffer issues
-    for (uint32_t i = 0; i < sample_pairs; i++) {
-        demod->i_samples[i] = (float)iq_data[i * 2] - 127.5f;
-        demod->q_samples[i] = (float)iq_data[i * 2 + 1] - 127.5f;
-    }
-
-    // STEP 1: Check signal strength (squelch)
-    float signal_power = detect_signal_strength(demod->i_samples, demod->q_samples, sample_pairs);
+    // STEP 1: Check signal strength (squelch), straight from the bytes
+    float signal_power = detect_signal_strength_cu8(iq_data, sample_pairs);
+    demod->signal_power = signal_power;
 
     // Require minimum signal strength (user-adjustable threshold)
     // Typical TETRA signal: 20-50, noise: <10
@@ -74,39 +128,36 @@ int tetra_demod_process(tetra_demod_t *demod, uint8_t *iq_data, uint32_t len) {
         return 0;  // Too weak, probably just noise
     }
 
-    // Perform quadrature demodulation
-    float *demod_output = malloc(sample_pairs * sizeof(float));
-    if (!demod_output) return -1;
-
-    quadrature_demod(demod->i_samples, demod->q_samples, demod_output, sample_pairs);
-
-    // Apply low-pass filter (using dynamic parameter from GUI)
+    // Low-pass filter cutoff (dynamic parameter from GUI)
     float lpf_cutoff = 0.5f; // Default value
     if (demod->params) {
         pthread_mutex_lock(&demod->params->lock);
         lpf_cutoff = demod->params->lpf_cutoff;
         pthread_mutex_unlock(&demod->params->lock);
     }
-    low_pass_filter(demod_output, sample_pairs, lpf_cutoff);
 
-    // Symbol timing recovery and bit extraction (simplified)
-    // Real implementation would use Gardner or Mueller-Müller timing recovery
-    float samples_per_symbol = 2400000.0f / 18000.0f; // ~133 samples/symbol
-    int bit_index = 0;
+    // Only samples up to the last symbol of a burst reach the slicer
+    uint32_t needed = (TETRA_BURST_LENGTH - 1) * DEMOD_SAMPLES_PER_SYMBOL + 1;
+    if (needed > sample_pairs) needed = sample_pairs;
 
-    for (uint32_t i = 0; i < sample_pairs && bit_index < TETRA_BURST_LENGTH; i += (int)samples_per_symbol) {
-        // Simple threshold detection
-        demod->demod_bits[bit_index++] = (demod_output[i] > 0.0f) ? 1 : 0;
-    }
+    // Quadrature demodulation and filtering a block at a time. From the second
+    // block on, slot 0 holds the previous block's last sample (and its filtered
+    // output), so the discriminator and filter continue exactly where they left off
+    int bit_index = demod->path == DSP_PATH_Q15 ? demod_blocks_q15(demod, iq_data, needed, lpf_cutoff)
+                                                : demod_blocks_f32(demod, iq_data, needed, lpf_cutoff);
 
     demod->bit_count = bit_index;
 
-    free(demod_output);
     return bit_index;
 }
 
 bool tetra_detect_burst(tetra_demod_t *demod) {
-    if (!demod || demod->bit_count < 22) {
+    if (!demod) {
+        return false;
+    }
+
+    demod->sync_offset = -1;
+    if (demod->bit_count < 22) {
         return false;
     }
 
@@ -130,9 +181,8 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
     }
 
     // Step 1: Check signal power to reject pure noise
-    // Calculate RMS power from I/Q samples
-    float signal_power = detect_signal_strength(demod->i_samples, demod->q_samples,
-                                                 demod->sample_count);
+    // RMS power of the block, measured by tetra_demod_process()
+    float signal_power = demod->signal_power;
 
     // Update status with current signal power
     if (demod->status) {
@@ -142,7 +192,7 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
     }
 
     if (signal_power < min_signal_power) {
-        log_message(true, "Signal power too low: %.2f < %.2f (rejecting noise)\n",
+        LOG_AT(LOG_LEVEL_DEBUG, 10, "Signal power too low: %.2f < %.2f (rejecting noise)\n",
                    signal_power, min_signal_power);
         return false;
     }
@@ -152,22 +202,16 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
     int best_offset = -1;
     float best_correlation = 0.0f;
 
+    // Bit matches at every offset in one pass of the training sequence correlator
+    uint8_t match_counts[TETRA_BURST_LENGTH];
+    correlate_bits(demod->demod_bits, (uint32_t)demod->bit_count, TETRA_TRAINING_SEQ,
+                   TETRA_TRAINING_SEQ_BITS, match_counts);
+
     for (int offset = 0; offset < demod->bit_count - 22; offset++) {
-        int matches = 0;
-        float correlation = 0.0f;
-
-        // Count bit matches and calculate correlation
-        for (int i = 0; i < 22; i++) {
-            if (demod->demod_bits[offset + i] == TETRA_TRAINING_SEQ[i]) {
-                matches++;
-                correlation += 1.0f;
-            } else {
-                correlation -= 1.0f;
-            }
-        }
+        int matches = match_counts[offset];
 
-        // Normalize correlation to [-1.0, 1.0]
-        correlation /= 22.0f;
+        // +1 per match, -1 per mismatch, normalized to [-1.0, 1.0]
+        float correlation = (float)(2 * matches - 22) / 22.0f;
 
         if (matches > best_match) {
             best_match = matches;
@@ -177,7 +221,7 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
 
         // Strong match threshold (configurable via GUI)
         if (matches >= strong_match_threshold && correlation >= strong_correlation) {
-            log_message(true, "TETRA burst detected at offset %d (%d/22 matches, corr=%.3f, power=%.2f)\n",
+            LOG_AT(LOG_LEVEL_DEBUG, 100, "TETRA burst detected at offset %d (%d/22 matches, corr=%.3f, power=%.2f)\n",
                        offset, matches, correlation, signal_power);
 
             // Update detection status
@@ -187,11 +231,13 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
                 demod->status->last_match_count = matches;
                 demod->status->last_correlation = correlation;
                 demod->status->last_offset = offset;
-                demod->status->last_detection_time = get_timestamp_us();
+                demod->status->last_detection_time = get_timestamp_coarse_us();
                 demod->status->detection_count++;
                 pthread_mutex_unlock(&demod->status->lock);
             }
 
+            demod->sync_offset = offset;
+            demod->sync_correlation = correlation;
             return true;
         }
     }
@@ -200,7 +246,7 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
     if (best_match >= moderate_match_threshold &&
         best_correlation >= moderate_correlation &&
         signal_power >= min_signal_power * moderate_power_multiplier) {
-        log_message(true, "TETRA burst detected (moderate) at offset %d (%d/22 matches, corr=%.3f, power=%.2f)\n",
+        LOG_AT(LOG_LEVEL_DEBUG, 100, "TETRA burst detected (moderate) at offset %d (%d/22 matches, corr=%.3f, power=%.2f)\n",
                    best_offset, best_match, best_correlation, signal_power);
 
         // Update detection status
@@ -210,11 +256,13 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
             demod->status->last_match_count = best_match;
             demod->status->last_correlation = best_correlation;
             demod->status->last_offset = best_offset;
-            demod->status->last_detection_time = get_timestamp_us();
+            demod->status->last_detection_time = get_timestamp_coarse_us();
             demod->status->detection_count++;
             pthread_mutex_unlock(&demod->status->lock);
         }
 
+        demod->sync_offset = best_offset;
+        demod->sync_correlation = best_correlation;
         return true;
     }
 
@@ -230,19 +278,22 @@ bool tetra_detect_burst(tetra_demod_t *demod) {
 
     // Log rejection for debugging
     if (best_match >= 15) {
-        log_message(true, "Rejected: insufficient quality (matches=%d/22, corr=%.3f, power=%.2f)\n",
+        LOG_AT(LOG_LEVEL_DEBUG, 20, "Rejected: insufficient quality (matches=%d/22, corr=%.3f, power=%.2f)\n",
                    best_match, best_correlation, signal_power);
     }
 
     return false;
 }
 
+// Sample index of the detected training sequence within the last buffer
+int tetra_demod_sync_sample(const tetra_demod_t *demod) {
+    if (!demod || demod->sync_offset < 0) return 0;
+    return demod->sync_offset * DEMOD_SAMPLES_PER_SYMBOL;
+}
+
 void tetra_demod_cleanup(tetra_demod_t *demod) {
     if (demod) {
-        free(demod->i_samples);
-        free(demod->q_samples);
-        free(demod->demod_bits);
-        free(demod);
+        rt_free(demod);
     }
 }
 
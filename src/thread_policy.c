@@ -0,0 +1,286 @@
+/*
+ * Thread Policy
+ * Names, CPU affinity and real-time scheduling for every pipeline thread
+ *
+ * Each thread calls thread_policy_apply() with its role as it starts and
+ * thread_policy_leave() before it returns. The policy - set once by main()
+ * from the command line - may pin a role to a CPU list and give it a
+ * SCHED_FIFO priority. Capture and audio have hard deadlines (the dongle's
+ * USB buffers and the sound card's period); rendering, logging and disk
+ * writes do not, so on a small board capture and audio go on cores of their
+ * own, ideally ones booted with isolcpus= so nothing else is scheduled there.
+ *
+ * Without CAP_SYS_NICE (or an rtprio limit) SCHED_FIFO is refused; the
+ * thread keeps normal scheduling and the refusal is logged once per role.
+ * Every thread is registered so its CPU time and context switches can be
+ * reported at shutdown.
+ */
+
+#define _GNU_SOURCE
+#include "tetra_analyzer.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define THREAD_MAX_REGISTERED 64
+
+typedef struct {
+    thread_role_t role;
+    int index;
+    int tid;
+    char name[16];                     // Thread name (15 chars + NUL)
+    clockid_t cpu_clock;
+    bool live;                         // Cleared by thread_policy_leave()
+    bool realtime;                     // Running SCHED_FIFO
+    uint64_t cpu_ns;                   // Final CPU time once left
+    long involuntary;                  // Preemptions, once left
+    long voluntary;                    // Blocking waits, once left
+} thread_entry_t;
+
+static const char *ROLE_NAMES[THREAD_ROLE_COUNT] = {
+    "capture", "control", "audio", "gui", "log", "recorder", "batch"
+};
+
+static thread_policy_t g_policy;
+static thread_entry_t g_threads[THREAD_MAX_REGISTERED];
+static int g_thread_count;
+static pthread_mutex_t g_thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic bool g_rt_refused[THREAD_ROLE_COUNT];
+static _Thread_local int t_entry = -1;
+
+void thread_policy_init(thread_policy_t *policy) {
+    if (!policy) return;
+    memset(policy, 0, sizeof(*policy));
+}
+
+static int role_from_name(const char *name, size_t len) {
+    for (int r = 0; r < THREAD_ROLE_COUNT; r++) {
+        if (strlen(ROLE_NAMES[r]) == len && strncmp(name, ROLE_NAMES[r], len) == 0) return r;
+    }
+    return -1;
+}
+
+// "2", "0-1,3": CPU list as in /sys and taskset -c
+static int parse_cpu_list(const char *s, uint64_t *mask) {
+    *mask = 0;
+    while (*s) {
+        char *end;
+        long first = strtol(s, &end, 10);
+        long last = first;
+        if (end == s) return -1;
+        if (*end == '-') {
+            s = end + 1;
+            last = strtol(s, &end, 10);
+            if (end == s) return -1;
+        }
+        if (first < 0 || last < first || last >= THREAD_MAX_CPUS) return -1;
+        for (long c = first; c <= last; c++) *mask |= 1ULL << c;
+        s = end;
+        if (*s == ',') s++;
+        else if (*s) return -1;
+    }
+    return *mask ? 0 : -1;
+}
+
+int thread_policy_parse_cpus(thread_policy_t *policy, const char *spec) {
+    const char *eq = spec ? strchr(spec, '=') : NULL;
+    if (!policy || !eq) return -1;
+
+    int role = role_from_name(spec, (size_t)(eq - spec));
+    uint64_t mask;
+    if (role < 0 || parse_cpu_list(eq + 1, &mask) < 0) return -1;
+
+    policy->cpus[role] = mask;
+    return 0;
+}
+
+int thread_policy_parse_priority(thread_policy_t *policy, const char *spec) {
+    const char *eq = spec ? strchr(spec, '=') : NULL;
+    if (!policy || !eq) return -1;
+
+    int role = role_from_name(spec, (size_t)(eq - spec));
+    char *end;
+    long prio = strtol(eq + 1, &end, 10);
+    if (role < 0 || *end || prio < 0 || prio > 99) return -1;
+
+    policy->priority[role] = (int)prio;
+    return 0;
+}
+
+void thread_policy_set_realtime(thread_policy_t *policy) {
+    if (!policy) return;
+
+    // Audio has the shorter deadline (one 20 ms period); explicit priorities win
+    if (!policy->priority[THREAD_ROLE_AUDIO]) policy->priority[THREAD_ROLE_AUDIO] = 70;
+    if (!policy->priority[THREAD_ROLE_CAPTURE]) policy->priority[THREAD_ROLE_CAPTURE] = 60;
+}
+
+static void format_cpu_list(uint64_t mask, char *buf, size_t size) {
+    size_t n = 0;
+    buf[0] = '\0';
+    for (int c = 0; c < THREAD_MAX_CPUS && n < size; c++) {
+        if (!(mask >> c & 1)) continue;
+        int last = c;
+        while (last + 1 < THREAD_MAX_CPUS && (mask >> (last + 1) & 1)) last++;
+        int w = last > c ? snprintf(buf + n, size - n, "%s%d-%d", n ? "," : "", c, last)
+                         : snprintf(buf + n, size - n, "%s%d", n ? "," : "", c);
+        if (w < 0) break;
+        n += (size_t)w;
+        c = last;
+    }
+}
+
+void thread_policy_set(const thread_policy_t *policy) {
+    if (policy) g_policy = *policy;
+
+    for (int r = 0; r < THREAD_ROLE_COUNT; r++) {
+        if (!g_policy.cpus[r] && !g_policy.priority[r]) continue;
+        char cpus[64] = "any";
+        if (g_policy.cpus[r]) format_cpu_list(g_policy.cpus[r], cpus, sizeof(cpus));
+        if (g_policy.priority[r]) {
+            log_message(true, "Thread policy: %-8s CPUs %s, SCHED_FIFO %d\n", ROLE_NAMES[r], cpus,
+                        g_policy.priority[r]);
+        } else {
+            log_message(true, "Thread policy: %-8s CPUs %s\n", ROLE_NAMES[r], cpus);
+        }
+    }
+
+    // Cores kept free of other tasks by isolcpus= are where capture and audio belong
+    FILE *f = fopen("/sys/devices/system/cpu/isolated", "r");
+    if (f) {
+        char isolated[64];
+        if (fgets(isolated, sizeof(isolated), f) && isolated[0] != '\n') {
+            isolated[strcspn(isolated, "\n")] = '\0';
+            if (!g_policy.cpus[THREAD_ROLE_CAPTURE] || !g_policy.cpus[THREAD_ROLE_AUDIO]) {
+                log_message(true, "Isolated CPUs %s are available: pin with --cpus capture=N "
+                            "--cpus audio=N\n", isolated);
+            }
+        }
+        fclose(f);
+    }
+}
+
+// Nth CPU of a mask, wrapping; workers of one role spread over its CPUs
+static int nth_cpu(uint64_t mask, int n) {
+    int count = __builtin_popcountll(mask);
+    n %= count;
+    for (int c = 0; c < THREAD_MAX_CPUS; c++) {
+        if ((mask >> c & 1) && n-- == 0) return c;
+    }
+    return -1;
+}
+
+void thread_policy_apply(thread_role_t role, int index) {
+    if (role >= THREAD_ROLE_COUNT) return;
+
+    char name[32];
+    if (index >= 0) {
+        snprintf(name, sizeof(name), "tetra-%s%d", ROLE_NAMES[role], index);
+    } else {
+        snprintf(name, sizeof(name), "tetra-%s", ROLE_NAMES[role]);
+    }
+    name[15] = '\0';   // Kernel limit for thread names
+    // The main thread's name is the process name in ps and top: leave it
+    if (syscall(SYS_gettid) != getpid()) {
+        pthread_setname_np(pthread_self(), name);
+    }
+
+    uint64_t mask = g_policy.cpus[role];
+    if (mask) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (index >= 0) {
+            CPU_SET(nth_cpu(mask, index), &set);
+        } else {
+            for (int c = 0; c < THREAD_MAX_CPUS; c++) {
+                if (mask >> c & 1) CPU_SET(c, &set);
+            }
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err) {
+            log_message(true, "⚠ Cannot pin %s to its CPUs: %s\n", name, strerror(err));
+        }
+    }
+
+    bool realtime = false;
+    if (g_policy.priority[role]) {
+        struct sched_param param = { .sched_priority = g_policy.priority[role] };
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err == 0) {
+            realtime = true;
+        } else if (!atomic_exchange(&g_rt_refused[role], true)) {
+            log_message(true, "⚠ SCHED_FIFO refused for %s (%s): needs CAP_SYS_NICE or an "
+                        "rtprio limit - using normal scheduling\n", ROLE_NAMES[role], strerror(err));
+        }
+    }
+
+    pthread_mutex_lock(&g_thread_lock);
+    if (t_entry < 0 && g_thread_count < THREAD_MAX_REGISTERED) {
+        t_entry = g_thread_count++;
+    }
+    if (t_entry >= 0) {
+        thread_entry_t *e = &g_threads[t_entry];
+        memset(e, 0, sizeof(*e));
+        e->role = role;
+        e->index = index;
+        e->tid = (int)syscall(SYS_gettid);
+        memcpy(e->name, name, sizeof(e->name));
+        e->live = pthread_getcpuclockid(pthread_self(), &e->cpu_clock) == 0;
+        e->realtime = realtime;
+    }
+    pthread_mutex_unlock(&g_thread_lock);
+}
+
+void thread_policy_leave(void) {
+    if (t_entry < 0) return;
+
+    struct timespec ts;
+    struct rusage ru;
+    bool have_cpu = clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0;
+    bool have_ru = getrusage(RUSAGE_THREAD, &ru) == 0;
+
+    pthread_mutex_lock(&g_thread_lock);
+    thread_entry_t *e = &g_threads[t_entry];
+    if (have_cpu) e->cpu_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    if (have_ru) {
+        e->involuntary = ru.ru_nivcsw;
+        e->voluntary = ru.ru_nvcsw;
+    }
+    e->live = false;
+    pthread_mutex_unlock(&g_thread_lock);
+
+    // A thread that applies a role again later gets a fresh entry
+    t_entry = -1;
+}
+
+void thread_policy_report(void) {
+    pthread_mutex_lock(&g_thread_lock);
+    if (g_thread_count == 0) {
+        pthread_mutex_unlock(&g_thread_lock);
+        return;
+    }
+
+    log_message(true, "\nThreads            tid   CPU ms  sched   preempted  waits\n");
+    for (int i = 0; i < g_thread_count; i++) {
+        thread_entry_t *e = &g_threads[i];
+        struct timespec ts;
+        if (e->live && clock_gettime(e->cpu_clock, &ts) == 0) {
+            // Still running: CPU time only, switch counts are per calling thread
+            e->cpu_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+            log_message(true, "  %-15s %6d %8.1f  %-6s %10s %6s\n", e->name, e->tid,
+                        (double)e->cpu_ns / 1e6, e->realtime ? "fifo" : "other", "-", "-");
+        } else {
+            log_message(true, "  %-15s %6d %8.1f  %-6s %10ld %6ld\n", e->name, e->tid,
+                        (double)e->cpu_ns / 1e6, e->realtime ? "fifo" : "other",
+                        e->involuntary, e->voluntary);
+        }
+    }
+    pthread_mutex_unlock(&g_thread_lock);
+}
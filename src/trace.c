@@ -0,0 +1,432 @@
+/*
+ * Pipeline Tracing
+ * Scoped timeline events on per-thread rings, exported to Chrome trace JSON
+ * or Perfetto protobuf
+ *
+ * A trace point is a TRACE_BEGIN()/TRACE_END() pair around a pipeline stage.
+ * The end records one complete event - static call site, start, duration and
+ * up to three numeric arguments - into the calling thread's ring. Rings are
+ * flight recorders: they keep the newest TRACE_RING_EVENTS events and
+ * overwrite the oldest, so tracing can stay on indefinitely and be dumped
+ * when a spike shows up. Recording takes two cycle counter reads and a
+ * 48-byte store, no locks and no syscalls; ticks are converted to
+ * CLOCK_MONOTONIC nanoseconds only when the trace is written, from clock
+ * pairs taken when tracing starts and at the dump. On targets without an
+ * invariant counter the clock is read directly.
+ *
+ * The two counter reads are most of an event's cost. tetra_bench measures
+ * about 64 ns an event in an x86 VM where one TSC read takes 23 ns; only
+ * where the counter is cheap to read does an event fit in 50 ns. The
+ * coarse clock is cheaper still, but its 4 ms tick is longer than the
+ * stages being timed.
+ *
+ * Build with -DTETRA_TRACE=OFF to compile trace points out entirely; with
+ * them compiled in, trace_set_enabled() toggles recording at run time.
+ */
+
+#include "tetra_analyzer.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_TRACE
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define TRACE_CACHE_LINE 64
+#define TRACE_RING_EVENTS 4096         // Per thread, power of two
+#define TRACE_MAX_RINGS 64
+#define TRACE_PACKET_MAX 512           // One encoded Perfetto packet
+
+typedef struct {
+    const trace_site_t *site;
+    uint64_t start;                    // Ticks
+    uint64_t duration;
+    double args[TRACE_MAX_ARGS];
+} trace_record_t;
+
+typedef struct {
+    _Alignas(TRACE_CACHE_LINE)
+    _Atomic uint64_t head;             // Events ever written (owner thread only)
+    int tid;
+    trace_record_t events[TRACE_RING_EVENTS];
+} trace_ring_t;
+
+static _Atomic bool g_trace_enabled;
+static pthread_once_t g_trace_once = PTHREAD_ONCE_INIT;
+static uint64_t g_origin_ticks;        // Calibration pair taken when tracing is first enabled
+static uint64_t g_origin_ns;
+static trace_ring_t *g_rings[TRACE_MAX_RINGS];
+static _Atomic int g_ring_count;
+static _Thread_local trace_ring_t *t_ring;
+static _Thread_local bool t_ring_failed;
+
+static uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t trace_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return trace_now_ns();
+#endif
+}
+
+static void trace_calibrate_origin(void) {
+    g_origin_ns = trace_now_ns();
+    g_origin_ticks = trace_ticks();
+}
+
+// First event on a thread: allocate and register its ring
+static trace_ring_t* trace_ring_get(void) {
+    if (t_ring || t_ring_failed) return t_ring;
+
+    int slot = atomic_fetch_add_explicit(&g_ring_count, 1, memory_order_relaxed);
+    if (slot >= TRACE_MAX_RINGS) {
+        atomic_fetch_sub_explicit(&g_ring_count, 1, memory_order_relaxed);
+        t_ring_failed = true;
+        return NULL;
+    }
+
+    trace_ring_t *ring = aligned_alloc(TRACE_CACHE_LINE, sizeof(trace_ring_t));
+    if (!ring) {
+        t_ring_failed = true;
+        return NULL;
+    }
+    memset(ring, 0, sizeof(trace_ring_t));
+    rt_memory_account(RT_POOL_TRACE, (long)sizeof(trace_ring_t));
+    ring->tid = (int)syscall(SYS_gettid);
+
+    // Rings live until exit: a dump may run after the thread is gone
+    __atomic_store_n(&g_rings[slot], ring, __ATOMIC_RELEASE);
+    t_ring = ring;
+    return ring;
+}
+
+void trace_set_enabled(bool enabled) {
+    if (enabled) pthread_once(&g_trace_once, trace_calibrate_origin);
+    atomic_store_explicit(&g_trace_enabled, enabled, memory_order_relaxed);
+}
+
+bool trace_is_enabled(void) {
+    return atomic_load_explicit(&g_trace_enabled, memory_order_relaxed);
+}
+
+uint64_t trace_begin(void) {
+    if (!atomic_load_explicit(&g_trace_enabled, memory_order_relaxed)) return 0;
+    return trace_ticks();
+}
+
+void trace_end(const trace_site_t *site, uint64_t start, double a0, double a1, double a2) {
+    if (!start) return;
+
+    trace_ring_t *ring = trace_ring_get();
+    if (!ring) return;
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    trace_record_t *r = &ring->events[head & (TRACE_RING_EVENTS - 1)];
+    r->site = site;
+    r->start = start;
+    r->duration = trace_ticks() - start;
+    r->args[0] = a0;
+    r->args[1] = a1;
+    r->args[2] = a2;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Copy a ring's newest events. Events the owner overwrote while we were
+// copying are dropped by re-reading the head afterwards: at head `after` it
+// may be midway through record `after`, which reuses the slot of record
+// `after - TRACE_RING_EVENTS`, so only records from one past that are whole.
+static size_t snapshot_ring(trace_ring_t *ring, trace_record_t *out) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint64_t first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+
+    for (uint64_t i = first; i < head; i++) {
+        out[i - first] = ring->events[i & (TRACE_RING_EVENTS - 1)];
+    }
+
+    uint64_t after = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint64_t valid = after + 1 > TRACE_RING_EVENTS ? after + 1 - TRACE_RING_EVENTS : 0;
+    if (valid <= first) return (size_t)(head - first);
+    if (valid >= head) return 0;
+
+    size_t skip = (size_t)(valid - first);
+    memmove(out, out + skip, (size_t)(head - valid) * sizeof(trace_record_t));
+    return (size_t)(head - valid);
+}
+
+// Ticks to CLOCK_MONOTONIC nanoseconds, in place
+static void ticks_to_ns(trace_record_t *ev, size_t count, double ns_per_tick) {
+    for (size_t i = 0; i < count; i++) {
+        ev[i].start = g_origin_ns + (uint64_t)((double)(ev[i].start - g_origin_ticks) * ns_per_tick);
+        ev[i].duration = (uint64_t)((double)ev[i].duration * ns_per_tick);
+    }
+}
+
+// Chrome trace event format: complete ("X") events in microseconds
+static void write_json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static void write_json(FILE *f, int pid, trace_ring_t *ring, const trace_record_t *ev, size_t count,
+                       bool *first) {
+    for (size_t i = 0; i < count; i++) {
+        const trace_site_t *site = ev[i].site;
+        fputs(*first ? "\n{\"name\":" : ",\n{\"name\":", f);
+        *first = false;
+        write_json_string(f, site->name);
+        fputs(",\"cat\":", f);
+        write_json_string(f, site->category);
+        fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{",
+                (double)ev[i].start / 1000.0, (double)ev[i].duration / 1000.0, pid, ring->tid);
+        bool first_arg = true;
+        for (int a = 0; a < TRACE_MAX_ARGS; a++) {
+            if (!site->args[a]) continue;
+            fputs(first_arg ? "" : ",", f);
+            write_json_string(f, site->args[a]);
+            fprintf(f, ":%.9g", ev[i].args[a]);
+            first_arg = false;
+        }
+        fputs("}}", f);
+    }
+}
+
+// Minimal protobuf writer for the few Perfetto messages we emit
+typedef struct {
+    uint8_t data[TRACE_PACKET_MAX];
+    size_t len;
+} pb_buf_t;
+
+static void pb_varint(pb_buf_t *b, uint64_t v) {
+    while (v >= 0x80 && b->len < sizeof(b->data)) {
+        b->data[b->len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    if (b->len < sizeof(b->data)) b->data[b->len++] = (uint8_t)v;
+}
+
+static void pb_tag(pb_buf_t *b, int field, int wire_type) {
+    pb_varint(b, (uint64_t)field << 3 | (uint64_t)wire_type);
+}
+
+static void pb_uint(pb_buf_t *b, int field, uint64_t v) {
+    pb_tag(b, field, 0);
+    pb_varint(b, v);
+}
+
+static void pb_double(pb_buf_t *b, int field, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    pb_tag(b, field, 1);
+    for (int i = 0; i < 8 && b->len < sizeof(b->data); i++) {
+        b->data[b->len++] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+static void pb_bytes(pb_buf_t *b, int field, const void *data, size_t len) {
+    pb_tag(b, field, 2);
+    pb_varint(b, len);
+    if (b->len + len > sizeof(b->data)) len = sizeof(b->data) - b->len;
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static void pb_string(pb_buf_t *b, int field, const char *s) {
+    pb_bytes(b, field, s, strlen(s));
+}
+
+// Perfetto field numbers (protos/perfetto/trace)
+enum {
+    PF_TRACE_PACKET = 1,               // Trace.packet
+    PF_PACKET_TIMESTAMP = 8,           // TracePacket
+    PF_PACKET_SEQUENCE_ID = 10,
+    PF_PACKET_TRACK_EVENT = 11,
+    PF_PACKET_TRACK_DESCRIPTOR = 60,
+    PF_EVENT_DEBUG_ANNOTATIONS = 4,    // TrackEvent
+    PF_EVENT_TYPE = 9,
+    PF_EVENT_TRACK_UUID = 11,
+    PF_EVENT_CATEGORIES = 22,
+    PF_EVENT_NAME = 23,
+    PF_ANNOTATION_INT = 4,             // DebugAnnotation
+    PF_ANNOTATION_DOUBLE = 5,
+    PF_ANNOTATION_NAME = 10,
+    PF_TRACK_UUID = 1,                 // TrackDescriptor
+    PF_TRACK_THREAD = 4,
+    PF_THREAD_PID = 1,                 // ThreadDescriptor
+    PF_THREAD_TID = 2,
+    PF_SLICE_BEGIN = 1,                // TrackEvent.Type
+    PF_SLICE_END = 2
+};
+
+#define TRACE_SEQUENCE_ID 1
+
+static void write_packet(FILE *f, const pb_buf_t *packet) {
+    pb_buf_t head = { .len = 0 };
+    pb_tag(&head, PF_TRACE_PACKET, 2);
+    pb_varint(&head, packet->len);
+    fwrite(head.data, 1, head.len, f);
+    fwrite(packet->data, 1, packet->len, f);
+}
+
+static void write_perfetto(FILE *f, int pid, trace_ring_t *ring, const trace_record_t *ev,
+                           size_t count) {
+    uint64_t track = (uint64_t)ring->tid;
+
+    pb_buf_t thread = { .len = 0 };
+    pb_uint(&thread, PF_THREAD_PID, (uint64_t)pid);
+    pb_uint(&thread, PF_THREAD_TID, (uint64_t)ring->tid);
+
+    pb_buf_t desc = { .len = 0 };
+    pb_uint(&desc, PF_TRACK_UUID, track);
+    pb_bytes(&desc, PF_TRACK_THREAD, thread.data, thread.len);
+
+    pb_buf_t packet = { .len = 0 };
+    pb_uint(&packet, PF_PACKET_SEQUENCE_ID, TRACE_SEQUENCE_ID);
+    pb_bytes(&packet, PF_PACKET_TRACK_DESCRIPTOR, desc.data, desc.len);
+    write_packet(f, &packet);
+
+    for (size_t i = 0; i < count; i++) {
+        const trace_site_t *site = ev[i].site;
+
+        pb_buf_t event = { .len = 0 };
+        pb_uint(&event, PF_EVENT_TYPE, PF_SLICE_BEGIN);
+        pb_uint(&event, PF_EVENT_TRACK_UUID, track);
+        pb_string(&event, PF_EVENT_CATEGORIES, site->category);
+        pb_string(&event, PF_EVENT_NAME, site->name);
+        for (int a = 0; a < TRACE_MAX_ARGS; a++) {
+            if (!site->args[a]) continue;
+            pb_buf_t ann = { .len = 0 };
+            pb_string(&ann, PF_ANNOTATION_NAME, site->args[a]);
+            double v = ev[i].args[a];
+            if (v == (double)(int64_t)v) {
+                pb_uint(&ann, PF_ANNOTATION_INT, (uint64_t)(int64_t)v);
+            } else {
+                pb_double(&ann, PF_ANNOTATION_DOUBLE, v);
+            }
+            pb_bytes(&event, PF_EVENT_DEBUG_ANNOTATIONS, ann.data, ann.len);
+        }
+
+        packet.len = 0;
+        pb_uint(&packet, PF_PACKET_TIMESTAMP, ev[i].start);
+        pb_uint(&packet, PF_PACKET_SEQUENCE_ID, TRACE_SEQUENCE_ID);
+        pb_bytes(&packet, PF_PACKET_TRACK_EVENT, event.data, event.len);
+        write_packet(f, &packet);
+
+        event.len = 0;
+        pb_uint(&event, PF_EVENT_TYPE, PF_SLICE_END);
+        pb_uint(&event, PF_EVENT_TRACK_UUID, track);
+
+        packet.len = 0;
+        pb_uint(&packet, PF_PACKET_TIMESTAMP, ev[i].start + ev[i].duration);
+        pb_uint(&packet, PF_PACKET_SEQUENCE_ID, TRACE_SEQUENCE_ID);
+        pb_bytes(&packet, PF_PACKET_TRACK_EVENT, event.data, event.len);
+        write_packet(f, &packet);
+    }
+}
+
+int trace_write(const char *path, trace_format_t format) {
+    if (!path) return -1;
+
+    FILE *f = fopen(path, format == TRACE_FORMAT_PERFETTO ? "wb" : "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open trace file %s\n", path);
+        return -1;
+    }
+
+    trace_record_t *events = malloc(TRACE_RING_EVENTS * sizeof(trace_record_t));
+    if (!events) {
+        fprintf(stderr, "Failed to allocate trace snapshot\n");
+        fclose(f);
+        return -1;
+    }
+
+    // Tick rate over everything recorded so far
+    pthread_once(&g_trace_once, trace_calibrate_origin);
+    uint64_t now_ns = trace_now_ns();
+    uint64_t now_ticks = trace_ticks();
+    double ns_per_tick = now_ticks > g_origin_ticks
+        ? (double)(now_ns - g_origin_ns) / (double)(now_ticks - g_origin_ticks) : 1.0;
+
+    int pid = (int)getpid();
+    bool first = true;
+    size_t total = 0;
+    if (format == TRACE_FORMAT_CHROME_JSON) {
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+    }
+
+    int rings = atomic_load_explicit(&g_ring_count, memory_order_acquire);
+    if (rings > TRACE_MAX_RINGS) rings = TRACE_MAX_RINGS;
+    for (int i = 0; i < rings; i++) {
+        trace_ring_t *ring = __atomic_load_n(&g_rings[i], __ATOMIC_ACQUIRE);
+        if (!ring) continue;   // Registered, not yet published
+
+        size_t count = snapshot_ring(ring, events);
+        ticks_to_ns(events, count, ns_per_tick);
+        if (format == TRACE_FORMAT_PERFETTO) {
+            write_perfetto(f, pid, ring, events, count);
+        } else {
+            write_json(f, pid, ring, events, count, &first);
+        }
+        total += count;
+    }
+
+    if (format == TRACE_FORMAT_CHROME_JSON) {
+        fputs("\n]}\n", f);
+    }
+
+    free(events);
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Failed to write trace file %s\n", path);
+        return -1;
+    }
+
+    log_message(true, "Trace: %zu events from %d threads written to %s\n", total, rings, path);
+    return 0;
+}
+
+#else
+
+void trace_set_enabled(bool enabled) {
+    (void)enabled;
+}
+
+bool trace_is_enabled(void) {
+    return false;
+}
+
+int trace_write(const char *path, trace_format_t format) {
+    (void)path;
+    (void)format;
+    fprintf(stderr, "Tracing not compiled in (rebuild with -DTETRA_TRACE=ON)\n");
+    return -1;
+}
+
+#endif
+
+// File extension picks the format: .json for Chrome, anything else Perfetto
+trace_format_t trace_format_for_path(const char *path) {
+    size_t len = path ? strlen(path) : 0;
+    if (len >= 5 && strcmp(path + len - 5, ".json") == 0) {
+        return TRACE_FORMAT_CHROME_JSON;
+    }
+    return TRACE_FORMAT_PERFETTO;
+}
@@ -10,10 +10,51 @@
 #include <unistd.h>
 #include <time.h>
 
+// Voice demodulators are made here rather than on a grant: a grant is
+// handled on the SDR thread, where the arena's mutex and a possible chunk
+// mapping would stall capture. Every active slot and the slot the next grant
+// takes (the first free one) get one, so memory grows with the calls a site
+// actually runs at once. Returns true if it made one.
+static bool prepare_voice_demod(channel_manager_t *mgr) {
+    int slot = -1;
+    bool free_seen = false;
+
+    pthread_mutex_lock(&mgr->channel_lock);
+    for (int i = 0; i < MAX_ACTIVE_CHANNELS && slot < 0; i++) {
+        voice_channel_t *ch = &mgr->voice_channels[i];
+        if (!ch->active) {
+            if (free_seen) continue;
+            free_seen = true;
+        }
+        if (!ch->demod) slot = i;
+    }
+    pthread_mutex_unlock(&mgr->channel_lock);
+    if (slot < 0) return false;
+
+    // Created outside the lock, installed under it
+    float squelch = mgr->params ? mgr->params->min_signal_power : 15.0f;
+    tetra_demod_t *demod = tetra_demod_init(TETRA_SAMPLE_RATE, mgr->params, mgr->status, squelch);
+    if (!demod) {
+        LOG_AT(LOG_LEVEL_WARN, 1, "⚠ No memory for voice channel %d demodulator\n", slot);
+        return false;
+    }
+
+    pthread_mutex_lock(&mgr->channel_lock);
+    if (!mgr->voice_channels[slot].demod) {
+        // The SDR thread reads it without the lock
+        atomic_store_explicit(&mgr->voice_channels[slot].demod, demod, memory_order_release);
+        demod = NULL;
+    }
+    pthread_mutex_unlock(&mgr->channel_lock);
+    tetra_demod_cleanup(demod);
+    return true;
+}
+
 // Channel monitoring thread
 static void* channel_monitor_thread(void *arg) {
     channel_manager_t *mgr = (channel_manager_t*)arg;
 
+    thread_policy_apply(THREAD_ROLE_CONTROL, -1);
     log_message(true, "Channel monitor thread started\n");
 
     while (mgr->running) {
@@ -56,16 +97,20 @@ static void* channel_monitor_thread(void *arg) {
         }
         pthread_mutex_unlock(&mgr->channel_lock);
 
+        while (prepare_voice_demod(mgr)) {
+        }
+
         usleep(100000); // 100ms
     }
 
+    thread_policy_leave();
     return NULL;
 }
 
 // Initialize channel manager
 channel_manager_t* channel_manager_init(trunking_config_t *config, rtl_sdr_t *sdr,
                                         detection_params_t *params, detection_status_t *status) {
-    channel_manager_t *mgr = calloc(1, sizeof(channel_manager_t));
+    channel_manager_t *mgr = rt_alloc(RT_POOL_TRUNKING, sizeof(channel_manager_t));
     if (!mgr) {
         fprintf(stderr, "Failed to allocate channel manager\n");
         return NULL;
@@ -73,6 +118,8 @@ channel_manager_t* channel_manager_init(trunking_config_t *config, rtl_sdr_t *sd
 
     // Copy configuration
     memcpy(&mgr->config, config, sizeof(trunking_config_t));
+    mgr->params = params;
+    mgr->status = status;
 
     // Initialize mutexes
     pthread_mutex_init(&mgr->talk_group_lock, NULL);
@@ -90,11 +137,16 @@ channel_manager_t* channel_manager_init(trunking_config_t *config, rtl_sdr_t *sd
         }
     }
 
-    // Initialize voice channel demodulators
+    // Voice channel demodulators: the first slot's now, the rest as calls
+    // come, from the monitor thread
     for (int i = 0; i < MAX_ACTIVE_CHANNELS; i++) {
         mgr->voice_channels[i].active = false;
         mgr->voice_channels[i].demod = NULL;
     }
+    prepare_voice_demod(mgr);
+
+    // Control channel coding keyed by the cell's network code and colour code
+    lower_mac_init(&mgr->lower_mac, config->mcc, config->mnc, config->colour_code);
 
     mgr->sdr = sdr;
     mgr->current_frequency = config->control_channel_freq;
@@ -106,6 +158,12 @@ channel_manager_t* channel_manager_init(trunking_config_t *config, rtl_sdr_t *sd
     log_message(true, "  Auto-follow: %s\n", config->auto_follow ? "enabled" : "disabled");
     log_message(true, "  Emergency override: %s\n", config->emergency_override ? "enabled" : "disabled");
     log_message(true, "  Priority threshold: %d\n", config->priority_threshold);
+    if (config->raw_control) {
+        log_message(true, "  Control coding: raw PDUs (no FEC)\n");
+    } else {
+        log_message(true, "  Control coding: SCH/HD (MCC=%u MNC=%u CC=%u)\n",
+                   config->mcc, config->mnc, config->colour_code);
+    }
 
     return mgr;
 }
@@ -170,7 +228,7 @@ void channel_manager_cleanup(channel_manager_t *mgr) {
     pthread_mutex_destroy(&mgr->channel_lock);
     pthread_mutex_destroy(&mgr->history_lock);
 
-    free(mgr);
+    rt_free(mgr);
 }
 
 // Add talk group
@@ -259,10 +317,10 @@ void channel_manager_list_talk_groups(channel_manager_t *mgr) {
 void channel_manager_process_control_message(channel_manager_t *mgr, ctrl_message_t *msg) {
     if (!mgr || !msg) return;
 
-    mgr->last_control_msg_time = get_timestamp_us();
+    mgr->last_control_msg_time = get_timestamp_coarse_us();
     mgr->control_msg_count++;
 
-    log_message(true, "[CTRL] %s: TG=%u SRC=%u FREQ=%u ENC=%d EMER=%d\n",
+    LOG_AT(LOG_LEVEL_INFO, 50, "[CTRL] %s: TG=%u SRC=%u FREQ=%u ENC=%d EMER=%d\n",
                ctrl_msg_type_to_string(msg->type),
                msg->talk_group_id, msg->source_id, msg->channel_freq,
                msg->encrypted, msg->emergency);
@@ -271,7 +329,7 @@ void channel_manager_process_control_message(channel_manager_t *mgr, ctrl_messag
     talk_group_t *tg = channel_manager_get_talk_group(mgr, msg->talk_group_id);
     if (tg) {
         pthread_mutex_lock(&mgr->talk_group_lock);
-        tg->last_activity = get_timestamp_us();
+        tg->last_activity = get_timestamp_coarse_us();
         tg->call_count++;
         pthread_mutex_unlock(&mgr->talk_group_lock);
     }
@@ -325,11 +383,20 @@ void channel_manager_process_control_message(channel_manager_t *mgr, ctrl_messag
 
                 if (slot >= 0) {
                     voice_channel_t *ch = &mgr->voice_channels[slot];
+
+                    // The monitor thread keeps this slot's demodulator ready. Grants
+                    // closer together than its 100 ms tick can find none yet, and
+                    // are followed on the standalone demodulator until it is made
+                    if (!ch->demod) {
+                        LOG_AT(LOG_LEVEL_WARN, 1, "⚠ Voice channel %d demodulator not ready yet\n", slot);
+                    }
+
                     ch->frequency = msg->channel_freq;
                     ch->talk_group_id = msg->talk_group_id;
                     ch->source_id = msg->source_id;
                     ch->active = true;
                     ch->encrypted = msg->encrypted;
+                    ch->emergency = msg->emergency;
                     ch->grant_time = get_timestamp_us();
                     ch->last_update = ch->grant_time;
                     ch->signal_strength = 0.0f;
@@ -398,6 +465,15 @@ voice_channel_t* channel_manager_get_active_channel(channel_manager_t *mgr, uint
     return NULL;
 }
 
+// Decode a control PDU from the signalling block following the training sequence
+bool channel_manager_decode_control_burst(channel_manager_t *mgr, tetra_demod_t *demod,
+                                          ctrl_message_t *msg) {
+    if (!mgr || !demod || !msg) return false;
+
+    return decode_control_burst(&mgr->lower_mac, mgr->config.raw_control, demod->demod_bits,
+                                demod->bit_count, demod->sync_offset, msg);
+}
+
 // Tune to channel
 void channel_manager_tune_to_channel(channel_manager_t *mgr, uint32_t frequency) {
     if (!mgr || !mgr->sdr) return;
@@ -421,6 +497,23 @@ void channel_manager_print_statistics(channel_manager_t *mgr) {
     printf("Encrypted calls: %u\n", mgr->encrypted_calls);
     printf("Active voice channels: %d\n", mgr->active_channel_count);
     printf("Talk groups tracked: %d\n", mgr->talk_group_count);
+    if (!mgr->config.raw_control) {
+        printf("Control blocks OK / CRC errors: %llu / %llu\n",
+               (unsigned long long)mgr->lower_mac.blocks_ok,
+               (unsigned long long)mgr->lower_mac.crc_errors);
+    }
+
+    ctrl_decode_stats_t stats;
+    control_channel_get_stats(&stats);
+    printf("\nControl PDUs decoded:\n");
+    for (int i = 0; i < CTRL_MSG_UNKNOWN; i++) {
+        if (stats.decoded[i] > 0) {
+            printf("  %-16s %llu\n", ctrl_msg_type_to_string((ctrl_msg_type_t)i),
+                   (unsigned long long)stats.decoded[i]);
+        }
+    }
+    printf("  %-16s %llu\n", "UNKNOWN", (unsigned long long)stats.unknown);
+    printf("  %-16s %llu\n", "REJECTED", (unsigned long long)stats.rejected);
     printf("\n");
 }
 
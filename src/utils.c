@@ -1,14 +1,11 @@
 /*
  * Utility Functions
- * Helper functions for logging, debugging, and timing
+ * Helper functions for debugging
  */
 
 #include "tetra_analyzer.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdarg.h>
-#include <time.h>
-#include <sys/time.h>
 
 void hex_dump(const uint8_t *data, size_t len, const char *label) {
     if (label) {
@@ -30,22 +27,6 @@ void hex_dump(const uint8_t *data, size_t len, const char *label) {
     }
 }
 
-uint64_t get_timestamp_us(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
-}
-
-void log_message(bool verbose, const char *format, ...) {
-    if (!verbose) return;
-
-    va_list args;
-    va_start(args, format);
-    vprintf(format, args);
-    va_end(args);
-    fflush(stdout);
-}
-
 // Binary to string conversion
 void bits_to_string(const uint8_t *bits, size_t len, char *output) {
     for (size_t i = 0; i < len; i++) {
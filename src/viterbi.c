@@ -0,0 +1,451 @@
+/*
+ * Viterbi Decoder Module
+ * Soft-decision decoder for the TETRA rate-1/4, K=5 mother convolutional code
+ *
+ * The 16-state trellis is processed as eight radix-2 butterflies per step.
+ * Path metrics are saturating int16, renormalised against state 0 after
+ * every step. Ties always resolve to the even predecessor, so every variant
+ * produces decisions identical to the scalar reference:
+ *
+ *   scalar  - portable reference
+ *   SSE4.1  - one block, even/odd metrics in two 128-bit registers
+ *   AVX2    - two blocks at once, one per 128-bit lane (batch API)
+ *   NEON    - one block, even/odd metrics in two Q registers
+ *
+ * x86 variants are compiled with target attributes and selected at run time,
+ * so a generic build still uses the best unit the CPU has.
+ */
+
+#include "tetra_analyzer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VITERBI_HAVE_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VITERBI_HAVE_NEON 1
+#endif
+
+#define VITERBI_STATES 16
+#define VITERBI_BUTTERFLIES 8
+#define VITERBI_METRIC_FLOOR (-8192)   // Initial metric of unreachable states
+
+// Generator polynomials over (u << 4) | state, where state bit 3 is the
+// previous input bit and bit 0 the oldest one (EN 300 392-2, 8.2.3.1.1)
+// G1 = 1 + D + D^4, G2 = 1 + D^2 + D^3 + D^4,
+// G3 = 1 + D + D^2 + D^4, G4 = 1 + D + D^3 + D^4
+static const uint8_t VITERBI_GENERATORS[VITERBI_CODE_RATE] = { 0x19, 0x17, 0x1D, 0x1B };
+
+// Expected output of butterfly j (state 2j, input 0) as +1 for '1', -1 for '0'
+static const int16_t BUTTERFLY_SIGNS[VITERBI_CODE_RATE][VITERBI_BUTTERFLIES] = {
+    { -1, -1, -1, -1,  1,  1,  1,  1 },
+    { -1,  1,  1, -1, -1,  1,  1, -1 },
+    { -1, -1,  1,  1,  1,  1, -1, -1 },
+    { -1,  1, -1,  1,  1, -1,  1, -1 },
+};
+
+static inline int parity8(uint8_t x) {
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1;
+}
+
+static inline int16_t sat_add16(int16_t a, int16_t b) {
+    int32_t r = (int32_t)a + b;
+    if (r > INT16_MAX) r = INT16_MAX;
+    if (r < INT16_MIN) r = INT16_MIN;
+    return (int16_t)r;
+}
+
+static inline int16_t sat_sub16(int16_t a, int16_t b) {
+    int32_t r = (int32_t)a - b;
+    if (r > INT16_MAX) r = INT16_MAX;
+    if (r < INT16_MIN) r = INT16_MIN;
+    return (int16_t)r;
+}
+
+void viterbi_encode(const uint8_t *bits, int n_bits, uint8_t *coded) {
+    uint8_t state = 0;
+
+    for (int n = 0; n < n_bits; n++) {
+        uint8_t reg = (uint8_t)(((bits[n] & 1) << 4) | state);
+        for (int i = 0; i < VITERBI_CODE_RATE; i++) {
+            coded[n * VITERBI_CODE_RATE + i] = (uint8_t)parity8(reg & VITERBI_GENERATORS[i]);
+        }
+        state = reg >> 1;
+    }
+}
+
+// Scalar add-compare-select over all steps; records one decision word per step
+static void viterbi_acs_scalar(const int8_t *soft, int n_steps, uint16_t *decisions) {
+    int16_t metrics[VITERBI_STATES] = {0};
+    int16_t next[VITERBI_STATES];
+
+    // Trellis starts in state 0
+    for (int s = 1; s < VITERBI_STATES; s++) {
+        metrics[s] = VITERBI_METRIC_FLOOR;
+    }
+
+    for (int n = 0; n < n_steps; n++) {
+        const int8_t *sym = &soft[n * VITERBI_CODE_RATE];
+        uint16_t dec = 0;
+
+        for (int j = 0; j < VITERBI_BUTTERFLIES; j++) {
+            int16_t bm = 0;
+            for (int i = 0; i < VITERBI_CODE_RATE; i++) {
+                bm += BUTTERFLY_SIGNS[i][j] * sym[i];
+            }
+
+            int16_t m0 = sat_add16(metrics[2 * j], bm);
+            int16_t m1 = sat_sub16(metrics[2 * j + 1], bm);
+            int16_t m2 = sat_sub16(metrics[2 * j], bm);
+            int16_t m3 = sat_add16(metrics[2 * j + 1], bm);
+
+            next[j] = (m1 > m0) ? m1 : m0;
+            next[j + 8] = (m3 > m2) ? m3 : m2;
+            dec |= (uint16_t)((m1 > m0) << j);
+            dec |= (uint16_t)((m3 > m2) << (j + 8));
+        }
+
+        int16_t norm = next[0];
+        for (int s = 0; s < VITERBI_STATES; s++) {
+            metrics[s] = sat_sub16(next[s], norm);
+        }
+        decisions[n] = dec;
+    }
+}
+
+#ifdef VITERBI_HAVE_X86
+// Gathers even int16 lanes into the low half and odd lanes into the high half
+#define VITERBI_SPLIT_MASK 15, 14, 11, 10, 7, 6, 3, 2, 13, 12, 9, 8, 5, 4, 1, 0
+
+// Byte shuffles broadcasting int16 word k of each 128-bit lane
+#define VITERBI_BCAST_MASK(k) \
+    (2 * (k) + 1), (2 * (k)), (2 * (k) + 1), (2 * (k)), (2 * (k) + 1), (2 * (k)), \
+    (2 * (k) + 1), (2 * (k)), (2 * (k) + 1), (2 * (k)), (2 * (k) + 1), (2 * (k)), \
+    (2 * (k) + 1), (2 * (k)), (2 * (k) + 1), (2 * (k))
+
+static inline int32_t load_symbols(const int8_t *sym) {
+    int32_t v;
+    memcpy(&v, sym, sizeof(v));
+    return v;
+}
+
+// SSE4.1 add-compare-select: even/odd predecessor metrics in two registers
+__attribute__((target("sse4.1")))
+static void viterbi_acs_sse41(const int8_t *soft, int n_steps, uint16_t *decisions) {
+    const __m128i sign0 = _mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[0]);
+    const __m128i sign1 = _mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[1]);
+    const __m128i sign2 = _mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[2]);
+    const __m128i sign3 = _mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[3]);
+    const __m128i split = _mm_set_epi8(VITERBI_SPLIT_MASK);
+    const __m128i bcast0 = _mm_set_epi8(VITERBI_BCAST_MASK(0));
+    const __m128i bcast1 = _mm_set_epi8(VITERBI_BCAST_MASK(1));
+    const __m128i bcast2 = _mm_set_epi8(VITERBI_BCAST_MASK(2));
+    const __m128i bcast3 = _mm_set_epi8(VITERBI_BCAST_MASK(3));
+
+    // even = metrics[0,2,..,14], odd = metrics[1,3,..,15]; start in state 0
+    __m128i even = _mm_insert_epi16(_mm_set1_epi16(VITERBI_METRIC_FLOOR), 0, 0);
+    __m128i odd = _mm_set1_epi16(VITERBI_METRIC_FLOOR);
+
+    for (int n = 0; n < n_steps; n++) {
+        // Four soft symbols widened to int16, then broadcast one at a time
+        __m128i sym = _mm_cvtepi8_epi16(_mm_cvtsi32_si128(load_symbols(&soft[n * VITERBI_CODE_RATE])));
+
+        __m128i bm = _mm_sign_epi16(_mm_shuffle_epi8(sym, bcast0), sign0);
+        bm = _mm_add_epi16(bm, _mm_sign_epi16(_mm_shuffle_epi8(sym, bcast1), sign1));
+        bm = _mm_add_epi16(bm, _mm_sign_epi16(_mm_shuffle_epi8(sym, bcast2), sign2));
+        bm = _mm_add_epi16(bm, _mm_sign_epi16(_mm_shuffle_epi8(sym, bcast3), sign3));
+
+        __m128i m0 = _mm_adds_epi16(even, bm);
+        __m128i m1 = _mm_subs_epi16(odd, bm);
+        __m128i m2 = _mm_subs_epi16(even, bm);
+        __m128i m3 = _mm_adds_epi16(odd, bm);
+
+        __m128i lo = _mm_max_epi16(m0, m1);
+        __m128i hi = _mm_max_epi16(m2, m3);
+        __m128i dec = _mm_packs_epi16(_mm_cmpgt_epi16(m1, m0), _mm_cmpgt_epi16(m3, m2));
+        decisions[n] = (uint16_t)_mm_movemask_epi8(dec);
+
+        __m128i norm = _mm_shufflelo_epi16(lo, 0);
+        norm = _mm_unpacklo_epi64(norm, norm);
+        lo = _mm_shuffle_epi8(_mm_subs_epi16(lo, norm), split);
+        hi = _mm_shuffle_epi8(_mm_subs_epi16(hi, norm), split);
+
+        even = _mm_unpacklo_epi64(lo, hi);
+        odd = _mm_unpackhi_epi64(lo, hi);
+    }
+}
+
+
+// AVX2 add-compare-select for two blocks: block A in lane 0, block B in lane 1
+__attribute__((target("avx2")))
+static void viterbi_acs_avx2_x2(const int8_t *soft_a, const int8_t *soft_b, int n_steps,
+                                uint16_t *dec_a, uint16_t *dec_b) {
+    const __m256i sign0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[0]));
+    const __m256i sign1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[1]));
+    const __m256i sign2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[2]));
+    const __m256i sign3 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)BUTTERFLY_SIGNS[3]));
+    const __m256i split = _mm256_broadcastsi128_si256(_mm_set_epi8(VITERBI_SPLIT_MASK));
+    const __m256i bcast0 = _mm256_broadcastsi128_si256(_mm_set_epi8(VITERBI_BCAST_MASK(0)));
+    const __m256i bcast1 = _mm256_broadcastsi128_si256(_mm_set_epi8(VITERBI_BCAST_MASK(1)));
+    const __m256i bcast2 = _mm256_broadcastsi128_si256(_mm_set_epi8(VITERBI_BCAST_MASK(2)));
+    const __m256i bcast3 = _mm256_broadcastsi128_si256(_mm_set_epi8(VITERBI_BCAST_MASK(3)));
+
+    const __m128i floor_v = _mm_set1_epi16(VITERBI_METRIC_FLOOR);
+    const __m128i start = _mm_insert_epi16(floor_v, 0, 0);
+    __m256i even = _mm256_inserti128_si256(_mm256_castsi128_si256(start), start, 1);
+    __m256i odd = _mm256_set1_epi16(VITERBI_METRIC_FLOOR);
+
+    for (int n = 0; n < n_steps; n++) {
+        // Block A symbols widen into lane 0, block B symbols into lane 1
+        __m128i packed = _mm_unpacklo_epi64(
+            _mm_cvtsi32_si128(load_symbols(&soft_a[n * VITERBI_CODE_RATE])),
+            _mm_cvtsi32_si128(load_symbols(&soft_b[n * VITERBI_CODE_RATE])));
+        __m256i sym = _mm256_cvtepi8_epi16(packed);
+
+        __m256i bm = _mm256_sign_epi16(_mm256_shuffle_epi8(sym, bcast0), sign0);
+        bm = _mm256_add_epi16(bm, _mm256_sign_epi16(_mm256_shuffle_epi8(sym, bcast1), sign1));
+        bm = _mm256_add_epi16(bm, _mm256_sign_epi16(_mm256_shuffle_epi8(sym, bcast2), sign2));
+        bm = _mm256_add_epi16(bm, _mm256_sign_epi16(_mm256_shuffle_epi8(sym, bcast3), sign3));
+
+        __m256i m0 = _mm256_adds_epi16(even, bm);
+        __m256i m1 = _mm256_subs_epi16(odd, bm);
+        __m256i m2 = _mm256_subs_epi16(even, bm);
+        __m256i m3 = _mm256_adds_epi16(odd, bm);
+
+        __m256i lo = _mm256_max_epi16(m0, m1);
+        __m256i hi = _mm256_max_epi16(m2, m3);
+        __m256i dec = _mm256_packs_epi16(_mm256_cmpgt_epi16(m1, m0), _mm256_cmpgt_epi16(m3, m2));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(dec);
+        dec_a[n] = (uint16_t)mask;
+        dec_b[n] = (uint16_t)(mask >> 16);
+
+        __m256i norm = _mm256_shufflelo_epi16(lo, 0);
+        norm = _mm256_unpacklo_epi64(norm, norm);
+        lo = _mm256_shuffle_epi8(_mm256_subs_epi16(lo, norm), split);
+        hi = _mm256_shuffle_epi8(_mm256_subs_epi16(hi, norm), split);
+
+        even = _mm256_unpacklo_epi64(lo, hi);
+        odd = _mm256_unpackhi_epi64(lo, hi);
+    }
+}
+#endif
+
+#ifdef VITERBI_HAVE_NEON
+static inline uint16_t neon_decision_mask(uint16x8_t lo, uint16x8_t hi) {
+    static const uint16_t weights_lo[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    static const uint16_t weights_hi[8] = { 256, 512, 1024, 2048, 4096, 8192, 16384, 32768 };
+    uint16x8_t bits = vorrq_u16(vandq_u16(lo, vld1q_u16(weights_lo)),
+                                vandq_u16(hi, vld1q_u16(weights_hi)));
+#if defined(__aarch64__)
+    return vaddvq_u16(bits);
+#else
+    uint16x4_t sum = vpadd_u16(vget_low_u16(bits), vget_high_u16(bits));
+    sum = vpadd_u16(sum, sum);
+    sum = vpadd_u16(sum, sum);
+    return vget_lane_u16(sum, 0);
+#endif
+}
+
+// NEON add-compare-select: even/odd predecessor metrics in two registers
+static void viterbi_acs_neon(const int8_t *soft, int n_steps, uint16_t *decisions) {
+    const int16x8_t sign0 = vld1q_s16(BUTTERFLY_SIGNS[0]);
+    const int16x8_t sign1 = vld1q_s16(BUTTERFLY_SIGNS[1]);
+    const int16x8_t sign2 = vld1q_s16(BUTTERFLY_SIGNS[2]);
+    const int16x8_t sign3 = vld1q_s16(BUTTERFLY_SIGNS[3]);
+
+    int16x8_t even = vsetq_lane_s16(0, vdupq_n_s16(VITERBI_METRIC_FLOOR), 0);
+    int16x8_t odd = vdupq_n_s16(VITERBI_METRIC_FLOOR);
+
+    for (int n = 0; n < n_steps; n++) {
+        const int8_t *sym = &soft[n * VITERBI_CODE_RATE];
+
+        int16x8_t bm = vmulq_n_s16(sign0, sym[0]);
+        bm = vmlaq_n_s16(bm, sign1, sym[1]);
+        bm = vmlaq_n_s16(bm, sign2, sym[2]);
+        bm = vmlaq_n_s16(bm, sign3, sym[3]);
+
+        int16x8_t m0 = vqaddq_s16(even, bm);
+        int16x8_t m1 = vqsubq_s16(odd, bm);
+        int16x8_t m2 = vqsubq_s16(even, bm);
+        int16x8_t m3 = vqaddq_s16(odd, bm);
+
+        int16x8_t lo = vmaxq_s16(m0, m1);
+        int16x8_t hi = vmaxq_s16(m2, m3);
+        decisions[n] = neon_decision_mask(vcgtq_s16(m1, m0), vcgtq_s16(m3, m2));
+
+        int16x8_t norm = vdupq_lane_s16(vget_low_s16(lo), 0);
+        lo = vqsubq_s16(lo, norm);
+        hi = vqsubq_s16(hi, norm);
+
+        int16x8x2_t split = vuzpq_s16(lo, hi);
+        even = split.val[0];
+        odd = split.val[1];
+    }
+}
+#endif
+
+// Trace back from state 0 (trellis is terminated by tail bits)
+static void viterbi_traceback(const uint16_t *decisions, int n_steps, uint8_t *bits) {
+    unsigned state = 0;
+
+    for (int n = n_steps - 1; n >= 0; n--) {
+        unsigned d = (decisions[n] >> state) & 1;
+        bits[n] = (uint8_t)(state >> 3);
+        state = ((state & 0x7) << 1) | d;
+    }
+}
+
+// Implementation selection
+
+// Decoders on any thread read it while viterbi_set_impl() may change it
+static _Atomic viterbi_impl_t g_viterbi_impl = VITERBI_IMPL_SCALAR;
+static pthread_once_t g_viterbi_once = PTHREAD_ONCE_INIT;
+
+bool viterbi_impl_available(viterbi_impl_t impl) {
+    switch (impl) {
+        case VITERBI_IMPL_SCALAR:
+            return true;
+#ifdef VITERBI_HAVE_X86
+        case VITERBI_IMPL_SSE41:
+            return __builtin_cpu_supports("sse4.1");
+        case VITERBI_IMPL_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef VITERBI_HAVE_NEON
+        case VITERBI_IMPL_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* viterbi_impl_name(viterbi_impl_t impl) {
+    switch (impl) {
+        case VITERBI_IMPL_AUTO:   return "auto";
+        case VITERBI_IMPL_SCALAR: return "scalar";
+        case VITERBI_IMPL_SSE41:  return "sse4.1";
+        case VITERBI_IMPL_AVX2:   return "avx2";
+        case VITERBI_IMPL_NEON:   return "neon";
+        default:                  return "unknown";
+    }
+}
+
+static void viterbi_select_best(void) {
+    static const viterbi_impl_t preference[] = {
+        VITERBI_IMPL_AVX2, VITERBI_IMPL_SSE41, VITERBI_IMPL_NEON
+    };
+
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        if (viterbi_impl_available(preference[i])) {
+            atomic_store_explicit(&g_viterbi_impl, preference[i], memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+viterbi_impl_t viterbi_get_impl(void) {
+    pthread_once(&g_viterbi_once, viterbi_select_best);
+    return atomic_load_explicit(&g_viterbi_impl, memory_order_relaxed);
+}
+
+int viterbi_set_impl(viterbi_impl_t impl) {
+    pthread_once(&g_viterbi_once, viterbi_select_best);
+
+    if (impl == VITERBI_IMPL_AUTO) {
+        viterbi_select_best();
+        return 0;
+    }
+    if (!viterbi_impl_available(impl)) {
+        return -1;
+    }
+
+    atomic_store_explicit(&g_viterbi_impl, impl, memory_order_relaxed);
+    return 0;
+}
+
+// Add-compare-select for one block with the given implementation
+static void viterbi_acs(viterbi_impl_t impl, const int8_t *soft, int n_steps, uint16_t *decisions) {
+    switch (impl) {
+#ifdef VITERBI_HAVE_X86
+        case VITERBI_IMPL_SSE41:
+        case VITERBI_IMPL_AVX2:   // Single blocks use the 128-bit kernel
+            viterbi_acs_sse41(soft, n_steps, decisions);
+            break;
+#endif
+#ifdef VITERBI_HAVE_NEON
+        case VITERBI_IMPL_NEON:
+            viterbi_acs_neon(soft, n_steps, decisions);
+            break;
+#endif
+        default:
+            viterbi_acs_scalar(soft, n_steps, decisions);
+            break;
+    }
+}
+
+int viterbi_decode_impl(viterbi_impl_t impl, const int8_t *soft, int n_steps, uint8_t *bits) {
+    if (!soft || !bits || n_steps <= 0 || n_steps > VITERBI_MAX_BITS) {
+        return -1;
+    }
+    if (impl == VITERBI_IMPL_AUTO) {
+        impl = viterbi_get_impl();
+    } else if (!viterbi_impl_available(impl)) {
+        return -1;
+    }
+
+    uint16_t decisions[VITERBI_MAX_BITS];
+    viterbi_acs(impl, soft, n_steps, decisions);
+    viterbi_traceback(decisions, n_steps, bits);
+    return n_steps;
+}
+
+int viterbi_decode(const int8_t *soft, int n_steps, uint8_t *bits) {
+    return viterbi_decode_impl(VITERBI_IMPL_AUTO, soft, n_steps, bits);
+}
+
+int viterbi_decode_batch_impl(viterbi_impl_t impl, const int8_t *soft, int n_steps,
+                              uint8_t *bits, int count) {
+    if (!soft || !bits || n_steps <= 0 || n_steps > VITERBI_MAX_BITS || count < 0) {
+        return -1;
+    }
+    if (impl == VITERBI_IMPL_AUTO) {
+        impl = viterbi_get_impl();
+    } else if (!viterbi_impl_available(impl)) {
+        return -1;
+    }
+
+    const size_t soft_stride = (size_t)n_steps * VITERBI_CODE_RATE;
+    uint16_t decisions[2][VITERBI_MAX_BITS];
+    int b = 0;
+
+#ifdef VITERBI_HAVE_X86
+    if (impl == VITERBI_IMPL_AVX2) {
+        for (; b + 1 < count; b += 2) {
+            viterbi_acs_avx2_x2(soft + b * soft_stride, soft + (b + 1) * soft_stride, n_steps,
+                                decisions[0], decisions[1]);
+            viterbi_traceback(decisions[0], n_steps, bits + (size_t)b * n_steps);
+            viterbi_traceback(decisions[1], n_steps, bits + (size_t)(b + 1) * n_steps);
+        }
+    }
+#endif
+
+    for (; b < count; b++) {
+        viterbi_acs(impl, soft + b * soft_stride, n_steps, decisions[0]);
+        viterbi_traceback(decisions[0], n_steps, bits + (size_t)b * n_steps);
+    }
+
+    return count;
+}
+
+int viterbi_decode_batch(const int8_t *soft, int n_steps, uint8_t *bits, int count) {
+    return viterbi_decode_batch_impl(VITERBI_IMPL_AUTO, soft, n_steps, bits, count);
+}
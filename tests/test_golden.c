@@ -0,0 +1,686 @@
+/*
+ * Golden Output Regression Tests
+ * Kernels against plain C references, and the full receive pipeline against
+ * a stored transcript
+ *
+ * Part 1 runs each DSP kernel (whatever SIMD path this build compiled in)
+ * and each runtime-selectable variant against a straightforward reference,
+ * with a tolerance chosen per kernel: integer paths must be exact, float
+ * paths may differ by rounding (and by -ffast-math reassociation).
+ *
+ * Part 2 modulates canned burst sequences into IQ, pushes them through
+ * demodulation, burst detection, control PDU decoding, TEA1 and the codec,
+ * and compares a text transcript of the results with tests/golden/. Burst
+ * positions, bits and control messages must match exactly; measured power
+ * and correlation within 0.1 %, PCM within a few LSB.
+ *
+ * Usage: test_golden GOLDEN_FILE            compare
+ *        test_golden --update GOLDEN_FILE   rewrite after an intended change
+ */
+
+#include "tetra_analyzer.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_LEN 4099                  // Odd length exercises every SIMD tail
+#define SYMBOL_SAMPLES 133             // Matches the demodulator's slicer spacing
+#define FM_DEVIATION 0.4f              // Radians per sample
+#define MAX_LINES 4096
+#define PCM_TOLERANCE 4                // LSB
+#define MEASURE_TOLERANCE 1e-3         // Relative, for burst power and correlation
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static const uint8_t TRAINING_SEQ[TETRA_TRAINING_SEQ_BITS] = {
+    1, 1, 0, 0, 1, 0, 1, 0, 0, 1, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1, 0
+};
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static bool close_rel(double a, double b, double tol) {
+    double scale = fabs(b) > 1.0 ? fabs(b) : 1.0;
+    return fabs(a - b) <= tol * scale;
+}
+
+// Part 1: kernels
+
+static void test_kernels(void) {
+    static uint8_t u8[TEST_LEN];
+    static float fi[TEST_LEN], fq[TEST_LEN], out[TEST_LEN], ref[TEST_LEN];
+    static int16_t s16[TEST_LEN], s16_ref[TEST_LEN], acc[TEST_LEN], acc_ref[TEST_LEN];
+    int before = failures;
+
+    rng_state = 0x2468ACE1;
+    for (int n = 0; n < TEST_LEN; n++) {
+        u8[n] = (uint8_t)rng_next();
+        fi[n] = (float)((int)(rng_next() % 2001) - 1000) / 7.0f;
+        fq[n] = (float)((int)(rng_next() % 2001) - 1000) / 7.0f;
+        acc[n] = acc_ref[n] = (int16_t)rng_next();
+        s16_ref[n] = (int16_t)rng_next();
+    }
+
+    // convert_uint8_to_float: exact
+    convert_uint8_to_float(u8, out, TEST_LEN);
+    for (int n = 0; n < TEST_LEN; n++) {
+        CHECK(out[n] == (float)u8[n], "convert_uint8_to_float[%d] = %f", n, out[n]);
+        if (out[n] != (float)u8[n]) break;
+    }
+
+    // convert_float_to_int16: exact, including saturation and truncation toward zero
+    for (int n = 0; n < TEST_LEN; n++) {
+        ref[n] = fi[n] * 1.5f;
+    }
+    convert_float_to_int16(ref, s16, TEST_LEN, 300.0f);
+    for (int n = 0; n < TEST_LEN; n++) {
+        float x = ref[n] * 300.0f;
+        int16_t want = x > 32767.0f ? 32767 : x < -32768.0f ? -32768 : (int16_t)x;
+        CHECK(s16[n] == want, "convert_float_to_int16[%d] = %d, want %d", n, s16[n], want);
+        if (s16[n] != want) break;
+    }
+
+    // mix_int16_q15: exact, rounding as pmulhrsw/vqrdmulh, at -3 dB and full scale
+    static const int16_t MIX_GAINS[] = { 23170, 32767 };
+    s16_ref[0] = -32768;
+    s16_ref[1] = 32767;
+    for (size_t g = 0; g < sizeof(MIX_GAINS) / sizeof(MIX_GAINS[0]); g++) {
+        int16_t gain = MIX_GAINS[g];
+        memcpy(acc, acc_ref, sizeof(acc));
+        mix_int16_q15(acc, s16_ref, gain, TEST_LEN);
+        for (int n = 0; n < TEST_LEN; n++) {
+            int32_t sum = acc_ref[n] + (((int32_t)s16_ref[n] * gain + 0x4000) >> 15);
+            int16_t want = sum > 32767 ? 32767 : sum < -32768 ? -32768 : (int16_t)sum;
+            CHECK(acc[n] == want, "mix_int16_q15[%d] gain %d = %d, want %d", n, gain, acc[n], want);
+            if (acc[n] != want) break;
+        }
+    }
+
+    // quadrature_demod: wrapped phase difference, to float rounding
+    quadrature_demod(fi, fq, out, TEST_LEN);
+    double prev = 0.0;
+    for (int n = 0; n < TEST_LEN; n++) {
+        double phase = atan2((double)fq[n], (double)fi[n]);
+        double d = phase - prev;
+        if (d > M_PI) d -= 2.0 * M_PI;
+        else if (d < -M_PI) d += 2.0 * M_PI;
+        prev = phase;
+        // Differences that land on +-pi may wrap either way
+        bool ok = fabs(out[n] - d) <= 1e-4 || fabs(fabs(d) - M_PI) < 1e-3;
+        CHECK(ok, "quadrature_demod[%d] = %f, want %f", n, out[n], d);
+        if (!ok) break;
+    }
+
+    // low_pass_filter: single-pole IIR
+    memcpy(out, fi, sizeof(out));
+    low_pass_filter(out, TEST_LEN, 0.3f);
+    double y = fi[0];
+    for (int n = 1; n < TEST_LEN; n++) {
+        y = 0.3 * fi[n] + 0.7 * y;
+        CHECK(close_rel(out[n], y, 1e-4), "low_pass_filter[%d] = %f, want %f", n, out[n], y);
+        if (!close_rel(out[n], y, 1e-4)) break;
+    }
+
+    // detect_signal_strength: RMS magnitude; long float sums reassociate
+    double power = 0.0;
+    for (int n = 0; n < TEST_LEN; n++) {
+        power += (double)fi[n] * fi[n] + (double)fq[n] * fq[n];
+    }
+    double rms = sqrt(power / TEST_LEN);
+    float got = detect_signal_strength(fi, fq, TEST_LEN);
+    CHECK(close_rel(got, rms, 1e-4), "detect_signal_strength = %f, want %f", got, rms);
+
+    // Interleaved variants: conversions exact, kernels identical to the split-array ones
+    static cf32_t cf[TEST_LEN / 2];
+    static ci16_t ci[TEST_LEN / 2];
+    convert_cu8_to_cf32(u8, cf, TEST_LEN / 2);
+    convert_cu8_to_ci16(u8, ci, TEST_LEN / 2);
+    for (int n = 0; n < TEST_LEN / 2; n++) {
+        bool ok = cf[n].re == (float)u8[2 * n] - 127.5f && cf[n].im == (float)u8[2 * n + 1] - 127.5f &&
+                  ci[n].re == u8[2 * n] * 256 - 32640 && ci[n].im == u8[2 * n + 1] * 256 - 32640;
+        CHECK(ok, "convert_cu8_to_cf32/ci16[%d] = %f,%f / %d,%d", n, cf[n].re, cf[n].im, ci[n].re, ci[n].im);
+        if (!ok) break;
+    }
+
+    for (int n = 0; n < TEST_LEN / 2; n++) {
+        cf[n].re = fi[n];
+        cf[n].im = fq[n];
+    }
+    quadrature_demod(fi, fq, ref, TEST_LEN / 2);
+    quadrature_demod_cf32(cf, out, TEST_LEN / 2);
+    CHECK(memcmp(out, ref, TEST_LEN / 2 * sizeof(float)) == 0, "quadrature_demod_cf32 differs");
+    // Power sums: long float sums reassociate
+    CHECK(close_rel(detect_signal_strength_cf32(cf, TEST_LEN / 2), detect_signal_strength(fi, fq, TEST_LEN / 2),
+                    1e-4), "detect_signal_strength_cf32 differs");
+
+    convert_cu8_to_cf32(u8, cf, TEST_LEN / 2);
+    CHECK(close_rel(detect_signal_strength_cu8(u8, TEST_LEN / 2), detect_signal_strength_cf32(cf, TEST_LEN / 2),
+                    1e-4), "detect_signal_strength_cu8 differs");
+    // Integer sums: exact, and rails over a whole SDR buffer span several blocks
+    static uint8_t rails[SDR_BUFFER_SIZE];
+    for (int n = 0; n < SDR_BUFFER_SIZE; n++) rails[n] = (n & 2) ? 255 : 0;
+    float rail_power = detect_signal_strength_cu8(rails, SDR_BUFFER_SIZE / 2 - 1);
+    float rail_want = sqrtf(2.0f * 127.5f * 127.5f);
+    CHECK(rail_power == rail_want, "detect_signal_strength_cu8 at the rails = %f, want %f", rail_power, rail_want);
+
+    // Q15 discriminator and filter track the float ones to well under the
+    // phase noise of 8-bit input (CORDIC error is worst on the smallest vectors)
+    static int16_t q[TEST_LEN / 2];
+    quadrature_demod_cf32(cf, out, TEST_LEN / 2);
+    quadrature_demod_ci16(ci, q, TEST_LEN / 2);
+    for (int pass = 0; pass < 2; pass++) {
+        double sq = 0.0, worst = 0.0;
+        for (int n = 0; n < TEST_LEN / 2; n++) {
+            double e = fabs(q[n] * M_PI / DSP_Q15_PI - out[n]);
+            if (e > M_PI) e = 2.0 * M_PI - e;
+            sq += e * e;
+            if (e > worst) worst = e;
+        }
+        double rms_err = sqrt(sq / (TEST_LEN / 2));
+        CHECK(rms_err < 1e-3 && worst < 1e-2, "%s: error rms %.2e, max %.2e rad",
+              pass ? "low_pass_filter_q15" : "quadrature_demod_ci16", rms_err, worst);
+
+        low_pass_filter(out, TEST_LEN / 2, 0.5f);
+        low_pass_filter_q15(q, TEST_LEN / 2, 16384);
+    }
+
+    printf("%s  signal processing kernels\n", failures == before ? "ok   " : "FAIL ");
+}
+
+// Compile-time FIR and correlator kernels against direct sums and bit compares
+static void test_dsp_kernels(void) {
+    enum { OUT = 301 };                // Odd, as above
+    static cf32_t in[OUT * 16 + 64], out[OUT], generic[OUT];
+    static float fin[OUT * 16 + 64], fout[OUT];
+    static ci16_t qin[OUT * 16 + 64], qout[OUT];
+    static uint8_t bits[TETRA_BURST_LENGTH], matches[TETRA_BURST_LENGTH];
+    int before = failures;
+
+    rng_state = 0x2468ACE1;
+    for (size_t n = 0; n < sizeof(in) / sizeof(in[0]); n++) {
+        in[n].re = (float)(rng_next() % 256) - 127.5f;
+        in[n].im = (float)(rng_next() % 256) - 127.5f;
+        fin[n] = in[n].re;
+        qin[n].re = (int16_t)(in[n].re * 256.0f);
+        qin[n].im = (int16_t)(in[n].im * 256.0f);
+    }
+
+    for (int id = 0; id < DSP_FIR_COUNT; id++) {
+        const dsp_fir_kernel_t *k = dsp_fir_kernel((dsp_fir_id_t)id);
+        CHECK(dsp_fir_find(k->ntaps, k->decim) == k, "%s: not selected by tap count", k->name);
+
+        // Linear phase, unity gain at DC
+        double dc = 0.0;
+        for (uint32_t j = 0; j < k->ntaps; j++) {
+            dc += k->taps[j];
+            CHECK(close_rel(k->taps[j], k->taps[k->ntaps - 1 - j], 1e-6), "%s: tap %u not symmetric",
+                  k->name, j);
+        }
+        CHECK(close_rel(dc, 1.0, 1e-5), "%s: DC gain %f", k->name, dc);
+
+        fir_decimate_cf32(k->taps, k->ntaps, k->decim, in, out, OUT);
+        fir_decimate_f32(k->taps, k->ntaps, k->decim, fin, fout, OUT);
+        // One tap fewer has no specialisation: the generic loop
+        fir_decimate_cf32(k->taps, k->ntaps - 1, k->decim, in, generic, OUT);
+        for (int n = 0; n < OUT; n++) {
+            double re = 0.0, im = 0.0, re_short = 0.0;
+            for (uint32_t j = 0; j < k->ntaps; j++) {
+                re += (double)k->taps[j] * in[n * k->decim + j].re;
+                im += (double)k->taps[j] * in[n * k->decim + j].im;
+                if (j < k->ntaps - 1) re_short += (double)k->taps[j] * in[n * k->decim + j].re;
+            }
+            bool ok = close_rel(out[n].re, re, 1e-4) && close_rel(out[n].im, im, 1e-4) &&
+                      close_rel(fout[n], re, 1e-4) && close_rel(generic[n].re, re_short, 1e-4);
+            CHECK(ok, "%s[%d] = %f,%f (f32 %f, generic %f), want %f,%f (%f)", k->name, n, out[n].re,
+                  out[n].im, fout[n], generic[n].re, re, im, re_short);
+            if (!ok) break;
+        }
+
+        // Q15: exact against a 64-bit sum, specialised and generic
+        for (uint32_t cut = 0; cut < 2; cut++) {
+            uint32_t ntaps = k->ntaps - cut;
+            fir_decimate_ci16(k->taps_q15, ntaps, k->decim, qin, qout, OUT);
+            for (int n = 0; n < OUT; n++) {
+                int64_t re = 0, im = 0;
+                for (uint32_t j = 0; j < ntaps; j++) {
+                    re += (int64_t)k->taps_q15[j] * qin[n * k->decim + j].re;
+                    im += (int64_t)k->taps_q15[j] * qin[n * k->decim + j].im;
+                }
+                re = (re + 0x4000) >> 15;
+                im = (im + 0x4000) >> 15;
+                re = re > 32767 ? 32767 : re < -32768 ? -32768 : re;
+                im = im > 32767 ? 32767 : im < -32768 ? -32768 : im;
+                bool ok = qout[n].re == re && qout[n].im == im;
+                CHECK(ok, "%s q15 (%u taps)[%d] = %d,%d, want %d,%d", k->name, ntaps, n, qout[n].re,
+                      qout[n].im, (int)re, (int)im);
+                if (!ok) break;
+            }
+        }
+    }
+
+    // Training sequence correlator and the generic one, against compares
+    for (int n = 0; n < TETRA_BURST_LENGTH; n++) {
+        bits[n] = (uint8_t)(rng_next() & 1);
+    }
+    memcpy(bits + 100, TRAINING_SEQ, TETRA_TRAINING_SEQ_BITS);
+    for (int variant = 0; variant < 2; variant++) {
+        // The second pattern is the sequence shortened by a bit: generic path
+        uint32_t n = TETRA_TRAINING_SEQ_BITS - (uint32_t)variant;
+        uint32_t offsets = correlate_bits(bits, TETRA_BURST_LENGTH, TRAINING_SEQ, n, matches);
+        CHECK(offsets == TETRA_BURST_LENGTH - n + 1, "correlate_bits(%u) offsets = %u", n, offsets);
+        for (uint32_t o = 0; o < offsets; o++) {
+            int want = 0;
+            for (uint32_t i = 0; i < n; i++) want += bits[o + i] == TRAINING_SEQ[i];
+            CHECK(matches[o] == want, "correlate_bits(%u)[%u] = %d, want %d", n, o, matches[o], want);
+            if (matches[o] != want) break;
+        }
+        CHECK(matches[100] == n, "correlate_bits(%u) missed the sequence", n);
+    }
+
+    printf("%s  compile-time FIR and correlator kernels\n", failures == before ? "ok   " : "FAIL ");
+}
+
+// Every Viterbi variant on coded blocks with noise matches the scalar decoder
+static void test_viterbi_variants(void) {
+    enum { BLOCKS = 33, STEPS = LMAC_MAX_TYPE3_BITS };
+    static int8_t soft[BLOCKS * STEPS * VITERBI_CODE_RATE];
+    static uint8_t ref[BLOCKS * STEPS], out[BLOCKS * STEPS];
+
+    rng_state = 0x13579BDF;
+    for (size_t i = 0; i < sizeof(soft); i++) {
+        soft[i] = (int8_t)((rng_next() & 1) ? 60 : -60) + (int8_t)(rng_next() % 81 - 40);
+    }
+    viterbi_decode_batch_impl(VITERBI_IMPL_SCALAR, soft, STEPS, ref, BLOCKS);
+
+    for (int impl = VITERBI_IMPL_SCALAR + 1; impl < VITERBI_IMPL_COUNT; impl++) {
+        if (!viterbi_impl_available((viterbi_impl_t)impl)) continue;
+
+        memset(out, 0xFF, sizeof(out));
+        viterbi_decode_batch_impl((viterbi_impl_t)impl, soft, STEPS, out, BLOCKS);
+        CHECK(memcmp(ref, out, sizeof(ref)) == 0, "viterbi %s differs from scalar",
+              viterbi_impl_name((viterbi_impl_t)impl));
+        printf("%s  viterbi %s\n", memcmp(ref, out, sizeof(ref)) == 0 ? "ok   " : "FAIL ",
+               viterbi_impl_name((viterbi_impl_t)impl));
+    }
+}
+
+// The batch codec API matches frame-at-a-time decoding exactly
+static void test_codec_batch(void) {
+    enum { CHANNELS = 5, FRAMES = 7 };
+    uint8_t frames[FRAMES][CHANNELS * TETRA_CODEC_FRAME_BYTES];
+    tetra_codec_t *single[CHANNELS], *batch[CHANNELS];
+    int16_t a[TETRA_CODEC_SAMPLES], b[CHANNELS * TETRA_CODEC_SAMPLES];
+    int before = failures;
+
+    rng_state = 0x0F1E2D3C;
+    for (size_t i = 0; i < sizeof(frames); i++) {
+        ((uint8_t *)frames)[i] = (uint8_t)rng_next();
+    }
+    for (int c = 0; c < CHANNELS; c++) {
+        single[c] = tetra_codec_init();
+        batch[c] = tetra_codec_init();
+    }
+
+    for (int f = 0; f < FRAMES; f++) {
+        tetra_codec_decode_frames(batch, frames[f], b, CHANNELS);
+        for (int c = 0; c < CHANNELS; c++) {
+            tetra_codec_decode_frame(single[c], frames[f] + c * TETRA_CODEC_FRAME_BYTES, a);
+            CHECK(memcmp(a, b + c * TETRA_CODEC_SAMPLES, sizeof(a)) == 0,
+                  "codec batch frame %d channel %d differs from single decode", f, c);
+        }
+    }
+
+    for (int c = 0; c < CHANNELS; c++) {
+        tetra_codec_cleanup(single[c]);
+        tetra_codec_cleanup(batch[c]);
+    }
+    printf("%s  codec batch vs single frame\n", failures == before ? "ok   " : "FAIL ");
+}
+
+// Silence between talk spurts must not count as arrival jitter
+static void test_jitter_buffer(void) {
+    enum { RATE = 8000, FRAME_US = JITTER_FRAME_SAMPLES * 1000000 / RATE };
+    audio_ring_t *ring = audio_ring_create(4096);
+    jitter_buffer_t *jb = jitter_buffer_create(ring, RATE);
+    int16_t in[JITTER_FRAME_SAMPLES] = { 0 }, out[JITTER_FRAME_SAMPLES];
+    jitter_stats_t st;
+    uint64_t now = 1000000;
+    int before = failures;
+
+    // A talk spurt with 2 ms of spacing jitter, then a minute of silence
+    for (int f = 0; f < 50; f++) {
+        now += FRAME_US + (f % 2 ? 2000 : -2000);
+        jitter_buffer_push_at(jb, in, JITTER_FRAME_SAMPLES, now);
+        jitter_buffer_pull(jb, out);
+    }
+    now += 60000000;
+    for (int f = 0; f < 3; f++) {
+        jitter_buffer_push_at(jb, in, JITTER_FRAME_SAMPLES, now);
+        jitter_buffer_pull(jb, out);
+        now += FRAME_US;
+    }
+    jitter_buffer_get_stats(jb, &st);
+    CHECK(st.target_ms < 30.0f, "jitter buffer target %.1f ms after a 60 s gap", st.target_ms);
+
+    jitter_buffer_reset(jb);
+    jitter_buffer_get_stats(jb, &st);
+    CHECK(st.jitter_ms == 0.0f, "jitter estimate %.2f ms after reset", st.jitter_ms);
+
+    jitter_buffer_destroy(jb);
+    audio_ring_destroy(ring);
+    printf("%s  jitter buffer across a talk spurt gap\n", failures == before ? "ok   " : "FAIL ");
+}
+
+// Part 2: pipeline
+
+typedef enum {
+    VEC_NOISE,                         // No training sequence: detector must stay quiet
+    VEC_RAW_CONTROL,                   // Uncoded PDU at bit 0 (lab transmitters)
+    VEC_CODED_CONTROL,                 // SCH/HD block after the training sequence
+    VEC_VOICE                          // TEA1-encrypted codec frame at bit 0
+} vector_kind_t;
+
+typedef struct {
+    const char *name;
+    vector_kind_t kind;
+    int bursts;
+    int sync_offset;                   // Training sequence position in bits
+    uint32_t seed;
+} vector_t;
+
+static const vector_t VECTORS[] = {
+    { "noise",         VEC_NOISE,         3, 0,   0x00C0FFEE },
+    { "raw_control",   VEC_RAW_CONTROL,   6, 200, 0x0BADF00D },
+    { "coded_control", VEC_CODED_CONTROL, 6, 40,  0x5EED1234 },
+    { "voice",         VEC_VOICE,         6, 300, 0x00FACADE },
+};
+
+#define TEST_MCC 204
+#define TEST_MNC 1337
+#define TEST_CC 1
+
+typedef struct {
+    char *lines[MAX_LINES];
+    int count;
+} transcript_t;
+
+static void emit(transcript_t *t, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void emit(transcript_t *t, const char *fmt, ...) {
+    if (t->count >= MAX_LINES) return;
+
+    char line[2048];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    t->lines[t->count++] = strdup(line);
+}
+
+// A 64-bit PDU header the decoder accepts
+static void make_pdu(uint8_t *bits, ctrl_message_t *msg) {
+    for (;;) {
+        for (int b = 0; b < 64; b++) {
+            bits[b] = (uint8_t)(rng_next() & 1);
+        }
+        if (decode_control_channel_data(bits, 64, msg)) return;
+    }
+}
+
+// Burst content for one vector entry
+static void make_burst(const vector_t *v, const lower_mac_t *mac, uint8_t *bits) {
+    for (int b = 0; b < TETRA_BURST_LENGTH; b++) {
+        bits[b] = (uint8_t)(rng_next() & 1);
+    }
+
+    ctrl_message_t msg;
+    switch (v->kind) {
+        case VEC_NOISE:
+            // Break up any accidental training sequence match
+            for (int b = 0; b < TETRA_BURST_LENGTH; b += 4) bits[b] = 0;
+            return;
+        case VEC_RAW_CONTROL:
+            make_pdu(bits, &msg);
+            break;
+        case VEC_CODED_CONTROL: {
+            uint8_t type1[LMAC_MAX_TYPE1_BITS];
+            memset(type1, 0, sizeof(type1));
+            make_pdu(type1, &msg);
+            lower_mac_encode(mac, LMAC_CHAN_SCH_HD, type1,
+                             bits + v->sync_offset + TETRA_TRAINING_SEQ_BITS);
+            break;
+        }
+        case VEC_VOICE:
+            break;
+    }
+    memcpy(bits + v->sync_offset, TRAINING_SEQ, TETRA_TRAINING_SEQ_BITS);
+}
+
+// Frequency-shift the bits into one SDR buffer, each symbol centred on the
+// demodulator's sampling instant, with a little deterministic noise
+static void modulate(const uint8_t *bits, uint8_t *iq) {
+    float phase = 0.0f;
+    for (int n = 0; n < SDR_BUFFER_SIZE / 2; n++) {
+        int sym = (n + SYMBOL_SAMPLES / 2) / SYMBOL_SAMPLES;
+        float dir = sym < TETRA_BURST_LENGTH ? (bits[sym] ? 1.0f : -1.0f) : 0.0f;
+        phase += dir * FM_DEVIATION;
+        if (phase > (float)M_PI) phase -= 2.0f * (float)M_PI;
+        if (phase < -(float)M_PI) phase += 2.0f * (float)M_PI;
+
+        int ni = (int)(rng_next() % 5) - 2;
+        int nq = (int)(rng_next() % 5) - 2;
+        iq[2 * n] = (uint8_t)lrintf(127.5f + 60.0f * cosf(phase) + (float)ni);
+        iq[2 * n + 1] = (uint8_t)lrintf(127.5f + 60.0f * sinf(phase) + (float)nq);
+    }
+}
+
+static void run_pipeline(transcript_t *t) {
+    uint8_t *iq = malloc(SDR_BUFFER_SIZE);
+    uint8_t bits[TETRA_BURST_LENGTH];
+    uint8_t key[TEA1_KEY_SIZE] = {0};
+
+    for (size_t vi = 0; vi < sizeof(VECTORS) / sizeof(VECTORS[0]); vi++) {
+        const vector_t *v = &VECTORS[vi];
+        tetra_demod_t *demod = tetra_demod_init(TETRA_SAMPLE_RATE, NULL, NULL, 15.0f);
+        tetra_codec_t *codec = tetra_codec_init();
+        tea1_context_t tea1;
+        lower_mac_t mac;
+        tea1_init(&tea1, key, true);
+        lower_mac_init(&mac, TEST_MCC, TEST_MNC, TEST_CC);
+
+        emit(t, "vector %s", v->name);
+        rng_state = v->seed;
+
+        for (int k = 0; k < v->bursts; k++) {
+            make_burst(v, &mac, bits);
+            modulate(bits, iq);
+
+            if (tetra_demod_process(demod, iq, SDR_BUFFER_SIZE) <= 0 || !tetra_detect_burst(demod)) {
+                emit(t, "none %d", k);
+                continue;
+            }
+
+            char hex[TETRA_BURST_LENGTH / 4 + 2];
+            int h = 0;
+            for (int b = 0; b < demod->bit_count; b += 4) {
+                int nib = 0;
+                for (int j = 0; j < 4; j++) {
+                    nib = nib << 1 | (b + j < demod->bit_count ? demod->demod_bits[b + j] : 0);
+                }
+                hex[h++] = "0123456789abcdef"[nib];
+            }
+            hex[h] = '\0';
+            emit(t, "burst %d sync=%d n=%d corr=%.4f power=%.4f bits=%s", k, demod->sync_offset,
+                 demod->bit_count, demod->sync_correlation, demod->signal_power, hex);
+
+            ctrl_message_t msg;
+            if (v->kind != VEC_VOICE &&
+                decode_control_burst(&mac, v->kind == VEC_RAW_CONTROL, demod->demod_bits,
+                                     demod->bit_count, demod->sync_offset, &msg)) {
+                emit(t, "ctrl %d %s tg=%u src=%u dst=%u freq=%u enc=%d emer=%d", k,
+                     ctrl_msg_type_to_string(msg.type), msg.talk_group_id, msg.source_id,
+                     msg.dest_id, msg.channel_freq, msg.encrypted, msg.emergency);
+            }
+
+            if (v->kind == VEC_VOICE && demod->bit_count >= TETRA_CODEC_FRAME_SIZE) {
+                uint8_t enc[TETRA_CODEC_FRAME_BYTES] = {0};
+                uint8_t dec[TETRA_CODEC_FRAME_BYTES];
+                int16_t pcm[TETRA_CODEC_SAMPLES];
+                for (int b = 0; b < TETRA_CODEC_FRAME_SIZE; b++) {
+                    enc[b >> 3] |= (uint8_t)(demod->demod_bits[b] << (7 - (b & 7)));
+                }
+                tea1_decrypt_stream(&tea1, enc, dec, sizeof(enc));
+                tetra_codec_decode_frame(codec, dec, pcm);
+
+                char line[TETRA_CODEC_SAMPLES * 8];
+                int n = 0;
+                for (int s = 0; s < TETRA_CODEC_SAMPLES; s++) {
+                    n += snprintf(line + n, sizeof(line) - (size_t)n, " %d", pcm[s]);
+                }
+                emit(t, "pcm %d%s", k, line);
+            }
+        }
+
+        tetra_codec_cleanup(codec);
+        tetra_demod_cleanup(demod);
+    }
+    free(iq);
+}
+
+// Next space-separated token at *s, which is advanced past it; NULL at the end
+static const char* next_token(const char **s, size_t *len) {
+    const char *p = *s + strspn(*s, " ");
+    if (!*p) return NULL;
+
+    *len = strcspn(p, " ");
+    *s = p + *len;
+    return p;
+}
+
+static bool token_is(const char *tok, size_t len, const char *prefix) {
+    size_t n = strlen(prefix);
+    return len >= n && strncmp(tok, prefix, n) == 0;
+}
+
+// Compare one transcript line with its golden counterpart, token by token.
+// Tokens are compared in place, so lines of any length are checked in full
+static bool lines_match(const char *got, const char *want) {
+    if (strcmp(got, want) == 0) return true;
+
+    bool pcm = strncmp(got, "pcm ", 4) == 0;
+    size_t la = 0, lb = 0;
+    const char *ta = next_token(&got, &la);
+    const char *tb = next_token(&want, &lb);
+    for (int i = 0; ta || tb; i++) {
+        if (!ta || !tb) return false;
+
+        // atoi/atof stop at the space ending the token
+        if (pcm && i >= 2) {
+            if (abs(atoi(ta) - atoi(tb)) > PCM_TOLERANCE) return false;
+        } else if (token_is(ta, la, "corr=") && token_is(tb, lb, "corr=")) {
+            if (!close_rel(atof(ta + 5), atof(tb + 5), MEASURE_TOLERANCE)) return false;
+        } else if (token_is(ta, la, "power=") && token_is(tb, lb, "power=")) {
+            if (!close_rel(atof(ta + 6), atof(tb + 6), MEASURE_TOLERANCE)) return false;
+        } else if (la != lb || memcmp(ta, tb, la) != 0) {
+            return false;
+        }
+
+        ta = next_token(&got, &la);
+        tb = next_token(&want, &lb);
+    }
+    return true;
+}
+
+static int write_golden(const char *path, const transcript_t *t) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        printf("FAIL: cannot write %s\n", path);
+        return 1;
+    }
+    fprintf(f, "# Golden pipeline transcript - regenerate with: test_golden --update %s\n", path);
+    for (int i = 0; i < t->count; i++) {
+        fprintf(f, "%s\n", t->lines[i]);
+    }
+    fclose(f);
+    printf("wrote %d lines to %s\n", t->count, path);
+    return 0;
+}
+
+static void compare_golden(const char *path, const transcript_t *t, dsp_path_t dsp) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        CHECK(false, "cannot read %s", path);
+        return;
+    }
+
+    static char line[8192];
+    int i = 0;
+    int before = failures;
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
+
+        if (i >= t->count) {
+            CHECK(false, "pipeline ended early; golden line %d: %.60s", i + 1, line);
+            break;
+        }
+        CHECK(lines_match(t->lines[i], line), "line %d\n  got:  %.100s\n  want: %.100s", i + 1,
+              t->lines[i], line);
+        i++;
+    }
+    fclose(f);
+    CHECK(i == t->count, "pipeline produced %d lines, golden has %d", t->count, i);
+
+    printf("%s  pipeline transcript, %s DSP (%d lines)\n", failures == before ? "ok   " : "FAIL ",
+           dsp_path_name(dsp), i);
+}
+
+int main(int argc, char **argv) {
+    bool update = argc > 2 && strcmp(argv[1], "--update") == 0;
+    const char *path = argv[argc - 1];
+    if (argc < 2 || (argc > 2 && !update)) {
+        printf("Usage: %s [--update] GOLDEN_FILE\n", argv[0]);
+        return 2;
+    }
+
+    log_set_level(LOG_LEVEL_WARN);
+
+    // The golden file is the float path's; Q15 must reproduce it within the same tolerances
+    transcript_t transcript[DSP_PATH_COUNT] = { { .count = 0 } };
+    for (int dsp = 0; dsp < DSP_PATH_COUNT; dsp++) {
+        dsp_set_path((dsp_path_t)dsp);
+        run_pipeline(&transcript[dsp]);
+    }
+    if (update) {
+        return write_golden(path, &transcript[DSP_PATH_FLOAT]);
+    }
+
+    test_kernels();
+    test_dsp_kernels();
+    test_viterbi_variants();
+    test_codec_batch();
+    test_jitter_buffer();
+    for (int dsp = 0; dsp < DSP_PATH_COUNT; dsp++) {
+        compare_golden(path, &transcript[dsp], (dsp_path_t)dsp);
+        for (int i = 0; i < transcript[dsp].count; i++) {
+            free(transcript[dsp].lines[i]);
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,396 @@
+/*
+ * Storage Format Tests
+ * Compressed audio archive and raw burst capture, written and read back
+ *
+ * The archive must reproduce its input exactly (noise, full-scale square,
+ * silence), seek to the exact sample, and rescan a file cut short before
+ * its seek table. The capture must return every burst's bits, answer time
+ * and frequency queries, append across sessions, and refuse entries that a
+ * truncated or corrupt file points outside the data.
+ */
+
+#include "tetra_analyzer.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_RATE 8000
+#define TEST_START_US 1700000000000000ULL
+#define TEST_SAMPLES (3 * ARCHIVE_BLOCK_SAMPLES + 1234)  // Partial last block
+#define TEST_CHUNK 1000                // Writes straddle block boundaries
+#define TEST_BURSTS 1000               // Several writer batches
+#define TEST_PATH_MAX 512
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static char g_dir[TEST_PATH_MAX];
+
+static void test_path(char *path, const char *name) {
+    if (snprintf(path, TEST_PATH_MAX, "%s/%s", g_dir, name) >= TEST_PATH_MAX) {
+        fprintf(stderr, "Test directory path too long: %s\n", g_dir);
+        exit(1);
+    }
+}
+
+static off_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : -1;
+}
+
+// Part 1: audio archive
+
+typedef enum {
+    SIGNAL_NOISE,
+    SIGNAL_SQUARE,
+    SIGNAL_SILENCE,
+    SIGNAL_COUNT
+} test_signal_t;
+
+static const char *SIGNAL_NAMES[SIGNAL_COUNT] = { "noise", "square", "silence" };
+
+static void make_signal(test_signal_t signal, int16_t *x, int n) {
+    rng_state = 0x13579BDF;
+    for (int i = 0; i < n; i++) {
+        switch (signal) {
+            case SIGNAL_NOISE:
+                x[i] = (int16_t)rng_next();
+                break;
+            case SIGNAL_SQUARE:
+                // Rail to rail: the largest residuals a predictor can see
+                x[i] = (i / 37) % 2 ? -32768 : 32767;
+                break;
+            default:
+                x[i] = 0;
+                break;
+        }
+    }
+}
+
+static int write_archive(const char *path, const int16_t *x, int n) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    audio_archive_t *ar = audio_archive_create(fd, TEST_RATE, TEST_START_US);
+    if (!ar) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < n; i += TEST_CHUNK) {
+        int count = n - i < TEST_CHUNK ? n - i : TEST_CHUNK;
+        if (audio_archive_write(ar, x + i, count) != count) ret = -1;
+    }
+    if (audio_archive_close(ar) < 0) ret = -1;
+    close(fd);
+    return ret;
+}
+
+static void test_archive_round_trip(test_signal_t signal) {
+    static int16_t x[TEST_SAMPLES], y[TEST_SAMPLES + 1];
+    char path[TEST_PATH_MAX];
+    test_path(path, "round_trip.tca");
+    make_signal(signal, x, TEST_SAMPLES);
+
+    CHECK(write_archive(path, x, TEST_SAMPLES) == 0, "%s: archive write failed", SIGNAL_NAMES[signal]);
+    audio_archive_reader_t *rd = audio_archive_open(path);
+    CHECK(rd != NULL, "%s: archive open failed", SIGNAL_NAMES[signal]);
+    if (!rd) return;
+
+    CHECK(audio_archive_sample_rate(rd) == TEST_RATE, "%s: sample rate %d", SIGNAL_NAMES[signal],
+          audio_archive_sample_rate(rd));
+    CHECK(audio_archive_start_time(rd) == TEST_START_US, "%s: start time differs", SIGNAL_NAMES[signal]);
+    CHECK(audio_archive_total_samples(rd) == TEST_SAMPLES, "%s: %llu samples, want %d",
+          SIGNAL_NAMES[signal], (unsigned long long)audio_archive_total_samples(rd), TEST_SAMPLES);
+
+    int got = audio_archive_read(rd, y, TEST_SAMPLES + 1);
+    CHECK(got == TEST_SAMPLES, "%s: read %d samples, want %d", SIGNAL_NAMES[signal], got, TEST_SAMPLES);
+    CHECK(memcmp(x, y, sizeof(x)) == 0, "%s: decoded samples differ", SIGNAL_NAMES[signal]);
+
+    // Silence codes at a bit a sample: better than 10:1 with headers and table
+    if (signal == SIGNAL_SILENCE) {
+        off_t size = file_size(path);
+        CHECK(size > 0 && size * 10 < TEST_SAMPLES * (off_t)sizeof(int16_t), "silence: %lld bytes",
+              (long long)size);
+    }
+
+    audio_archive_reader_close(rd);
+}
+
+static void test_archive_seek(void) {
+    static int16_t x[TEST_SAMPLES];
+    char path[TEST_PATH_MAX];
+    test_path(path, "seek.tca");
+    make_signal(SIGNAL_NOISE, x, TEST_SAMPLES);
+
+    CHECK(write_archive(path, x, TEST_SAMPLES) == 0, "seek: archive write failed");
+    audio_archive_reader_t *rd = audio_archive_open(path);
+    CHECK(rd != NULL, "seek: archive open failed");
+    if (!rd) return;
+
+    // Block edges from both sides, mid-block, and the last sample
+    const uint64_t targets[] = {
+        0, 1, ARCHIVE_BLOCK_SAMPLES - 1, ARCHIVE_BLOCK_SAMPLES, ARCHIVE_BLOCK_SAMPLES + 1,
+        2 * ARCHIVE_BLOCK_SAMPLES + 777, 3 * ARCHIVE_BLOCK_SAMPLES, TEST_SAMPLES - 1, 5,
+    };
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++) {
+        uint64_t s = targets[t];
+        int16_t y[16];
+        int want = TEST_SAMPLES - s < 16 ? (int)(TEST_SAMPLES - s) : 16;
+        CHECK(audio_archive_seek(rd, s) == 0, "seek to %llu failed", (unsigned long long)s);
+        int got = audio_archive_read(rd, y, 16);
+        CHECK(got == want && memcmp(y, x + s, (size_t)want * sizeof(int16_t)) == 0,
+              "seek to %llu: read %d samples, or wrong ones", (unsigned long long)s, got);
+    }
+
+    // 125 us per sample at 8 kHz, so these times fall exactly on samples
+    uint64_t s = 2 * ARCHIVE_BLOCK_SAMPLES + 3;
+    int16_t y;
+    CHECK(audio_archive_seek_time(rd, TEST_START_US + s * 125) == 0 && audio_archive_read(rd, &y, 1) == 1 &&
+          y == x[s], "seek_time to sample %llu", (unsigned long long)s);
+
+    CHECK(audio_archive_seek(rd, TEST_SAMPLES) < 0, "seek past the end accepted");
+    CHECK(audio_archive_seek_time(rd, TEST_START_US - 1) < 0, "seek before the start accepted");
+    audio_archive_reader_close(rd);
+}
+
+// A recording cut short never got its seek table: the reader rebuilds it
+// from the block headers and returns every complete block
+static void test_archive_rescan(void) {
+    static int16_t x[TEST_SAMPLES], y[TEST_SAMPLES];
+    char path[TEST_PATH_MAX];
+    test_path(path, "truncated.tca");
+    make_signal(SIGNAL_NOISE, x, TEST_SAMPLES);
+
+    CHECK(write_archive(path, x, TEST_SAMPLES) == 0, "rescan: archive write failed");
+
+    // Drop the seek table and the last byte of the final block
+    int blocks = (TEST_SAMPLES + ARCHIVE_BLOCK_SAMPLES - 1) / ARCHIVE_BLOCK_SAMPLES;
+    off_t size = file_size(path);
+    CHECK(size > 0 && truncate(path, size - (8 + 16 * blocks) - 1) == 0, "rescan: truncate failed");
+
+    audio_archive_reader_t *rd = audio_archive_open(path);
+    CHECK(rd != NULL, "rescan: archive open failed");
+    if (!rd) return;
+
+    uint64_t complete = (uint64_t)(blocks - 1) * ARCHIVE_BLOCK_SAMPLES;
+    CHECK(audio_archive_total_samples(rd) == complete, "rescan: %llu samples, want %llu",
+          (unsigned long long)audio_archive_total_samples(rd), (unsigned long long)complete);
+    int got = audio_archive_read(rd, y, TEST_SAMPLES);
+    CHECK(got == (int)complete && memcmp(x, y, complete * sizeof(int16_t)) == 0,
+          "rescan: read %d samples, or wrong ones", got);
+
+    // The rebuilt table seeks like the stored one
+    uint64_t s = ARCHIVE_BLOCK_SAMPLES + 100;
+    int16_t v;
+    CHECK(audio_archive_seek(rd, s) == 0 && audio_archive_read(rd, &v, 1) == 1 && v == x[s],
+          "rescan: seek to %llu", (unsigned long long)s);
+    audio_archive_reader_close(rd);
+}
+
+// Part 2: burst capture
+
+static uint8_t burst_bit(uint64_t n, int k) {
+    return (uint8_t)(((n * 2654435761u) >> (k % 29)) & 1);
+}
+
+static void make_burst(uint64_t n, burst_index_entry_t *meta, uint8_t *bits, int8_t *soft) {
+    memset(meta, 0, sizeof(*meta));
+    meta->timestamp_us = TEST_START_US + n * 14167;   // One TETRA slot apart
+    meta->frequency = n % 3 ? 390012500 : 390037500;
+    meta->talk_group = (uint32_t)(n % 5);
+    meta->sync_offset = (int32_t)(n % 100);
+    meta->bit_count = (uint16_t)(TETRA_BURST_LENGTH - n % 7);
+    for (int k = 0; k < meta->bit_count; k++) {
+        bits[k] = burst_bit(n, k);
+        soft[k] = (int8_t)(bits[k] ? 64 + k % 63 : -64 - k % 63);
+    }
+}
+
+static int write_bursts(burst_capture_t *cap, uint64_t first, uint64_t count) {
+    uint8_t bits[TETRA_BURST_LENGTH];
+    int8_t soft[TETRA_BURST_LENGTH];
+    int ret = 0;
+    for (uint64_t n = first; n < first + count; n++) {
+        burst_index_entry_t meta;
+        make_burst(n, &meta, bits, soft);
+        // Soft bits on every other burst: both record layouts interleaved
+        if (burst_capture_write(cap, &meta, bits, n % 2 ? soft : NULL) < 0) ret = -1;
+    }
+    return ret;
+}
+
+// Every stored burst is the one written at its position
+static bool check_bursts(const burst_index_t *idx, uint64_t count) {
+    uint8_t bits[TETRA_BURST_LENGTH], want[TETRA_BURST_LENGTH];
+    int8_t soft[TETRA_BURST_LENGTH], want_soft[TETRA_BURST_LENGTH];
+
+    for (uint64_t n = 0; n < count; n++) {
+        burst_index_entry_t meta;
+        make_burst(n, &meta, want, want_soft);
+        const burst_index_entry_t *e = burst_index_entry(idx, n);
+        int soft_count = burst_index_soft(idx, n, soft);
+        bool ok = e && e->timestamp_us == meta.timestamp_us && e->frequency == meta.frequency &&
+                  e->talk_group == meta.talk_group &&
+                  burst_index_bits(idx, n, bits) == meta.bit_count &&
+                  memcmp(bits, want, meta.bit_count) == 0 &&
+                  (n % 2 ? soft_count == meta.bit_count && memcmp(soft, want_soft, meta.bit_count) == 0
+                         : soft_count == 0);
+        if (!ok) {
+            CHECK(ok, "capture: burst %llu differs", (unsigned long long)n);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_capture_round_trip(void) {
+    char prefix[TEST_PATH_MAX];
+    test_path(prefix, "capture");
+
+    // Two sessions: the second appends
+    burst_capture_t *cap = burst_capture_create(prefix);
+    CHECK(cap != NULL, "capture: create failed");
+    if (!cap) return;
+    CHECK(write_bursts(cap, 0, TEST_BURSTS / 2) == 0, "capture: write failed");
+    burst_capture_close(cap);
+
+    cap = burst_capture_open(prefix);
+    CHECK(cap != NULL && burst_capture_count(cap) == TEST_BURSTS / 2, "capture: reopen count");
+    if (!cap) return;
+    CHECK(write_bursts(cap, TEST_BURSTS / 2, TEST_BURSTS / 2) == 0, "capture: append failed");
+    burst_capture_close(cap);
+
+    burst_index_t *idx = burst_index_open(prefix);
+    CHECK(idx != NULL, "capture: index open failed");
+    if (!idx) return;
+    CHECK(burst_index_count(idx) == TEST_BURSTS, "capture: %llu bursts, want %d",
+          (unsigned long long)burst_index_count(idx), TEST_BURSTS);
+    check_bursts(idx, TEST_BURSTS);
+
+    // Time lookup lands on the first burst at or after the time
+    uint64_t n = 321;
+    CHECK(burst_index_find_time(idx, TEST_START_US + n * 14167) == n, "capture: find_time exact");
+    CHECK(burst_index_find_time(idx, TEST_START_US + n * 14167 + 1) == n + 1, "capture: find_time between");
+
+    // Frequency and talk group filters within a time window
+    burst_query_t query = { .start_us = TEST_START_US + 100 * 14167, .end_us = TEST_START_US + 200 * 14167,
+                            .frequency = 390037500, .talk_group = 2 };
+    int matches = 0;
+    for (int64_t i = burst_index_next(idx, &query, 0); i >= 0; i = burst_index_next(idx, &query, (uint64_t)i + 1)) {
+        CHECK(i >= 100 && i < 200 && i % 3 == 0 && i % 5 == 2, "capture: query matched burst %lld", (long long)i);
+        matches++;
+    }
+    CHECK(matches == 7, "capture: query matched %d bursts, want 7", matches);
+    burst_index_close(idx);
+
+    // Creating again starts over
+    cap = burst_capture_create(prefix);
+    CHECK(cap != NULL && burst_capture_count(cap) == 0, "capture: create kept old bursts");
+    burst_capture_close(cap);
+}
+
+static void test_capture_damaged(void) {
+    char prefix[TEST_PATH_MAX], data[TEST_PATH_MAX], index[TEST_PATH_MAX];
+    test_path(prefix, "damaged");
+    test_path(data, "damaged.tbc");
+    test_path(index, "damaged.tbi");
+
+    burst_capture_t *cap = burst_capture_create(prefix);
+    CHECK(cap != NULL, "damaged: create failed");
+    if (!cap) return;
+    write_bursts(cap, 0, 10);
+    burst_capture_close(cap);
+
+    // Data cut inside the last record: its index entry is dropped
+    off_t size = file_size(data);
+    CHECK(size > 0 && truncate(data, size - 1) == 0, "damaged: truncate failed");
+    burst_index_t *idx = burst_index_open(prefix);
+    CHECK(idx && burst_index_count(idx) == 9, "damaged: %llu bursts after truncation, want 9",
+          (unsigned long long)burst_index_count(idx));
+    if (idx) check_bursts(idx, 9);
+    burst_index_close(idx);
+
+    // An entry pointing outside the data is refused, its neighbours still read
+    uint64_t bad = (uint64_t)1 << 40;
+    int fd = open(index, O_WRONLY | O_CLOEXEC);
+    CHECK(fd >= 0 && pwrite(fd, &bad, sizeof(bad), 16 + 3 * sizeof(burst_index_entry_t) +
+                            offsetof(burst_index_entry_t, data_offset)) == (ssize_t)sizeof(bad),
+          "damaged: patch failed");
+    if (fd >= 0) close(fd);
+
+    idx = burst_index_open(prefix);
+    uint8_t bits[TETRA_BURST_LENGTH];
+    int8_t soft[TETRA_BURST_LENGTH];
+    CHECK(idx && burst_index_bits(idx, 3, bits) < 0 && burst_index_soft(idx, 3, soft) < 0,
+          "damaged: corrupt entry read");
+    CHECK(idx && burst_index_bits(idx, 4, bits) > 0, "damaged: entry after the corrupt one lost");
+    burst_index_close(idx);
+}
+
+static void remove_files(void) {
+    static const char *names[] = {
+        "round_trip.tca", "seek.tca", "truncated.tca",
+        "capture.tbc", "capture.tbi", "damaged.tbc", "damaged.tbi",
+    };
+    char path[TEST_PATH_MAX];
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        test_path(path, names[i]);
+        unlink(path);
+    }
+    rmdir(g_dir);
+}
+
+int main(void) {
+    const char *tmp = getenv("TMPDIR");
+    snprintf(g_dir, sizeof(g_dir), "%s/tetra_storage_XXXXXX", tmp && *tmp ? tmp : "/tmp");
+    if (!mkdtemp(g_dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    log_set_level(LOG_LEVEL_WARN);
+
+    for (int s = 0; s < SIGNAL_COUNT; s++) {
+        int before = failures;
+        test_archive_round_trip((test_signal_t)s);
+        printf("%s  archive round trip (%s)\n", failures == before ? "ok   " : "FAIL ", SIGNAL_NAMES[s]);
+    }
+
+    int before = failures;
+    test_archive_seek();
+    printf("%s  archive seek\n", failures == before ? "ok   " : "FAIL ");
+
+    before = failures;
+    test_archive_rescan();
+    printf("%s  archive rescan\n", failures == before ? "ok   " : "FAIL ");
+
+    before = failures;
+    test_capture_round_trip();
+    printf("%s  burst capture round trip\n", failures == before ? "ok   " : "FAIL ");
+
+    before = failures;
+    test_capture_damaged();
+    printf("%s  burst capture damaged files\n", failures == before ? "ok   " : "FAIL ");
+
+    remove_files();
+    return failures ? 1 : 0;
+}
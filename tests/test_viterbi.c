@@ -0,0 +1,101 @@
+/*
+ * Viterbi Decoder Tests
+ * Every available SIMD variant must be bit-exact against the scalar reference
+ */
+
+#include "tetra_analyzer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_BLOCKS 257                // Odd count exercises the AVX2 pair tail
+#define TEST_STEPS LMAC_MAX_TYPE3_BITS
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL: " __VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Noiseless encode/decode round trip recovers the input
+static void test_round_trip(viterbi_impl_t impl) {
+    uint8_t bits[TEST_STEPS], coded[TEST_STEPS * VITERBI_CODE_RATE], decoded[TEST_STEPS];
+    int8_t soft[TEST_STEPS * VITERBI_CODE_RATE];
+
+    for (int i = 0; i < TEST_STEPS; i++) {
+        bits[i] = (i < TEST_STEPS - 4) ? (rng_next() & 1) : 0;
+    }
+    viterbi_encode(bits, TEST_STEPS, coded);
+    for (int i = 0; i < TEST_STEPS * VITERBI_CODE_RATE; i++) {
+        soft[i] = coded[i] ? 100 : -100;
+    }
+
+    int r = viterbi_decode_impl(impl, soft, TEST_STEPS, decoded);
+    CHECK(r == TEST_STEPS, "%s: decode returned %d", viterbi_impl_name(impl), r);
+    CHECK(memcmp(bits, decoded, TEST_STEPS) == 0, "%s: round trip mismatch",
+          viterbi_impl_name(impl));
+}
+
+// Random soft input (including saturated values and erasures) matches scalar
+static void test_bit_exact(viterbi_impl_t impl) {
+    static int8_t soft[TEST_BLOCKS * TEST_STEPS * VITERBI_CODE_RATE];
+    static uint8_t ref[TEST_BLOCKS * TEST_STEPS];
+    static uint8_t out[TEST_BLOCKS * TEST_STEPS];
+
+    for (size_t i = 0; i < sizeof(soft); i++) {
+        uint32_t r = rng_next();
+        soft[i] = (r & 0x700) == 0 ? 0 : (int8_t)(r & 0xFF);
+    }
+
+    for (int b = 0; b < TEST_BLOCKS; b++) {
+        viterbi_decode_impl(VITERBI_IMPL_SCALAR, soft + b * TEST_STEPS * VITERBI_CODE_RATE,
+                            TEST_STEPS, ref + b * TEST_STEPS);
+    }
+
+    memset(out, 0xFF, sizeof(out));
+    for (int b = 0; b < TEST_BLOCKS; b++) {
+        viterbi_decode_impl(impl, soft + b * TEST_STEPS * VITERBI_CODE_RATE,
+                            TEST_STEPS, out + b * TEST_STEPS);
+    }
+    CHECK(memcmp(ref, out, sizeof(ref)) == 0, "%s: single-block output differs from scalar",
+          viterbi_impl_name(impl));
+
+    memset(out, 0xFF, sizeof(out));
+    int r = viterbi_decode_batch_impl(impl, soft, TEST_STEPS, out, TEST_BLOCKS);
+    CHECK(r == TEST_BLOCKS, "%s: batch returned %d", viterbi_impl_name(impl), r);
+    CHECK(memcmp(ref, out, sizeof(ref)) == 0, "%s: batch output differs from scalar",
+          viterbi_impl_name(impl));
+}
+
+int main(void) {
+    for (int impl = VITERBI_IMPL_SCALAR; impl < VITERBI_IMPL_COUNT; impl++) {
+        if (!viterbi_impl_available((viterbi_impl_t)impl)) {
+            printf("skip  %s (not supported on this CPU)\n", viterbi_impl_name((viterbi_impl_t)impl));
+            continue;
+        }
+
+        int before = failures;
+        test_round_trip((viterbi_impl_t)impl);
+        test_bit_exact((viterbi_impl_t)impl);
+        printf("%s  %s\n", failures == before ? "ok   " : "FAIL ",
+               viterbi_impl_name((viterbi_impl_t)impl));
+    }
+
+    CHECK(viterbi_decode(NULL, 10, NULL) < 0, "NULL input accepted");
+    CHECK(viterbi_set_impl(VITERBI_IMPL_AUTO) == 0, "auto selection failed");
+
+    return failures ? 1 : 0;
+}